@@ -0,0 +1,248 @@
+// 基于刻字机模拟器的性能基准: npm run bench -- [--quick] [--out result.json] [--baseline old.json] [--tolerance 0.2]
+// 结果以 JSON 写到 stdout (或 --out 指定的文件), 过程信息写到 stderr.
+// 指定 --baseline 时与之前的结果比较, 任何指标变差超过 tolerance 则以退出码 1 结束.
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const addon = require('bindings')('usb_addon');
+
+if (!addon.CutterEmulator) {
+  console.error('当前平台没有 CutterEmulator, 跳过基准测试');
+  process.exit(0);
+}
+
+const args = process.argv.slice(2);
+const option = (name, fallback) => {
+  const index = args.indexOf(name);
+  return index >= 0 && index + 1 < args.length ? args[index + 1] : fallback;
+};
+const quick = args.includes('--quick');
+const outFile = option('--out', null);
+const baselineFile = option('--baseline', null);
+const tolerance = Number(option('--tolerance', '0.2'));
+
+const emptyUevents = path.join(os.tmpdir(), `usb-addon-bench-uevents-${process.pid}`);
+fs.writeFileSync(emptyUevents, '');
+
+const log = (...values) => console.error(...values);
+
+function makeJob(size) {
+  const parts = ['IN;'];
+  let length = 3;
+  for (let i = 0; length < size - 4; i++) {
+    const command = `PD${i % 4000},${(i * 7) % 4000};`;
+    parts.push(command);
+    length += command.length;
+  }
+  parts.push('PG;@');
+  return Buffer.from(parts.join(''));
+}
+
+function percentiles(samples) {
+  const sorted = Float64Array.from(samples).sort();
+  const at = (q) => sorted[Math.min(sorted.length - 1, Math.floor(q * sorted.length))];
+  const mean = sorted.reduce((sum, value) => sum + value, 0) / sorted.length;
+  return { count: sorted.length, mean, p50: at(0.5), p90: at(0.9), p99: at(0.99), max: sorted[sorted.length - 1] };
+}
+
+const median = (values) => percentiles(values).p50;
+
+async function withDevice(options, fn) {
+  const emulator = new addon.CutterEmulator(options);
+  const device = new addon.UsbDevice();
+  try {
+    if (!device.connectPath(emulator.getPath())) {
+      throw new Error(`无法连接模拟器 ${emulator.getPath()}`);
+    }
+    return await fn(device, emulator);
+  } finally {
+    device.disconnect();
+    emulator.close();
+  }
+}
+
+// sendCmdAsync 往返延迟 (微秒): 串行发送, 以及 depth 条同时在途
+async function benchCommands(depth) {
+  const count = quick ? 500 : 5000;
+  return withDevice({}, async (device) => {
+    const command = Buffer.from('BD:36;');
+    for (let i = 0; i < 50; i++) {
+      await device.sendCmdAsync(command, { timeout: 1000 });
+    }
+    device.resetStats();
+
+    const samples = [];
+    const start = process.hrtime.bigint();
+    let sent = 0;
+    const worker = async () => {
+      while (sent < count) {
+        sent++;
+        const begin = process.hrtime.bigint();
+        await device.sendCmdAsync(command, { timeout: 1000 });
+        samples.push(Number(process.hrtime.bigint() - begin) / 1000);
+      }
+    };
+    await Promise.all(Array.from({ length: depth }, worker));
+    const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+
+    const native = device.getStats().roundTrip;
+    return {
+      depth,
+      commandsPerSecond: count / seconds,
+      jsLatencyUs: percentiles(samples),
+      nativeLatencyUs: { p50: native.p50, p90: native.p90, p99: native.p99, max: native.max }
+    };
+  });
+}
+
+// sendPltAsync 吞吐 (MB/s), 按作业大小
+async function benchPlt(size, bandwidth) {
+  const repeats = quick ? 3 : (size >= 4 * 1024 * 1024 ? 5 : 20);
+  const job = makeJob(size);
+  return withDevice({ bandwidth }, async (device) => {
+    const rates = [];
+    for (let i = 0; i < repeats; i++) {
+      const start = process.hrtime.bigint();
+      const reply = await device.sendPltAsync(job);
+      const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+      if (!reply || reply.toString() !== `JOB:${job.length};`) {
+        throw new Error(`作业回执不正确: ${reply}`);
+      }
+      rates.push(job.length / seconds / 1e6);
+    }
+    return { size: job.length, bandwidth, repeats, mbPerSecond: median(rates), bestMbPerSecond: Math.max(...rates) };
+  });
+}
+
+// 事件投递开销: startPlt 以最小分块和 progressInterval 0 产生尽可能多的 PROGRESS 事件
+async function benchEvents(batch) {
+  const job = makeJob(quick ? 1024 * 1024 : 8 * 1024 * 1024);
+  return withDevice({}, async (device) => {
+    let callbacks = 0;
+    let events = 0;
+    const done = new Promise((resolve, reject) => {
+      const onEvent = (type, data) => {
+        events++;
+        if (type === 'PROGRESS' && data.done) {
+          resolve();
+        } else if (type === 'ERROR') {
+          reject(new Error(data));
+        }
+      };
+      device.startHotplugMonitor((...values) => {
+        callbacks++;
+        if (batch) {
+          values[0].forEach((event) => onEvent(event.type, event.data));
+        } else {
+          onEvent(values[0], values[1]);
+        }
+      }, { ueventReplay: emptyUevents, batch });
+    });
+
+    const start = process.hrtime.bigint();
+    device.startPlt(job, { chunkSize: 256, progressInterval: 0 });
+    await done;
+    const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+    device.stopHotplugMonitor();
+
+    const stats = device.getEventStats();
+    return {
+      batch,
+      chunks: Math.ceil(job.length / 256),
+      events,
+      callbacks,
+      coalesced: stats.coalesced,
+      dropped: stats.dropped,
+      jsTurns: stats.batches,
+      seconds,
+      mbPerSecond: job.length / seconds / 1e6
+    };
+  });
+}
+
+// 与基线比较的指标: [路径, 越大越好]
+const METRICS = [
+  ['commands.serial.commandsPerSecond', true],
+  ['commands.pipelined.commandsPerSecond', true],
+  ['commands.serial.jsLatencyUs.p50', false],
+  ['commands.serial.jsLatencyUs.p99', false],
+  ['events.perEvent.mbPerSecond', true],
+  ['events.batched.mbPerSecond', true]
+];
+
+function lookup(object, keyPath) {
+  return keyPath.split('.').reduce((value, key) => (value == null ? undefined : value[key]), object);
+}
+
+function compare(result, baseline) {
+  const regressions = [];
+  const metrics = METRICS.slice();
+  result.plt.forEach((entry, i) => metrics.push([`plt.${i}.mbPerSecond`, true]));
+  for (const [keyPath, higherIsBetter] of metrics) {
+    const now = lookup(result, keyPath);
+    const before = lookup(baseline, keyPath);
+    if (typeof now !== 'number' || typeof before !== 'number' || before === 0) {
+      continue;
+    }
+    const change = (now - before) / before;
+    const worse = higherIsBetter ? change < -tolerance : change > tolerance;
+    log(`${worse ? '✗' : ' '} ${keyPath}: ${before.toFixed(1)} -> ${now.toFixed(1)} (${(change * 100).toFixed(1)}%)`);
+    if (worse) {
+      regressions.push({ metric: keyPath, before, now, change });
+    }
+  }
+  return regressions;
+}
+
+(async () => {
+  const result = {
+    node: process.version,
+    platform: process.platform,
+    arch: process.arch,
+    cpus: os.cpus().length,
+    cpuModel: (os.cpus()[0] || {}).model,
+    timestamp: new Date().toISOString(),
+    quick,
+    commands: {},
+    plt: [],
+    events: {}
+  };
+
+  log('sendCmdAsync 往返延迟...');
+  result.commands.serial = await benchCommands(1);
+  result.commands.pipelined = await benchCommands(8);
+
+  log('sendPltAsync 吞吐...');
+  const sizes = quick ? [4096, 64 * 1024, 1024 * 1024] : [4096, 64 * 1024, 1024 * 1024, 8 * 1024 * 1024];
+  for (const size of sizes) {
+    result.plt.push(await benchPlt(size, 0));
+  }
+  result.plt.push(await benchPlt(1024 * 1024, 2 * 1024 * 1024));
+
+  log('事件投递...');
+  result.events.perEvent = await benchEvents(false);
+  result.events.batched = await benchEvents(true);
+
+  fs.unlinkSync(emptyUevents);
+
+  const json = JSON.stringify(result, null, 2);
+  if (outFile) {
+    fs.writeFileSync(outFile, json + '\n');
+    log(`结果已写入 ${outFile}`);
+  } else {
+    process.stdout.write(json + '\n');
+  }
+
+  let exitCode = 0;
+  if (baselineFile) {
+    const regressions = compare(result, JSON.parse(fs.readFileSync(baselineFile, 'utf8')));
+    if (regressions.length > 0) {
+      log(`${regressions.length} 项指标变差超过 ${(tolerance * 100).toFixed(0)}%`);
+      exitCode = 1;
+    }
+  }
+  process.exit(exitCode);
+})().catch((error) => {
+  console.error(error);
+  process.exit(1);
+});
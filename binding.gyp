@@ -4,7 +4,30 @@
     "cflags!": [ "-fno-exceptions" ],
     "cflags_cc!": [ "-fno-exceptions" ],
     "sources": [ 
-      "src/usb_addon.cc"
+      "src/usb_addon.cc",
+      "src/plt_streamer.cc",
+      "src/flow_control.cc",
+      "src/command_mux.cc",
+      "src/write_scheduler.cc",
+      "src/device_index.cc",
+      "src/device_handoff.cc",
+      "src/device_profile.cc",
+      "src/profile_binding.cc",
+      "src/logger.cc",
+      "src/log_binding.cc",
+      "src/mapped_file.cc",
+      "src/job_cache.cc",
+      "src/job_cache_binding.cc",
+      "src/trace_file.cc",
+      "src/trace_replay.cc",
+      "src/trace_tools.cc",
+      "src/tracing_transport.cc",
+      "src/response_matcher.cc",
+      "src/plt_parser.cc",
+      "src/plt_builder.cc",
+      "src/plt_flatten.cc",
+      "src/plt_reorder.cc",
+      "src/plt_tools.cc"
     ],
     "include_dirs": [
       "<!@(node -p \"require('node-addon-api').include\")"
@@ -12,18 +35,31 @@
     'defines': [ 'NAPI_DISABLE_CPP_EXCEPTIONS' ],
     'conditions': [
       ['OS=="win"', {
+        'sources': [
+          'src/transport_win.cc'
+        ],
         'libraries': [ 
           '-lsetupapi.lib',
           '-lwinusb.lib'
         ]
+      }, {
+        'sources': [
+          'src/transport_posix.cc',
+          'src/cutter_emulator.cc',
+          'src/emulator_wrap.cc'
+        ]
+      }],
+      ['OS=="linux"', {
+        'sources': [
+          'src/device_reactor.cc',
+          'src/device_pool.cc',
+          'src/uevent_monitor.cc'
+        ]
       }]
     ],
     "dependencies": [
       "<!(node -p \"require('node-addon-api').gyp\")"
     ],
-    "libraries": [
-      "setupapi.lib"
-    ],
     "msvs_settings": {
       "VCCLCompilerTool": {
         "ExceptionHandling": 1
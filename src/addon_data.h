@@ -0,0 +1,24 @@
+#pragma once
+#include <napi.h>
+
+// 每个 JS 环境 (主线程和每个 worker_threads) 自己的模块状态
+// 模块在每个环境中各加载一次, 各自 DefineClass; 构造函数的引用属于定义它的环境,
+// 不能放在进程级的 static 中. 由 env.SetInstanceData 持有, 环境销毁时随之释放.
+// 进程级共享的只有与 JS 无关的部分: 设备索引、型号配置、缓冲池、日志和移交中的设备 (DeviceHandoff).
+struct AddonData {
+    Napi::FunctionReference usbDevice;
+    Napi::FunctionReference devicePool;
+    Napi::FunctionReference cutterEmulator;
+
+    // 模块初始化时创建, 之后在同一环境中总能取到
+    static AddonData &Get(Napi::Env env)
+    {
+        AddonData *data = env.GetInstanceData<AddonData>();
+        if (!data)
+        {
+            data = new AddonData();
+            env.SetInstanceData(data);
+        }
+        return *data;
+    }
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 响应缓冲区池
+// 设备响应直接读入池中的 vector, 再通过 Napi::Buffer::New + finalizer 交给 JS,
+// JS 回收 Buffer 时 vector 回到池中. 高频状态查询因此不需要复制, 也几乎不分配内存.
+class BufferPool {
+public:
+    explicit BufferPool(size_t maxPooled = 64, size_t maxCapacity = 1 << 20)
+        : maxPooled(maxPooled), maxCapacity(maxCapacity)
+    {
+    }
+
+    ~BufferPool()
+    {
+        for (auto buffer : pool)
+        {
+            delete buffer;
+        }
+    }
+
+    // 取出一个空的 vector, 容量至少为 reserve
+    std::vector<uint8_t>* Acquire(size_t reserve)
+    {
+        std::vector<uint8_t>* buffer = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!pool.empty())
+            {
+                buffer = pool.back();
+                pool.pop_back();
+            }
+        }
+
+        if (!buffer)
+        {
+            buffer = new std::vector<uint8_t>();
+        }
+        buffer->reserve(reserve);
+        return buffer;
+    }
+
+    // 归还 vector (可在任意线程调用); 容量超过上限的 (如生成的 PLT 作业) 直接释放, 不长期占用内存
+    void Release(std::vector<uint8_t>* buffer)
+    {
+        if (!buffer)
+        {
+            return;
+        }
+        if (buffer->capacity() > maxCapacity)
+        {
+            delete buffer;
+            return;
+        }
+
+        buffer->clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (pool.size() < maxPooled)
+            {
+                pool.push_back(buffer);
+                return;
+            }
+        }
+        delete buffer;
+    }
+
+    // 进程内共享的响应缓冲区池
+    static BufferPool& Shared()
+    {
+        static BufferPool shared;
+        return shared;
+    }
+
+private:
+    size_t maxPooled;
+    size_t maxCapacity;
+    std::mutex mutex;
+    std::vector<std::vector<uint8_t>*> pool;
+};
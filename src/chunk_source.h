@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+// PLT 作业的数据来源, 由发送线程按块拉取
+class ChunkSource {
+public:
+    virtual ~ChunkSource() = default;
+
+    // 作业总字节数 (用于计算进度)
+    virtual uint64_t Size() const = 0;
+
+    // 读取最多 length 字节到 dst, 返回 0 表示数据已读完
+    virtual size_t Read(uint8_t *dst, size_t length) = 0;
+
+    // 整个作业连续地在内存中时返回其起始地址, PltStreamer 直接从这里切块写入, 不经过环形缓冲区;
+    // 返回 nullptr 时改用 Read 拉取
+    virtual const uint8_t *Data() const
+    {
+        return nullptr;
+    }
+};
+
+// 内存中的作业数据
+class MemorySource : public ChunkSource {
+public:
+    MemorySource(const uint8_t *data, size_t length)
+        : bytes(data, data + length), offset(0)
+    {
+    }
+
+    uint64_t Size() const override
+    {
+        return bytes.size();
+    }
+
+    size_t Read(uint8_t *dst, size_t length) override
+    {
+        size_t remaining = bytes.size() - offset;
+        size_t n = length < remaining ? length : remaining;
+        memcpy(dst, bytes.data() + offset, n);
+        offset += n;
+        return n;
+    }
+
+    const uint8_t *Data() const override
+    {
+        return bytes.data();
+    }
+
+private:
+    std::vector<uint8_t> bytes;
+    size_t offset;
+};
+
+// 直接引用外部内存的作业数据 (不复制)
+// 例如被 Napi::Reference 固定的 JS Buffer; 析构时调用 release 解除固定
+class BorrowedSource : public ChunkSource {
+public:
+    BorrowedSource(const uint8_t *data, size_t length, std::function<void()> release)
+        : data(data), length(length), offset(0), release(std::move(release))
+    {
+    }
+
+    ~BorrowedSource() override
+    {
+        if (release)
+        {
+            release();
+        }
+    }
+
+    uint64_t Size() const override
+    {
+        return length;
+    }
+
+    size_t Read(uint8_t *dst, size_t max) override
+    {
+        size_t remaining = length - offset;
+        size_t n = max < remaining ? max : remaining;
+        memcpy(dst, data + offset, n);
+        offset += n;
+        return n;
+    }
+
+    const uint8_t *Data() const override
+    {
+        return data;
+    }
+
+private:
+    const uint8_t *data;
+    size_t length;
+    size_t offset;
+    std::function<void()> release;
+};
@@ -0,0 +1,226 @@
+#include "command_mux.h"
+#include "buffer_pool.h"
+#include <condition_variable>
+
+namespace {
+
+// 读线程单次读取的最大字节数
+const size_t READ_SIZE = 1024;
+
+// 没有请求在等待时, 读线程每次最多等待的时间 (也决定 Stop 的响应速度)
+const int IDLE_WAIT = 20;
+
+} // namespace
+
+CommandMux::CommandMux(Transport *transport, WriteScheduler &scheduler, IoStats *stats)
+    : transport(transport),
+      scheduler(scheduler),
+      stats(stats),
+      awaitingFirstByte(false),
+      running(false)
+{
+}
+
+CommandMux::~CommandMux()
+{
+    Stop();
+}
+
+void CommandMux::Start(UnsolicitedFn unsolicitedFn, ClosedFn closedFn)
+{
+    if (running)
+    {
+        return;
+    }
+
+    closed = std::move(closedFn);
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        matcher.SetUnsolicited(std::move(unsolicitedFn));
+    }
+    running = true;
+    reader = std::thread(&CommandMux::ReaderLoop, this);
+}
+
+void CommandMux::Stop()
+{
+    running = false;
+    if (reader.joinable())
+    {
+        reader.join();
+    }
+    FailAll(Result::CLOSED, "Device not connected");
+}
+
+void CommandMux::SetTerminator(uint8_t terminator)
+{
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    matcher.SetTerminator(terminator);
+}
+
+void CommandMux::Submit(const uint8_t *data, size_t length, int timeoutMs, Framing framing, Completion completion,
+                        Priority priority)
+{
+    if (!running)
+    {
+        completion(Result::CLOSED, nullptr, "Device not connected");
+        return;
+    }
+
+    // 持有写锁期间登记并写出, 保证等待队列的顺序与写入顺序一致
+    WriteScheduler::Guard writeLock(scheduler, priority);
+
+    Clock::time_point submitted = Clock::now();
+    if (stats)
+    {
+        // 往返时间从提交开始计算, 包含写入耗时
+        IoStats *ioStats = stats;
+        completion = [ioStats, submitted, completion](Result result, std::vector<uint8_t> *response, const std::string &error) {
+            if (result == Result::OK)
+            {
+                ioStats->roundTrip.Record(IoStats::MicrosSince(submitted));
+            }
+            else if (result == Result::TIMEOUT)
+            {
+                ioStats->timeouts++;
+            }
+            else
+            {
+                ioStats->errors++;
+            }
+            completion(result, response, error);
+        };
+    }
+
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        id = matcher.Register(framing, submitted + std::chrono::milliseconds(timeoutMs), std::move(completion),
+                              ResponseMatcher::EchoPrefix(data, length));
+    }
+
+    size_t bytesWritten = 0;
+    Clock::time_point writeStart = Clock::now();
+    IoStatus status = transport->Write(data, length, bytesWritten, WRITE_STALL_TIMEOUT);
+    if (stats)
+    {
+        stats->write.Record(IoStats::MicrosSince(writeStart));
+        stats->bytesOut += bytesWritten;
+    }
+
+    if (status == IoStatus::OK)
+    {
+        if (stats)
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            awaitingFirstByte = true;
+            lastWriteDone = Clock::now();
+        }
+        return;
+    }
+
+    // 写入失败: 撤销登记 (读线程可能已经把它匹配掉了)
+    Completion failed;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        failed = matcher.Cancel(id);
+    }
+
+    if (failed)
+    {
+        failed(Result::WRITE_FAILED, nullptr, "Failed to write data: " + std::to_string(transport->LastError()));
+    }
+}
+
+CommandMux::Result CommandMux::SubmitAndWait(const uint8_t *data, size_t length, int timeoutMs, Framing framing,
+                                             std::vector<uint8_t> &response, std::string &error, Priority priority)
+{
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    bool done = false;
+    Result result = Result::CLOSED;
+
+    Submit(data, length, timeoutMs, framing,
+           [&](Result r, std::vector<uint8_t> *frame, const std::string &message) {
+               std::lock_guard<std::mutex> lock(doneMutex);
+               result = r;
+               if (frame)
+               {
+                   response.swap(*frame);
+                   BufferPool::Shared().Release(frame);
+               }
+               error = message;
+               done = true;
+               doneCv.notify_one();
+           },
+           priority);
+
+    std::unique_lock<std::mutex> lock(doneMutex);
+    doneCv.wait(lock, [&] { return done; });
+    return result;
+}
+
+void CommandMux::ReaderLoop()
+{
+    uint8_t readBuffer[READ_SIZE];
+
+    while (running)
+    {
+        // 有请求在等待时, 最多等到最近的截止时间
+        int waitMs;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            waitMs = matcher.WaitMs(Clock::now(), IDLE_WAIT);
+        }
+
+        size_t bytesRead = 0;
+        IoStatus status = transport->Read(readBuffer, READ_SIZE, bytesRead, waitMs);
+
+        if (status == IoStatus::CLOSED || status == IoStatus::ERR)
+        {
+            running = false;
+            FailAll(Result::CLOSED, "Device read failed: " + std::to_string(transport->LastError()));
+            if (closed)
+            {
+                closed();
+            }
+            break;
+        }
+
+        // 回调在锁外执行, 以便回调中可以再次提交命令
+        ResponseMatcher::Callbacks callbacks;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            if (stats && bytesRead > 0)
+            {
+                stats->bytesIn += bytesRead;
+                if (awaitingFirstByte)
+                {
+                    stats->firstByte.Record(IoStats::MicrosSince(lastWriteDone));
+                    awaitingFirstByte = false;
+                }
+            }
+            matcher.Feed(readBuffer, bytesRead, callbacks);
+            matcher.Expire(Clock::now(), callbacks);
+        }
+
+        for (auto &callback : callbacks)
+        {
+            callback();
+        }
+    }
+}
+
+void CommandMux::FailAll(Result result, const std::string &error)
+{
+    ResponseMatcher::Callbacks callbacks;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        matcher.FailAll(result, error, callbacks);
+    }
+
+    for (auto &callback : callbacks)
+    {
+        callback();
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "io_stats.h"
+#include "response_matcher.h"
+#include "transport.h"
+#include "write_scheduler.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 命令多路复用器
+// 允许多条命令同时在途: 每条命令写出后进入 FIFO 等待队列, 一个持续运行的读线程
+// 把设备返回的数据交给 ResponseMatcher 切分成响应帧, 依次与队首请求匹配. 每个请求有自己的超时.
+class CommandMux {
+public:
+    typedef ResponseMatcher::Framing Framing;
+    typedef ResponseMatcher::Result Result;
+    typedef ResponseMatcher::Completion Completion;
+    typedef ResponseMatcher::UnsolicitedFn UnsolicitedFn;
+
+    static constexpr int LATE_RESPONSE_GRACE = ResponseMatcher::LATE_RESPONSE_GRACE;
+
+    typedef WriteScheduler::Priority Priority;
+
+    // 读线程因读取失败 (设备被移除或复位) 而停止时, 在读线程上调用一次
+    typedef std::function<void()> ClosedFn;
+
+    // scheduler 串行化所有写操作 (与 PLT 分块发送共用); stats 为空时不做统计
+    CommandMux(Transport *transport, WriteScheduler &scheduler, IoStats *stats = nullptr);
+    ~CommandMux();
+
+    void Start(UnsolicitedFn unsolicited, ClosedFn closed = ClosedFn());
+
+    // 停止读线程, 所有未完成的请求以 CLOSED 结束
+    void Stop();
+
+    bool IsRunning() const { return running.load(); }
+
+    // 响应帧的结束符 (设备型号配置)
+    void SetTerminator(uint8_t terminator);
+
+    // 写出命令并登记等待响应; 在调用线程上按 priority 取得写权限后写入, completion 在读线程上调用
+    void Submit(const uint8_t *data, size_t length, int timeoutMs, Framing framing, Completion completion,
+                Priority priority = Priority::INTERACTIVE);
+
+    // 同步版本: 等待响应或超时. 返回 Result, response 为空表示没有响应
+    Result SubmitAndWait(const uint8_t *data, size_t length, int timeoutMs, Framing framing,
+                         std::vector<uint8_t> &response, std::string &error,
+                         Priority priority = Priority::INTERACTIVE);
+
+private:
+    typedef ResponseMatcher::Clock Clock;
+
+    void ReaderLoop();
+    void FailAll(Result result, const std::string &error);
+
+    Transport *transport;
+    WriteScheduler &scheduler;
+    IoStats *stats;
+
+    std::mutex pendingMutex;
+    ResponseMatcher matcher;
+    bool awaitingFirstByte;             // 最近一条命令写完后还没有收到数据
+    Clock::time_point lastWriteDone;
+
+    ClosedFn closed;
+    std::thread reader;
+    std::atomic<bool> running;
+};
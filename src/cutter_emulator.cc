@@ -0,0 +1,320 @@
+#include "cutter_emulator.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t READ_SIZE = 4096;
+
+// 带宽受限时允许积攒的最大突发 (字节)
+const double MAX_BURST = 4096;
+
+bool SetNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+} // namespace
+
+CutterEmulator::CutterEmulator(const EmulatorOptions &options)
+    : options(options),
+      masterFd(-1),
+      slaveFd(-1),
+      running(false),
+      tokenLength(0),
+      tokenOverflow(false),
+      jobBytes(0),
+      random(std::random_device()()),
+      budget(0),
+      bytesReceived(0),
+      commands(0),
+      jobs(0)
+{
+    wakePipe[0] = -1;
+    wakePipe[1] = -1;
+}
+
+CutterEmulator::~CutterEmulator()
+{
+    Stop();
+}
+
+bool CutterEmulator::Start(std::string &error)
+{
+    if (running)
+    {
+        return true;
+    }
+
+    masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (masterFd < 0 || grantpt(masterFd) != 0 || unlockpt(masterFd) != 0)
+    {
+        error = "Failed to create pty: " + std::string(strerror(errno));
+        Stop();
+        return false;
+    }
+
+    const char *name = ptsname(masterFd);
+    if (name == nullptr)
+    {
+        error = "Failed to get pty name: " + std::string(strerror(errno));
+        Stop();
+        return false;
+    }
+    path = name;
+
+    // 原始模式: 不回显, 不做行缓冲和字符转换
+    slaveFd = open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    struct termios attributes;
+    if (slaveFd < 0 || tcgetattr(slaveFd, &attributes) != 0)
+    {
+        error = "Failed to open pty " + path + ": " + std::string(strerror(errno));
+        Stop();
+        return false;
+    }
+    cfmakeraw(&attributes);
+    tcsetattr(slaveFd, TCSANOW, &attributes);
+
+    if (!SetNonBlocking(masterFd) || pipe(wakePipe) != 0)
+    {
+        error = "Failed to set up emulator: " + std::string(strerror(errno));
+        Stop();
+        return false;
+    }
+
+    budget = 0;
+    budgetTime = Clock::now();
+    running = true;
+    worker = std::thread(&CutterEmulator::Run, this);
+    return true;
+}
+
+void CutterEmulator::Stop()
+{
+    if (running.exchange(false))
+    {
+        char wake = 1;
+        if (write(wakePipe[1], &wake, 1) < 0)
+        {
+            // 管道写失败时线程仍会在下一次超时后看到 running == false
+        }
+    }
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+
+    for (int *fd : {&masterFd, &slaveFd, &wakePipe[0], &wakePipe[1]})
+    {
+        if (*fd >= 0)
+        {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+EmulatorStats CutterEmulator::Stats() const
+{
+    EmulatorStats stats;
+    stats.bytesReceived = bytesReceived.load();
+    stats.commands = commands.load();
+    stats.jobs = jobs.load();
+    return stats;
+}
+
+void CutterEmulator::Run()
+{
+    uint8_t buffer[READ_SIZE];
+
+    while (running)
+    {
+        Clock::time_point now = Clock::now();
+        if (!FlushReplies(now))
+        {
+            break;
+        }
+
+        // 本轮最多接收的字节数, 以及没有数据时最多等待的时间
+        size_t allowed = READ_SIZE;
+        int waitMs = -1;
+        if (options.bandwidth > 0)
+        {
+            double elapsed = std::chrono::duration<double>(now - budgetTime).count();
+            budgetTime = now;
+            budget = std::min(budget + elapsed * options.bandwidth, std::max(MAX_BURST, options.bandwidth / 100));
+            allowed = static_cast<size_t>(std::min(budget, static_cast<double>(READ_SIZE)));
+            if (allowed == 0)
+            {
+                waitMs = std::max(1, static_cast<int>((1.0 - budget) * 1000.0 / options.bandwidth) + 1);
+            }
+        }
+        if (!replies.empty())
+        {
+            auto untilDue = std::chrono::duration_cast<std::chrono::milliseconds>(replies.front().due - now).count() + 1;
+            int dueMs = static_cast<int>(std::max<int64_t>(0, untilDue));
+            waitMs = waitMs < 0 ? dueMs : std::min(waitMs, dueMs);
+        }
+
+        struct pollfd fds[2];
+        fds[0].fd = masterFd;
+        fds[0].events = static_cast<short>((allowed > 0 ? POLLIN : 0) | (pendingWrite.empty() ? 0 : POLLOUT));
+        fds[0].revents = 0;
+        fds[1].fd = wakePipe[0];
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+
+        int rc = poll(fds, 2, waitMs);
+        if (rc < 0 && errno != EINTR)
+        {
+            break;
+        }
+        if (rc <= 0 || (fds[1].revents & POLLIN))
+        {
+            continue;
+        }
+
+        if (allowed > 0 && (fds[0].revents & POLLIN))
+        {
+            ssize_t n = read(masterFd, buffer, allowed);
+            if (n > 0)
+            {
+                bytesReceived += static_cast<uint64_t>(n);
+                if (options.bandwidth > 0)
+                {
+                    budget -= static_cast<double>(n);
+                }
+                Consume(buffer, static_cast<size_t>(n));
+            }
+            else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                break;
+            }
+        }
+    }
+}
+
+void CutterEmulator::Consume(const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = static_cast<char>(data[i]);
+        jobBytes++;
+
+        if (c == ';')
+        {
+            EndToken();
+        }
+        else if (c == '@')
+        {
+            char reply[32];
+            snprintf(reply, sizeof(reply), "JOB:%llu;", static_cast<unsigned long long>(jobBytes));
+            QueueReply(reply);
+            jobs++;
+            jobBytes = 0;
+            tokenLength = 0;
+            tokenOverflow = false;
+        }
+        else if (tokenLength == 0 && IsSpace(c))
+        {
+            // 忽略命令前的空白
+        }
+        else if (tokenLength < MAX_TOKEN)
+        {
+            token[tokenLength++] = c;
+        }
+        else
+        {
+            tokenOverflow = true;
+        }
+    }
+}
+
+void CutterEmulator::EndToken()
+{
+    std::string command(token, tokenLength);
+    bool overflow = tokenOverflow;
+    tokenLength = 0;
+    tokenOverflow = false;
+    if (overflow)
+    {
+        return;
+    }
+
+    if (command == "RSVER")
+    {
+        QueueReply("RSVER:EMU-1.0;");
+    }
+    else if (command == "RPID")
+    {
+        char reply[16];
+        snprintf(reply, sizeof(reply), "RPID:%04X;", options.productId);
+        QueueReply(reply);
+    }
+    else if (command.compare(0, 3, "BD:") == 0)
+    {
+        QueueReply(command + ";");
+    }
+    else
+    {
+        return;
+    }
+    commands++;
+    // 查询命令不属于 PLT 作业
+    jobBytes = 0;
+}
+
+void CutterEmulator::QueueReply(std::string data)
+{
+    int delayMs = options.latencyMs;
+    if (options.jitterMs > 0)
+    {
+        delayMs += std::uniform_int_distribution<int>(0, options.jitterMs)(random);
+    }
+
+    // 应答按收到命令的顺序发出, 抖动不会让后面的应答跑到前面
+    Clock::time_point due = Clock::now() + std::chrono::milliseconds(delayMs);
+    if (!replies.empty() && replies.back().due > due)
+    {
+        due = replies.back().due;
+    }
+    replies.push_back(Reply{due, std::move(data)});
+}
+
+bool CutterEmulator::FlushReplies(Clock::time_point now)
+{
+    while (!replies.empty() && replies.front().due <= now)
+    {
+        pendingWrite += replies.front().data;
+        replies.pop_front();
+    }
+
+    while (!pendingWrite.empty())
+    {
+        ssize_t n = write(masterFd, pendingWrite.data(), pendingWrite.size());
+        if (n > 0)
+        {
+            pendingWrite.erase(0, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+    return true;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <thread>
+
+// 刻字机模拟器 (POSIX)
+// 创建一对 pty, 从主端读取主机写入的数据, 从端路径交给 connectPath() 使用, 不需要硬件.
+//   RSVER;  -> "RSVER:EMU-1.0;"
+//   RPID;   -> "RPID:<productId 十六进制>;"
+//   BD:n;   -> "BD:n;"
+//   '@'     -> "JOB:<本作业字节数>;"  (PLT 作业结束)
+// 其余 PLT 命令只接收不应答. 应答延迟、抖动和设备消费数据的速度可以配置,
+// 带宽受限时主机一侧的写入会像真实设备一样被阻塞.
+struct EmulatorOptions {
+    int latencyMs = 0;        // 每条应答的固定延迟
+    int jitterMs = 0;         // 在固定延迟上再加 [0, jitterMs] 的随机延迟
+    double bandwidth = 0;     // 设备接收数据的速度 (字节/秒), 0 表示不限
+    uint16_t productId = 0x5750;
+};
+
+struct EmulatorStats {
+    uint64_t bytesReceived;
+    uint64_t commands;    // 已应答的查询命令
+    uint64_t jobs;        // 已结束的 PLT 作业
+};
+
+class CutterEmulator {
+public:
+    explicit CutterEmulator(const EmulatorOptions &options);
+    ~CutterEmulator();
+
+    CutterEmulator(const CutterEmulator &) = delete;
+    CutterEmulator &operator=(const CutterEmulator &) = delete;
+
+    bool Start(std::string &error);
+    void Stop();
+
+    // pty 从端路径, 例如 /dev/pts/3
+    const std::string &Path() const { return path; }
+
+    EmulatorStats Stats() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Reply {
+        Clock::time_point due;
+        std::string data;
+    };
+
+    // 查询命令的最大长度, 更长的内容不可能是查询命令, 不再缓存
+    static const size_t MAX_TOKEN = 32;
+
+    void Run();
+    void Consume(const uint8_t *data, size_t length);
+    void EndToken();
+    void QueueReply(std::string data);
+    bool FlushReplies(Clock::time_point now);
+
+    EmulatorOptions options;
+    std::string path;
+    int masterFd;
+    int slaveFd;          // 模拟器自己保持从端打开, 主机断开重连时主端不会收到挂断
+    int wakePipe[2];
+
+    std::thread worker;
+    std::atomic<bool> running;
+
+    // 以下只在模拟器线程上访问
+    char token[MAX_TOKEN];
+    size_t tokenLength;
+    bool tokenOverflow;
+    uint64_t jobBytes;
+    std::deque<Reply> replies;
+    std::string pendingWrite;   // 已到期但主端暂时写不进去的应答
+    std::mt19937 random;
+    double budget;              // 带宽受限时当前还可以接收的字节数
+    Clock::time_point budgetTime;
+
+    std::atomic<uint64_t> bytesReceived;
+    std::atomic<uint64_t> commands;
+    std::atomic<uint64_t> jobs;
+};
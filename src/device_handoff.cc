@@ -0,0 +1,52 @@
+#include "device_handoff.h"
+
+DeviceHandoff &DeviceHandoff::Shared()
+{
+    static DeviceHandoff instance;
+    return instance;
+}
+
+DeviceHandoff::DeviceHandoff()
+    : nextToken(1)
+{
+}
+
+uint32_t DeviceHandoff::Put(std::unique_ptr<DetachedDevice> device)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    uint32_t token = nextToken++;
+    // 令牌为 0 表示无效, 回绕时跳过
+    if (nextToken == 0)
+    {
+        nextToken = 1;
+    }
+    devices[token] = std::move(device);
+    return token;
+}
+
+std::unique_ptr<DetachedDevice> DeviceHandoff::Take(uint32_t token)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = devices.find(token);
+    if (it == devices.end())
+    {
+        return nullptr;
+    }
+    std::unique_ptr<DetachedDevice> device = std::move(it->second);
+    devices.erase(it);
+    return device;
+}
+
+bool DeviceHandoff::Discard(uint32_t token)
+{
+    std::unique_ptr<DetachedDevice> device = Take(token);
+    if (!device)
+    {
+        return false;
+    }
+    if (device->transport)
+    {
+        device->transport->Close();
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "device_profile.h"
+#include "flow_control.h"
+#include "transport.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// 从一个 UsbDevice 摘下的已打开设备: 传输层 (打开的句柄) 和连接参数
+struct DetachedDevice {
+    std::unique_ptr<Transport> transport;
+    std::string path;
+    std::string serial;
+    uint16_t vendorId = 0;
+    uint16_t productId = 0;
+    DeviceProfile profile;
+    int commandTimeout = 0;
+    int pltTimeout = 0;
+    FlowProfile flow;
+};
+
+// 在 JS 环境 (worker_threads) 之间移交已打开的设备
+// detach() 把设备放进这张进程级的表, 得到一个整数令牌, 令牌可以用 postMessage 传给其他 worker;
+// 那边的 UsbDevice 用 attach(token) 取出后直接开始读写, 不需要重新打开设备, 也不经过设备索引.
+// 每个令牌只能取出一次; 没有被取出的设备保持打开, 直到 Discard 或进程退出.
+class DeviceHandoff {
+public:
+    static DeviceHandoff &Shared();
+
+    uint32_t Put(std::unique_ptr<DetachedDevice> device);
+
+    // 令牌不存在 (或已被取出) 时返回空
+    std::unique_ptr<DetachedDevice> Take(uint32_t token);
+
+    // 关闭并丢弃一个没有被取出的设备, 返回令牌是否存在
+    bool Discard(uint32_t token);
+
+private:
+    DeviceHandoff();
+
+    std::mutex mutex;
+    std::map<uint32_t, std::unique_ptr<DetachedDevice>> devices;
+    uint32_t nextToken;
+};
@@ -0,0 +1,326 @@
+#include "device_index.h"
+#include <algorithm>
+#include <cctype>
+#ifdef _WIN32
+#include <cstdlib>
+#include <cstring>
+#include <windows.h>
+#include <setupapi.h>
+#include <usbprint.h>
+#else
+#include <dirent.h>
+#include <fstream>
+#endif
+
+namespace {
+
+bool SamePath(const std::string &a, const std::string &b)
+{
+#ifdef _WIN32
+    // Windows 设备接口路径不区分大小写, 通知消息里的路径大小写可能与 SetupDi 返回的不同
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+           });
+#else
+    return a == b;
+#endif
+}
+
+#ifdef _WIN32
+// 在硬件 ID 中查找 "VID_xxxx" 之类的字段, 解析其后的四位十六进制数
+bool ParseHexField(const std::string &text, const char *key, uint16_t &value)
+{
+    std::string upper(text);
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+
+    size_t pos = upper.find(key);
+    if (pos == std::string::npos || pos + strlen(key) + 4 > upper.size())
+    {
+        return false;
+    }
+    value = static_cast<uint16_t>(strtoul(upper.substr(pos + strlen(key), 4).c_str(), nullptr, 16));
+    return true;
+}
+
+// 设备接口路径形如 \\?\usb#vid_xxxx&pid_xxxx#<序列号>#{guid}, 取第三段作为序列号
+std::string SerialFromInterfacePath(const std::string &path)
+{
+    size_t first = path.find('#');
+    size_t second = first == std::string::npos ? first : path.find('#', first + 1);
+    size_t third = second == std::string::npos ? second : path.find('#', second + 1);
+    if (third == std::string::npos)
+    {
+        return "";
+    }
+    std::string serial = path.substr(second + 1, third - second - 1);
+    // 没有序列号的设备由系统生成带 '&' 的实例 ID, 不是真正的序列号
+    return serial.find('&') == std::string::npos ? serial : "";
+}
+#else
+bool ReadSysfsHex(const std::string &path, unsigned int &value)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+    file >> std::hex >> value;
+    return !file.fail();
+}
+
+std::string ReadSysfsString(const std::string &path)
+{
+    std::ifstream file(path);
+    std::string value;
+    std::getline(file, value);
+    return value;
+}
+#endif
+
+} // namespace
+
+#ifdef _WIN32
+std::vector<DeviceInfo> ScanDevices()
+{
+    std::vector<DeviceInfo> devices;
+
+    // 使用打印机类 GUID
+    HDEVINFO deviceInfo = SetupDiGetClassDevsA(&GUID_DEVINTERFACE_USBPRINT, NULL, NULL, DIGCF_PRESENT | DIGCF_DEVICEINTERFACE);
+    if (deviceInfo == INVALID_HANDLE_VALUE)
+    {
+        return devices;
+    }
+
+    SP_DEVICE_INTERFACE_DATA interfaceData;
+    interfaceData.cbSize = sizeof(SP_DEVICE_INTERFACE_DATA);
+    std::vector<char> detailBuffer;
+
+    for (DWORD i = 0; SetupDiEnumDeviceInterfaces(deviceInfo, NULL, &GUID_DEVINTERFACE_USBPRINT, i, &interfaceData); i++)
+    {
+        DWORD requiredSize = 0;
+        SetupDiGetDeviceInterfaceDetailA(deviceInfo, &interfaceData, NULL, 0, &requiredSize, NULL);
+        if (requiredSize < sizeof(SP_DEVICE_INTERFACE_DETAIL_DATA_A))
+        {
+            continue;
+        }
+
+        // 复用同一块缓冲区, 不再每个设备 malloc/free
+        detailBuffer.resize(requiredSize);
+        auto detailData = reinterpret_cast<PSP_DEVICE_INTERFACE_DETAIL_DATA_A>(detailBuffer.data());
+        detailData->cbSize = sizeof(SP_DEVICE_INTERFACE_DETAIL_DATA_A);
+
+        SP_DEVINFO_DATA devInfoData;
+        devInfoData.cbSize = sizeof(SP_DEVINFO_DATA);
+
+        if (!SetupDiGetDeviceInterfaceDetailA(deviceInfo, &interfaceData, detailData, requiredSize, NULL, &devInfoData))
+        {
+            continue;
+        }
+
+        // 获取设备硬件ID，包含VID/PID信息
+        char hardwareId[256] = {0};
+        if (!SetupDiGetDeviceRegistryPropertyA(deviceInfo, &devInfoData, SPDRP_HARDWAREID, NULL,
+                                               (PBYTE)hardwareId, sizeof(hardwareId), NULL))
+        {
+            continue;
+        }
+
+        DeviceInfo info;
+        info.path = detailData->DevicePath;
+        if (!ParseHexField(hardwareId, "VID_", info.vendorId) || !ParseHexField(hardwareId, "PID_", info.productId))
+        {
+            ParseHexField(info.path, "VID_", info.vendorId);
+            ParseHexField(info.path, "PID_", info.productId);
+        }
+        info.serial = SerialFromInterfacePath(info.path);
+        devices.push_back(info);
+    }
+
+    SetupDiDestroyDeviceInfoList(deviceInfo);
+    return devices;
+}
+#else
+std::vector<DeviceInfo> ScanDevices(const std::string &sysfsRoot, const std::string &devRoot)
+{
+    std::vector<DeviceInfo> devices;
+
+    // usblp 驱动的每个打印机接口都在 class/usbmisc 下有一个 lpN 节点,
+    // 其 device 指向 USB 接口, 上一级目录是带 idVendor/idProduct/serial 的 USB 设备
+    const std::string classDir = sysfsRoot + "/class/usbmisc";
+    DIR *dir = opendir(classDir.c_str());
+    if (!dir)
+    {
+        return devices;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        std::string name = entry->d_name;
+        if (name.compare(0, 2, "lp") != 0)
+        {
+            continue;
+        }
+
+        std::string usbDir = classDir + "/" + name + "/device/..";
+        unsigned int vid = 0;
+        unsigned int pid = 0;
+        if (!ReadSysfsHex(usbDir + "/idVendor", vid) || !ReadSysfsHex(usbDir + "/idProduct", pid))
+        {
+            continue;
+        }
+
+        DeviceInfo info;
+        info.path = devRoot + "/usb/" + name;
+        info.vendorId = static_cast<uint16_t>(vid);
+        info.productId = static_cast<uint16_t>(pid);
+        info.serial = ReadSysfsString(usbDir + "/serial");
+        devices.push_back(info);
+    }
+
+    closedir(dir);
+
+    // readdir 的顺序不固定, 按路径排序使 "任意设备" 的选择稳定
+    std::sort(devices.begin(), devices.end(), [](const DeviceInfo &a, const DeviceInfo &b) {
+        return a.path.size() != b.path.size() ? a.path.size() < b.path.size() : a.path < b.path;
+    });
+    return devices;
+}
+#endif
+
+DeviceIndex &DeviceIndex::Shared()
+{
+    static DeviceIndex index;
+    return index;
+}
+
+DeviceIndex::DeviceIndex()
+    : valid(false),
+      watchers(0)
+#ifndef _WIN32
+      ,
+      sysfsRoot("/sys"),
+      devRoot("/dev")
+#endif
+{
+}
+
+void DeviceIndex::Rescan()
+{
+#ifdef _WIN32
+    devices = ScanDevices();
+#else
+    devices = ScanDevices(sysfsRoot, devRoot);
+#endif
+    valid = true;
+    lastScan = Clock::now();
+}
+
+bool DeviceIndex::Match(uint16_t vendorId, uint16_t productId, const std::string &serial, DeviceInfo &result) const
+{
+    for (const DeviceInfo &info : devices)
+    {
+        bool anyDevice = vendorId == 0 && productId == 0;
+        if ((anyDevice || (info.vendorId == vendorId && info.productId == productId)) &&
+            (serial.empty() || info.serial == serial))
+        {
+            result = info;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DeviceIndex::Find(uint16_t vendorId, uint16_t productId, const std::string &serial, DeviceInfo &result)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!valid)
+    {
+        Rescan();
+        return Match(vendorId, productId, serial, result);
+    }
+
+    if (Match(vendorId, productId, serial, result))
+    {
+        return true;
+    }
+
+    // 没有热插拔事件源时, 新插入的设备只能靠重新扫描发现; 限制频率, 避免逐个尝试 VID/PID 时反复扫描
+    if (watchers == 0 && Clock::now() - lastScan >= std::chrono::milliseconds(RESCAN_INTERVAL))
+    {
+        Rescan();
+        return Match(vendorId, productId, serial, result);
+    }
+    return false;
+}
+
+bool DeviceIndex::FindPath(const std::string &path, DeviceInfo &result)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!valid)
+    {
+        Rescan();
+    }
+
+    for (const DeviceInfo &info : devices)
+    {
+        if (SamePath(info.path, path))
+        {
+            result = info;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<DeviceInfo> DeviceIndex::List(bool refresh)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!valid || refresh)
+    {
+        Rescan();
+    }
+    return devices;
+}
+
+void DeviceIndex::Invalidate()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    valid = false;
+}
+
+void DeviceIndex::Remove(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    devices.erase(std::remove_if(devices.begin(), devices.end(),
+                                 [&](const DeviceInfo &info) { return SamePath(info.path, path); }),
+                  devices.end());
+}
+
+void DeviceIndex::BeginWatching()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    watchers++;
+    // 开始监听之前发生的变化收不到事件, 重新扫描一次
+    valid = false;
+}
+
+void DeviceIndex::EndWatching()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (watchers > 0)
+    {
+        watchers--;
+    }
+}
+
+#ifndef _WIN32
+void DeviceIndex::SetSysfsRoot(const std::string &root, const std::string &nodeRoot)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    sysfsRoot = root.empty() ? "/sys" : root;
+    devRoot = nodeRoot.empty() ? "/dev" : nodeRoot;
+    valid = false;
+}
+#endif
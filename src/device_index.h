@@ -0,0 +1,71 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct DeviceInfo {
+    std::string path;       // 传给 Transport::Open 的设备路径
+    uint16_t vendorId = 0;
+    uint16_t productId = 0;
+    std::string serial;     // USB 序列号, 设备没有提供时为空
+};
+
+// 设备索引
+// 第一次查找时扫描一次总线 (Windows: SetupDi, Linux: sysfs), 之后由热插拔事件保持更新,
+// Connect 只是一次查表. 没有热插拔事件源时, 查找失败最多每 RESCAN_INTERVAL 毫秒重新扫描一次.
+class DeviceIndex {
+public:
+    static constexpr int RESCAN_INTERVAL = 500;
+
+    static DeviceIndex &Shared();
+
+    // 查找匹配的设备; vendorId 和 productId 都为 0 时匹配任意设备, serial 为空时不比较序列号
+    bool Find(uint16_t vendorId, uint16_t productId, const std::string &serial, DeviceInfo &result);
+
+    // 按设备路径查找 (索引失效时先重新扫描)
+    bool FindPath(const std::string &path, DeviceInfo &result);
+
+    // 当前索引中的全部设备; refresh 为 true 时先重新扫描
+    std::vector<DeviceInfo> List(bool refresh);
+
+    // 热插拔事件: 设备到达时下次查找重新扫描, 移除时直接从索引中删除
+    void Invalidate();
+    void Remove(const std::string &path);
+
+    // 热插拔事件源的启停; 有事件源时认为索引总是最新的, 查找失败不再扫描
+    void BeginWatching();
+    void EndWatching();
+
+#ifndef _WIN32
+    // sysfs 根目录 (默认 "/sys") 和设备节点目录 (默认 "/dev"), 测试时可以指向伪造的目录树
+    void SetSysfsRoot(const std::string &root, const std::string &devRoot);
+#endif
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    DeviceIndex();
+
+    // 调用时必须持有 mutex
+    void Rescan();
+    bool Match(uint16_t vendorId, uint16_t productId, const std::string &serial, DeviceInfo &result) const;
+
+    std::mutex mutex;
+    std::vector<DeviceInfo> devices;
+    bool valid;
+    int watchers;
+    Clock::time_point lastScan;
+#ifndef _WIN32
+    std::string sysfsRoot;
+    std::string devRoot;
+#endif
+};
+
+// 扫描当前连接的设备 (平台相关, 不经过索引)
+#ifdef _WIN32
+std::vector<DeviceInfo> ScanDevices();
+#else
+std::vector<DeviceInfo> ScanDevices(const std::string &sysfsRoot, const std::string &devRoot);
+#endif
@@ -0,0 +1,274 @@
+#include "device_pool.h"
+#include "addon_data.h"
+#include "js_buffer.h"
+#include "logger.h"
+#include "usb_addon.h"
+#include <algorithm>
+
+namespace {
+
+const char *EventTypeName(DeviceReactor::EventType type)
+{
+    switch (type)
+    {
+    case DeviceReactor::EventType::SENT:
+        return "SENT";
+    case DeviceReactor::EventType::RESPONSE:
+        return "RESPONSE";
+    case DeviceReactor::EventType::DATA:
+        return "DATA";
+    case DeviceReactor::EventType::ERR:
+        return "ERROR";
+    case DeviceReactor::EventType::CLOSED:
+        return "CLOSED";
+    }
+    return "UNKNOWN";
+}
+
+} // namespace
+
+Napi::Object DevicePool::Init(Napi::Env env, Napi::Object exports)
+{
+    Napi::HandleScope scope(env);
+
+    Napi::Function func = DefineClass(env, "DevicePool", {
+        InstanceMethod("open", &DevicePool::Open),
+        InstanceMethod("close", &DevicePool::Close),
+        InstanceMethod("send", &DevicePool::Send),
+        InstanceMethod("sendCmd", &DevicePool::SendCmd),
+        InstanceMethod("deviceCount", &DevicePool::DeviceCount),
+        InstanceMethod("destroy", &DevicePool::Destroy)
+    });
+
+    AddonData::Get(env).devicePool = Napi::Persistent(func);
+
+    exports.Set("DevicePool", func);
+    return exports;
+}
+
+DevicePool::DevicePool(const Napi::CallbackInfo &info)
+    : Napi::ObjectWrap<DevicePool>(info),
+      shared(std::make_shared<Shared>())
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsFunction())
+    {
+        Napi::TypeError::New(env, "Expected callback function").ThrowAsJavaScriptException();
+        return;
+    }
+
+    // 没有设备打开时不阻止进程退出
+    shared->tsfn = Napi::ThreadSafeFunction::New(
+        env,
+        info[0].As<Napi::Function>(),
+        "DevicePoolEvents",
+        0,
+        1);
+    shared->tsfn.Unref(env);
+
+    std::shared_ptr<Shared> events = shared;
+    reactor.reset(new DeviceReactor([events](DeviceReactor::Event &event) {
+        EmitEvent(events, event);
+    }));
+
+    std::string error;
+    if (!reactor->Start(error))
+    {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return;
+    }
+
+    cleanupHook = env.AddCleanupHook(&DevicePool::OnEnvCleanup, this);
+}
+
+DevicePool::~DevicePool()
+{
+    if (!cleanupHook.IsEmpty())
+    {
+        cleanupHook.Remove(Env());
+    }
+    Shutdown();
+}
+
+void DevicePool::OnEnvCleanup(DevicePool *pool)
+{
+    // 钩子调用后即被删除, 析构时不能再移除
+    pool->cleanupHook = CleanupHook();
+    pool->Shutdown();
+}
+
+void DevicePool::Shutdown()
+{
+    // 停止时未完成的作业和设备的事件仍会送达 JS, 然后释放回调
+    if (reactor)
+    {
+        reactor->Stop();
+        reactor.reset();
+    }
+    if (shared->tsfn)
+    {
+        shared->tsfn.Release();
+        shared->tsfn = Napi::ThreadSafeFunction();
+    }
+}
+
+Napi::Value DevicePool::Open(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        Napi::TypeError::New(env, "Expected device path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (!reactor)
+    {
+        return env.Null();
+    }
+
+    std::string error;
+    int device = reactor->Open(info[0].As<Napi::String>().Utf8Value(), error);
+    if (device < 0)
+    {
+        LOG_WARN("%s", error.c_str());
+        return env.Null();
+    }
+
+    if (shared->openDevices++ == 0)
+    {
+        shared->tsfn.Ref(env);
+    }
+    return Napi::Number::New(env, device);
+}
+
+Napi::Value DevicePool::Close(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        Napi::TypeError::New(env, "Expected device id").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    bool closed = reactor && reactor->Close(info[0].As<Napi::Number>().Int32Value());
+    return Napi::Boolean::New(env, closed);
+}
+
+Napi::Value DevicePool::Send(const Napi::CallbackInfo &info)
+{
+    return Enqueue(info, -1);
+}
+
+Napi::Value DevicePool::SendCmd(const Napi::CallbackInfo &info)
+{
+    // 可选参数: { timeout }
+    int timeoutMs = UsbDevice::CMD_TIMEOUT;
+    if (info.Length() >= 3 && info[2].IsObject())
+    {
+        Napi::Object options = info[2].As<Napi::Object>();
+        if (options.Has("timeout"))
+        {
+            timeoutMs = std::max(0, options.Get("timeout").As<Napi::Number>().Int32Value());
+        }
+    }
+    return Enqueue(info, timeoutMs);
+}
+
+Napi::Value DevicePool::Enqueue(const Napi::CallbackInfo &info, int timeoutMs)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsBuffer())
+    {
+        Napi::TypeError::New(env, "Expected device id and buffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (!reactor)
+    {
+        return env.Null();
+    }
+
+    Napi::Buffer<uint8_t> buffer = info[1].As<Napi::Buffer<uint8_t>>();
+
+    // 作业完成前保持 Buffer 存活, 在作业的最终事件中 (JS 线程上) 释放
+    Napi::ObjectReference *bufferRef = new Napi::ObjectReference(
+        Napi::Persistent(static_cast<Napi::Object>(buffer)));
+
+    uint64_t job = reactor->Submit(info[0].As<Napi::Number>().Int32Value(), buffer.Data(), buffer.Length(),
+                                   timeoutMs, ResponseMatcher::Framing::TERMINATED, bufferRef);
+    if (job == 0)
+    {
+        delete bufferRef;
+        return env.Null();
+    }
+    return Napi::Number::New(env, static_cast<double>(job));
+}
+
+Napi::Value DevicePool::DeviceCount(const Napi::CallbackInfo &info)
+{
+    return Napi::Number::New(info.Env(), reactor ? static_cast<double>(reactor->DeviceCount()) : 0);
+}
+
+Napi::Value DevicePool::Destroy(const Napi::CallbackInfo &info)
+{
+    if (reactor)
+    {
+        reactor->Stop();
+        reactor.reset();
+    }
+    return info.Env().Undefined();
+}
+
+void DevicePool::EmitEvent(const std::shared_ptr<Shared> &shared, DeviceReactor::Event &event)
+{
+    struct PendingEvent {
+        DeviceReactor::Event event;
+        std::shared_ptr<Shared> shared;
+    };
+
+    auto pending = new PendingEvent{std::move(event), shared};
+
+    napi_status status = shared->tsfn.BlockingCall(pending, [](Napi::Env env, Napi::Function jsCallback, PendingEvent *pending) {
+        const DeviceReactor::Event &event = pending->event;
+
+        Napi::Object payload = Napi::Object::New(env);
+        payload.Set("device", Napi::Number::New(env, event.device));
+        if (event.job != 0)
+        {
+            payload.Set("job", Napi::Number::New(env, static_cast<double>(event.job)));
+        }
+        if (event.data)
+        {
+            payload.Set("data", ToJsBuffer(env, event.data));
+        }
+        if (!event.error.empty())
+        {
+            payload.Set("error", Napi::String::New(env, event.error));
+        }
+
+        // 作业结束, 释放输入 Buffer 的引用
+        delete static_cast<Napi::ObjectReference *>(event.context);
+
+        if (event.type == DeviceReactor::EventType::CLOSED && --pending->shared->openDevices == 0)
+        {
+            pending->shared->tsfn.Unref(env);
+        }
+
+        Napi::String eventType = Napi::String::New(env, EventTypeName(event.type));
+        delete pending;
+        jsCallback.Call({eventType, payload});
+    });
+
+    if (status != napi_ok)
+    {
+        if (pending->event.data)
+        {
+            BufferPool::Shared().Release(pending->event.data);
+        }
+        delete pending;
+    }
+}
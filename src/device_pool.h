@@ -0,0 +1,40 @@
+#pragma once
+#include <napi.h>
+#include "device_reactor.h"
+#include <memory>
+
+// 多设备连接池 (Linux)
+// 所有设备共用一个 DeviceReactor 事件循环线程, 事件通过同一个 ThreadSafeFunction 交给 JS:
+//   callback(type, { device, job, data, error })
+//   type: "SENT" | "RESPONSE" | "DATA" | "ERROR" | "CLOSED"
+class DevicePool : public Napi::ObjectWrap<DevicePool> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    DevicePool(const Napi::CallbackInfo &info);
+    ~DevicePool();
+
+private:
+    typedef Napi::Env::CleanupHook<void (*)(DevicePool *), DevicePool> CleanupHook;
+
+    // 事件回调需要的状态, 由池和尚未送达的事件共同持有 (池可能先于事件被回收)
+    struct Shared {
+        Napi::ThreadSafeFunction tsfn;
+        size_t openDevices = 0;   // 仅在 JS 线程上访问; 有设备打开时保持事件循环存活
+    };
+
+    Napi::Value Open(const Napi::CallbackInfo &info);
+    Napi::Value Close(const Napi::CallbackInfo &info);
+    Napi::Value Send(const Napi::CallbackInfo &info);
+    Napi::Value SendCmd(const Napi::CallbackInfo &info);
+    Napi::Value DeviceCount(const Napi::CallbackInfo &info);
+    Napi::Value Destroy(const Napi::CallbackInfo &info);
+
+    Napi::Value Enqueue(const Napi::CallbackInfo &info, int timeoutMs);
+    static void OnEnvCleanup(DevicePool *pool);
+    void Shutdown();
+    static void EmitEvent(const std::shared_ptr<Shared> &shared, DeviceReactor::Event &event);
+
+    std::shared_ptr<Shared> shared;
+    std::unique_ptr<DeviceReactor> reactor;
+    CleanupHook cleanupHook;   // 环境销毁时停止事件循环线程
+};
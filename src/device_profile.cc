@@ -0,0 +1,74 @@
+#include "device_profile.h"
+
+namespace {
+
+// Windows 下 FILE_ATTRIBUTE_NORMAL 的值, 这里不包含 windows.h
+const uint32_t ATTRIBUTE_NORMAL = 0x80;
+
+} // namespace
+
+DeviceProfiles &DeviceProfiles::Shared()
+{
+    static DeviceProfiles instance;
+    return instance;
+}
+
+DeviceProfile DeviceProfiles::Default()
+{
+    DeviceProfile profile;
+    profile.name = "default";
+    return profile;
+}
+
+DeviceProfiles::DeviceProfiles()
+{
+    // 海沃佳 (HWJ): RSVER; / RPID; / BD:n; 的响应以 ';' 结尾, 只能以 FILE_ATTRIBUTE_NORMAL 打开
+    DeviceProfile hwj;
+    hwj.name = "HWJ";
+    hwj.vendorId = 0x0483;
+    hwj.productId = 0x5750;
+    hwj.fileAttributes = ATTRIBUTE_NORMAL;
+    profiles.push_back(hwj);
+
+    // GNS: 状态查询 USBS; 的响应 (例如 "S0") 没有结束符
+    DeviceProfile gns;
+    gns.name = "GNS";
+    gns.vendorId = 0x0483;
+    gns.productId = 0x5448;
+    gns.terminator = 0;
+    gns.commandTimeout = 100;
+    profiles.push_back(gns);
+}
+
+DeviceProfile DeviceProfiles::Find(uint16_t vendorId, uint16_t productId)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const DeviceProfile &profile : profiles)
+    {
+        if (profile.vendorId == vendorId && profile.productId == productId)
+        {
+            return profile;
+        }
+    }
+    return Default();
+}
+
+void DeviceProfiles::Register(const DeviceProfile &profile)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (DeviceProfile &existing : profiles)
+    {
+        if (existing.vendorId == profile.vendorId && existing.productId == profile.productId)
+        {
+            existing = profile;
+            return;
+        }
+    }
+    profiles.push_back(profile);
+}
+
+std::vector<DeviceProfile> DeviceProfiles::List()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return profiles;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "flow_control.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 设备型号配置: Connect 时按 VID/PID 选出, 决定该型号的分块大小、超时、响应格式、打开方式和流控参数
+struct DeviceProfile {
+    std::string name;
+    uint16_t vendorId = 0;
+    uint16_t productId = 0;
+
+    size_t chunkSize = 4096;        // startPlt / sendPltFile 默认的分块大小
+    int commandTimeout = 50;        // 命令等待响应的默认超时 (毫秒)
+    int pltTimeout = 500;           // PLT 等待回执的默认超时 (毫秒)
+    uint8_t terminator = ';';       // 命令响应的结束符, 0 表示响应没有结束符 (取收到的第一段数据)
+    uint32_t fileAttributes = 0;    // Windows CreateFile 的文件属性, 0 为 FILE_ATTRIBUTE_NORMAL; 其他平台忽略
+    FlowProfile flow;               // 流控参数, bufferSize 为 0 时不做流控
+};
+
+// 设备型号配置表
+// 内置已知型号, JS 可以用 registerDeviceProfile() 增加或覆盖; 没有匹配的型号时使用默认配置.
+class DeviceProfiles {
+public:
+    static DeviceProfiles &Shared();
+
+    // 按 VID/PID 查找, 没有匹配时返回默认配置 (name 为 "default")
+    DeviceProfile Find(uint16_t vendorId, uint16_t productId);
+
+    // 增加或替换 (同一 VID/PID) 一个型号配置
+    void Register(const DeviceProfile &profile);
+
+    std::vector<DeviceProfile> List();
+
+    static DeviceProfile Default();
+
+private:
+    DeviceProfiles();
+
+    std::mutex mutex;
+    std::vector<DeviceProfile> profiles;
+};
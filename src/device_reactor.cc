@@ -0,0 +1,401 @@
+#include "device_reactor.h"
+#include <algorithm>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+
+// 每次 epoll_wait 最多处理的事件数
+const int MAX_EVENTS = 64;
+
+// 每个设备单次读取的最大字节数
+const size_t READ_SIZE = 1024;
+
+// 单轮中每个设备最多连续读取的次数, 防止持续输出的设备饿死其他设备
+const int MAX_READS_PER_TURN = 16;
+
+// epoll 数据中表示唤醒 eventfd 的编号 (设备编号从 1 开始)
+const uint64_t WAKE_TOKEN = 0;
+
+} // namespace
+
+DeviceReactor::DeviceReactor(EventFn handler)
+    : handler(std::move(handler)),
+      epollFd(-1),
+      wakeFd(-1),
+      nextDevice(1),
+      nextJob(1),
+      running(false)
+{
+}
+
+DeviceReactor::~DeviceReactor()
+{
+    Stop();
+    if (wakeFd >= 0)
+    {
+        close(wakeFd);
+    }
+    if (epollFd >= 0)
+    {
+        close(epollFd);
+    }
+}
+
+bool DeviceReactor::Start(std::string &error)
+{
+    if (running)
+    {
+        return true;
+    }
+
+    if (epollFd < 0)
+    {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd < 0 || wakeFd < 0)
+        {
+            error = "Failed to create reactor: " + std::to_string(errno);
+            return false;
+        }
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = WAKE_TOKEN;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+    }
+
+    running = true;
+    loopThread = std::thread(&DeviceReactor::Loop, this);
+    return true;
+}
+
+void DeviceReactor::Stop()
+{
+    if (!running)
+    {
+        return;
+    }
+
+    running = false;
+    Wake();
+    if (loopThread.joinable())
+    {
+        loopThread.join();
+    }
+
+    Events events;
+    ResponseMatcher::Callbacks callbacks;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        for (auto &entry : channels)
+        {
+            entry.second->closeReason = "Device pool stopped";
+            Teardown(*entry.second, events, callbacks);
+        }
+        channels.clear();
+    }
+    Dispatch(events, callbacks);
+}
+
+int DeviceReactor::Open(const std::string &path, std::string &error)
+{
+    if (!running)
+    {
+        error = "Device pool is not running";
+        return -1;
+    }
+
+    std::unique_ptr<Channel> channel(new Channel());
+    if (!channel->transport.Open(path))
+    {
+        error = "Failed to open device: " + std::to_string(channel->transport.LastError());
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(stateMutex);
+    channel->id = nextDevice++;
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = static_cast<uint64_t>(channel->id);
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, channel->transport.Fd(), &ev) < 0)
+    {
+        error = "Failed to watch device: " + std::to_string(errno);
+        return -1;
+    }
+
+    int id = channel->id;
+    channel->matcher.SetUnsolicited([this, id](std::vector<uint8_t> *frame) {
+        Event event{EventType::DATA, id, 0, frame, std::string(), nullptr};
+        handler(event);
+    });
+    channels[id] = std::move(channel);
+    return id;
+}
+
+bool DeviceReactor::Close(int device)
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    auto it = channels.find(device);
+    if (it == channels.end() || it->second->closing)
+    {
+        return false;
+    }
+
+    it->second->closing = true;
+    it->second->closeReason = "Device closed";
+    Wake();
+    return true;
+}
+
+uint64_t DeviceReactor::Submit(int device, const uint8_t *data, size_t length, int timeoutMs,
+                               ResponseMatcher::Framing framing, void *context)
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    auto it = channels.find(device);
+    if (it == channels.end() || it->second->closing)
+    {
+        return 0;
+    }
+
+    Job job;
+    job.id = nextJob++;
+    job.data = data;
+    job.length = length;
+    job.offset = 0;
+    job.timeoutMs = timeoutMs;
+    job.framing = framing;
+    job.context = context;
+    it->second->queue.push_back(job);
+
+    Wake();
+    return job.id;
+}
+
+size_t DeviceReactor::DeviceCount()
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return channels.size();
+}
+
+void DeviceReactor::Wake()
+{
+    uint64_t one = 1;
+    ssize_t rc = write(wakeFd, &one, sizeof(one));
+    (void)rc;
+}
+
+void DeviceReactor::Loop()
+{
+    struct epoll_event ready[MAX_EVENTS];
+
+    while (running)
+    {
+        // 有命令在等待响应时, 最多等到最近的截止时间; 否则一直等到有 I/O 或被唤醒
+        int waitMs = -1;
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            Clock::time_point now = Clock::now();
+            for (auto &entry : channels)
+            {
+                waitMs = entry.second->matcher.WaitMs(now, waitMs);
+            }
+        }
+
+        int count = epoll_wait(epollFd, ready, MAX_EVENTS, waitMs);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        Events events;
+        ResponseMatcher::Callbacks callbacks;
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+
+            for (int i = 0; i < count; i++)
+            {
+                if (ready[i].data.u64 == WAKE_TOKEN)
+                {
+                    uint64_t value;
+                    ssize_t rc = read(wakeFd, &value, sizeof(value));
+                    (void)rc;
+                    continue;
+                }
+
+                auto it = channels.find(static_cast<int>(ready[i].data.u64));
+                if (it == channels.end())
+                {
+                    continue;
+                }
+
+                Channel &channel = *it->second;
+                if (ready[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                {
+                    HandleReadable(channel, callbacks);
+                }
+                if ((ready[i].events & (EPOLLHUP | EPOLLERR)) && !channel.closing)
+                {
+                    channel.closing = true;
+                    channel.closeReason = "Device disconnected";
+                }
+            }
+
+            // 写出新排入和上轮未写完的数据, 处理超时, 清理关闭的设备
+            Clock::time_point now = Clock::now();
+            for (auto it = channels.begin(); it != channels.end();)
+            {
+                Channel &channel = *it->second;
+                if (!channel.closing)
+                {
+                    Flush(channel, events);
+                }
+                if (!channel.closing)
+                {
+                    channel.matcher.Expire(now, callbacks);
+                    ++it;
+                    continue;
+                }
+
+                Teardown(channel, events, callbacks);
+                it = channels.erase(it);
+            }
+        }
+
+        Dispatch(events, callbacks);
+    }
+}
+
+void DeviceReactor::HandleReadable(Channel &channel, ResponseMatcher::Callbacks &callbacks)
+{
+    uint8_t buffer[READ_SIZE];
+
+    for (int i = 0; i < MAX_READS_PER_TURN; i++)
+    {
+        size_t bytesRead = 0;
+        IoStatus status = channel.transport.Read(buffer, READ_SIZE, bytesRead, 0);
+        if (status == IoStatus::OK)
+        {
+            channel.matcher.Feed(buffer, bytesRead, callbacks);
+            continue;
+        }
+
+        if (status == IoStatus::CLOSED)
+        {
+            channel.closing = true;
+            channel.closeReason = "Device disconnected";
+        }
+        else if (status == IoStatus::ERR)
+        {
+            channel.closing = true;
+            channel.closeReason = "Device read failed: " + std::to_string(channel.transport.LastError());
+        }
+        break;
+    }
+}
+
+void DeviceReactor::Flush(Channel &channel, Events &events)
+{
+    size_t budget = MAX_WRITE_PER_TURN;
+
+    while (!channel.queue.empty() && budget > 0)
+    {
+        Job &job = channel.queue.front();
+
+        size_t chunk = std::min(budget, job.length - job.offset);
+        size_t bytesWritten = 0;
+        IoStatus status = channel.transport.Write(job.data + job.offset, chunk, bytesWritten, 0);
+        job.offset += bytesWritten;
+        budget -= bytesWritten;
+
+        if (status == IoStatus::CLOSED || status == IoStatus::ERR)
+        {
+            channel.closing = true;
+            channel.closeReason = "Failed to write data: " + std::to_string(channel.transport.LastError());
+            return;
+        }
+
+        if (job.offset < job.length)
+        {
+            // 设备缓冲区已满 (TIMEOUT) 或本轮配额用完, 等待 EPOLLOUT 后继续
+            break;
+        }
+
+        if (job.timeoutMs < 0)
+        {
+            events.push_back(Event{EventType::SENT, channel.id, job.id, nullptr, std::string(), job.context});
+        }
+        else
+        {
+            // 命令写完最后一个字节才登记: 超时从写完开始计算, 最终事件也不会早于数据写完
+            // (调用方在最终事件后就会释放 data). 队列按顺序写出, 登记顺序与写入顺序一致
+            uint64_t jobId = job.id;
+            int device = channel.id;
+            void *context = job.context;
+            channel.matcher.Register(
+                job.framing, Clock::now() + std::chrono::milliseconds(job.timeoutMs),
+                [this, jobId, device, context](ResponseMatcher::Result result, std::vector<uint8_t> *response,
+                                                const std::string &error) {
+                    Event event{result == ResponseMatcher::Result::OK ? EventType::RESPONSE : EventType::ERR,
+                                device, jobId, response, error, context};
+                    handler(event);
+                },
+                ResponseMatcher::EchoPrefix(job.data, job.length));
+        }
+        channel.queue.pop_front();
+    }
+
+    UpdateInterest(channel, !channel.queue.empty());
+}
+
+void DeviceReactor::UpdateInterest(Channel &channel, bool wantWrite)
+{
+    if (channel.wantWrite == wantWrite)
+    {
+        return;
+    }
+
+    struct epoll_event ev;
+    ev.events = wantWrite ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    ev.data.u64 = static_cast<uint64_t>(channel.id);
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, channel.transport.Fd(), &ev);
+    channel.wantWrite = wantWrite;
+}
+
+void DeviceReactor::Teardown(Channel &channel, Events &events, ResponseMatcher::Callbacks &callbacks)
+{
+    // 已写完并登记的命令由 FailAll 结束, 队列中 (未写完) 的作业在这里结束
+    for (const Job &job : channel.queue)
+    {
+        events.push_back(Event{EventType::ERR, channel.id, job.id, nullptr, channel.closeReason, job.context});
+    }
+    channel.queue.clear();
+    channel.matcher.FailAll(ResponseMatcher::Result::CLOSED, channel.closeReason, callbacks);
+
+    if (channel.transport.IsOpen())
+    {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, channel.transport.Fd(), nullptr);
+        channel.transport.Close();
+    }
+    events.push_back(Event{EventType::CLOSED, channel.id, 0, nullptr, channel.closeReason, nullptr});
+}
+
+void DeviceReactor::Dispatch(Events &events, ResponseMatcher::Callbacks &callbacks)
+{
+    // 先完成命令回调, 最后才是 CLOSED 等事件, 保证每个设备的 CLOSED 是它的最后一个事件
+    for (auto &callback : callbacks)
+    {
+        callback();
+    }
+    for (Event &event : events)
+    {
+        handler(event);
+    }
+}
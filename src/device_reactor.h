@@ -0,0 +1,109 @@
+#pragma once
+#include "response_matcher.h"
+#include "transport_posix.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 多设备 I/O 反应器 (Linux)
+// 一个事件循环线程通过 epoll 为所有打开的设备完成读写: 每个设备有自己的发送队列和
+// ResponseMatcher, 写入和读取都是非阻塞的, 没有"每个设备一个线程"和 sleep 轮询.
+// 设备可以是 /dev/usb/lp*, 也可以是 pty 等任意字符设备 (便于在没有硬件时测试).
+class DeviceReactor {
+public:
+    enum class EventType {
+        SENT,       // 数据作业已全部写出
+        RESPONSE,   // 命令收到响应
+        DATA,       // 没有命令等待时收到的数据
+        ERR,        // 作业失败 (超时, 写入失败, 设备关闭)
+        CLOSED      // 设备已关闭 (主动关闭或被拔出), 每个设备只发送一次
+    };
+
+    struct Event {
+        EventType type;
+        int device;
+        uint64_t job;                 // 作业事件的编号, 其他事件为 0
+        std::vector<uint8_t> *data;   // 来自 BufferPool, 所有权交给事件处理函数; 可能为 nullptr
+        std::string error;
+        void *context;                // Submit 时传入的调用方数据, 随作业的最终事件返回
+    };
+
+    // 在事件循环线程上调用; 每个作业恰好收到一个最终事件 (SENT / RESPONSE / ERR)
+    typedef std::function<void(Event &event)> EventFn;
+
+    // 每个设备每轮最多写出的字节数, 防止一个大作业占满事件循环
+    static const size_t MAX_WRITE_PER_TURN = 64 * 1024;
+
+    explicit DeviceReactor(EventFn handler);
+    ~DeviceReactor();
+
+    bool Start(std::string &error);
+
+    // 停止事件循环, 关闭所有设备, 未完成的作业以 ERR 结束
+    void Stop();
+
+    // 打开设备并加入事件循环, 返回设备编号 (>0), 失败返回 -1
+    int Open(const std::string &path, std::string &error);
+
+    // 请求关闭设备; 队列中的作业以 ERR 结束, 随后发送 CLOSED 事件
+    bool Close(int device);
+
+    // 把数据排入设备的发送队列, 返回作业编号; 设备不存在时返回 0.
+    // data 在作业的最终事件之前必须保持有效. timeoutMs < 0 表示只写出不等待响应
+    uint64_t Submit(int device, const uint8_t *data, size_t length, int timeoutMs,
+                    ResponseMatcher::Framing framing, void *context);
+
+    size_t DeviceCount();
+
+private:
+    typedef ResponseMatcher::Clock Clock;
+
+    struct Job {
+        uint64_t id;
+        const uint8_t *data;
+        size_t length;
+        size_t offset;
+        int timeoutMs;
+        ResponseMatcher::Framing framing;
+        void *context;
+    };
+
+    struct Channel {
+        int id;
+        PosixTransport transport;
+        std::deque<Job> queue;
+        ResponseMatcher matcher;
+        bool wantWrite = false;      // 已注册 EPOLLOUT
+        bool closing = false;
+        std::string closeReason;
+    };
+
+    typedef std::vector<Event> Events;
+
+    void Loop();
+    void Wake();
+    void HandleReadable(Channel &channel, ResponseMatcher::Callbacks &callbacks);
+    void Flush(Channel &channel, Events &events);
+    void UpdateInterest(Channel &channel, bool wantWrite);
+    void Teardown(Channel &channel, Events &events, ResponseMatcher::Callbacks &callbacks);
+    void Dispatch(Events &events, ResponseMatcher::Callbacks &callbacks);
+
+    EventFn handler;
+    int epollFd;
+    int wakeFd;
+
+    std::mutex stateMutex;
+    std::map<int, std::unique_ptr<Channel>> channels;
+    int nextDevice;
+    uint64_t nextJob;
+
+    std::thread loopThread;
+    std::atomic<bool> running;
+};
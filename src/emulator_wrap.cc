@@ -0,0 +1,110 @@
+#include "emulator_wrap.h"
+#include "addon_data.h"
+
+Napi::Object EmulatorWrap::Init(Napi::Env env, Napi::Object exports)
+{
+    Napi::HandleScope scope(env);
+
+    Napi::Function func = DefineClass(env, "CutterEmulator", {
+        InstanceMethod("getPath", &EmulatorWrap::GetPath),
+        InstanceMethod("getStats", &EmulatorWrap::GetStats),
+        InstanceMethod("close", &EmulatorWrap::Close)
+    });
+
+    AddonData::Get(env).cutterEmulator = Napi::Persistent(func);
+
+    exports.Set("CutterEmulator", func);
+    return exports;
+}
+
+EmulatorWrap::EmulatorWrap(const Napi::CallbackInfo &info)
+    : Napi::ObjectWrap<EmulatorWrap>(info)
+{
+    Napi::Env env = info.Env();
+
+    EmulatorOptions options;
+    if (info.Length() >= 1 && info[0].IsObject())
+    {
+        Napi::Object object = info[0].As<Napi::Object>();
+        if (object.Has("latency"))
+        {
+            options.latencyMs = object.Get("latency").ToNumber().Int32Value();
+        }
+        if (object.Has("jitter"))
+        {
+            options.jitterMs = object.Get("jitter").ToNumber().Int32Value();
+        }
+        if (object.Has("bandwidth"))
+        {
+            options.bandwidth = object.Get("bandwidth").ToNumber().DoubleValue();
+        }
+        if (object.Has("productId"))
+        {
+            options.productId = static_cast<uint16_t>(object.Get("productId").ToNumber().Uint32Value());
+        }
+    }
+
+    if (options.latencyMs < 0 || options.jitterMs < 0 || options.bandwidth < 0)
+    {
+        Napi::RangeError::New(env, "latency, jitter and bandwidth must not be negative").ThrowAsJavaScriptException();
+        return;
+    }
+
+    emulator.reset(new CutterEmulator(options));
+    std::string error;
+    if (!emulator->Start(error))
+    {
+        emulator.reset();
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return;
+    }
+
+    cleanupHook = env.AddCleanupHook(&EmulatorWrap::OnEnvCleanup, this);
+}
+
+EmulatorWrap::~EmulatorWrap()
+{
+    if (!cleanupHook.IsEmpty())
+    {
+        cleanupHook.Remove(Env());
+    }
+}
+
+void EmulatorWrap::OnEnvCleanup(EmulatorWrap *wrap)
+{
+    // 钩子调用后即被删除, 析构时不能再移除
+    wrap->cleanupHook = CleanupHook();
+    wrap->emulator.reset();
+}
+
+Napi::Value EmulatorWrap::GetPath(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (!emulator)
+    {
+        return env.Null();
+    }
+    return Napi::String::New(env, emulator->Path());
+}
+
+Napi::Value EmulatorWrap::GetStats(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    EmulatorStats stats = {};
+    if (emulator)
+    {
+        stats = emulator->Stats();
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("bytesReceived", Napi::Number::New(env, static_cast<double>(stats.bytesReceived)));
+    result.Set("commands", Napi::Number::New(env, static_cast<double>(stats.commands)));
+    result.Set("jobs", Napi::Number::New(env, static_cast<double>(stats.jobs)));
+    return result;
+}
+
+Napi::Value EmulatorWrap::Close(const Napi::CallbackInfo &info)
+{
+    emulator.reset();
+    return info.Env().Undefined();
+}
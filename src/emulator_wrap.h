@@ -0,0 +1,28 @@
+#pragma once
+#include <napi.h>
+#include "cutter_emulator.h"
+#include <memory>
+
+// 刻字机模拟器的 JS 接口 (非 Windows), 用于测试和性能基准:
+//   new CutterEmulator({ latency, jitter, bandwidth, productId })
+//   getPath() -> pty 路径, 交给 UsbDevice.connectPath()
+//   getStats() -> { bytesReceived, commands, jobs }
+//   close()
+class EmulatorWrap : public Napi::ObjectWrap<EmulatorWrap> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    EmulatorWrap(const Napi::CallbackInfo &info);
+    ~EmulatorWrap();
+
+private:
+    typedef Napi::Env::CleanupHook<void (*)(EmulatorWrap *), EmulatorWrap> CleanupHook;
+
+    static void OnEnvCleanup(EmulatorWrap *wrap);
+
+    Napi::Value GetPath(const Napi::CallbackInfo &info);
+    Napi::Value GetStats(const Napi::CallbackInfo &info);
+    Napi::Value Close(const Napi::CallbackInfo &info);
+
+    std::unique_ptr<CutterEmulator> emulator;
+    CleanupHook cleanupHook;   // 环境销毁时停止模拟器线程
+};
@@ -0,0 +1,145 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// 有界无锁队列 (Vyukov MPMC 环形队列, 这里用作多生产者单消费者)
+// 槽位预先分配并循环使用, 事件对象本身就是池: 生产者就地填充槽位中的对象,
+// 消费者处理完后槽位直接回到可写状态, 入队出队都不分配内存. 队列满时 Push 失败而不是阻塞.
+template <typename T>
+class EventQueue {
+public:
+    // capacity 向上取整为 2 的幂
+    explicit EventQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        mask = size - 1;
+        cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueuePos.store(0, std::memory_order_relaxed);
+        dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    EventQueue(const EventQueue &) = delete;
+    EventQueue &operator=(const EventQueue &) = delete;
+
+    // 取得一个空槽位并调用 fill(T&) 填充; 队列已满时返回 false
+    template <typename Fill>
+    bool Push(Fill fill)
+    {
+        Cell *cell;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell = &cells[pos & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        fill(cell->value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 单消费者: 依次对已提交的事件调用 consume(T&), 最多 maxItems 个; 返回处理的个数
+    template <typename Consume>
+    size_t Drain(Consume consume, size_t maxItems)
+    {
+        size_t count = 0;
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        while (count < maxItems)
+        {
+            Cell *cell = &cells[pos & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1) < 0)
+            {
+                break;
+            }
+
+            consume(cell->value);
+            cell->sequence.store(pos + mask + 1, std::memory_order_release);
+            pos++;
+            count++;
+        }
+        dequeuePos.store(pos, std::memory_order_relaxed);
+        return count;
+    }
+
+    size_t Capacity() const { return mask + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) std::atomic<size_t> dequeuePos;
+};
+
+// 单写者的"最新值" (seqlock): 写者从不等待, 读者在写入过程中重试.
+// 用于合并高频状态 (例如进度), 只有最后一次写入会被送到 JS.
+template <typename T>
+class LatestValue {
+public:
+    LatestValue()
+        : sequence(0)
+    {
+    }
+
+    void Store(const T &newValue)
+    {
+        size_t s = sequence.load(std::memory_order_relaxed);
+        sequence.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        value = newValue;
+        sequence.store(s + 2, std::memory_order_release);
+    }
+
+    T Load() const
+    {
+        for (;;)
+        {
+            size_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                continue;
+            }
+            T copy = value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before)
+            {
+                return copy;
+            }
+        }
+    }
+
+private:
+    std::atomic<size_t> sequence;
+    T value;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include "chunk_source.h"
+#include "mapped_file.h"
+#include <string>
+
+// 磁盘上的 PLT 文件 (sendPltFile)
+// 只读映射整个文件, 发送线程直接从映射页切块写入设备, 作业不会复制到 JS 堆或中间缓冲区;
+// 占用的只是内核页缓存, 内存紧张时可以回收, 因此作业大小不影响进程内存.
+class MappedFileSource : public ChunkSource {
+public:
+    MappedFileSource()
+        : offset(0)
+    {
+    }
+
+    bool Open(const std::string &path, std::string &error)
+    {
+        if (!file.OpenRead(path, error))
+        {
+            return false;
+        }
+        file.AdviseSequential();
+        offset = 0;
+        return true;
+    }
+
+    uint64_t Size() const override
+    {
+        return file.Size();
+    }
+
+    size_t Read(uint8_t *dst, size_t max) override
+    {
+        size_t remaining = file.Size() - offset;
+        size_t n = max < remaining ? max : remaining;
+        if (n > 0)
+        {
+            memcpy(dst, file.Data() + offset, n);
+            offset += n;
+        }
+        return n;
+    }
+
+    const uint8_t *Data() const override
+    {
+        return file.Data();
+    }
+
+private:
+    MappedFile file;
+    size_t offset;
+};
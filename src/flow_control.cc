@@ -0,0 +1,194 @@
+#include "flow_control.h"
+#include <algorithm>
+
+namespace {
+
+// 没有观测到阻塞时, 每个暂停周期把排空速度上调的比例: 从 RATE_PROBE 开始,
+// 连续没有阻塞时逐次加倍 (最多 RATE_PROBE_MAX), 发生阻塞后回到初值
+const double RATE_PROBE = 0.02;
+const double RATE_PROBE_MAX = 0.25;
+
+// 计算速度样本的最短观测时间 (微秒), 更短的间隔误差太大
+const int64_t MIN_SAMPLE_US = 10000;
+
+} // namespace
+
+FlowController::FlowController(const FlowProfile &profile)
+    : profile(profile),
+      level(0),
+      levelAt(0),
+      drainRate(profile.drainRate > 0 ? profile.drainRate : 0),
+      probe(RATE_PROBE),
+      paused(false),
+      lastStallUs(0),
+      bytesSinceStall(0),
+      lastStatusUs(0),
+      lastStatusLevel(0),
+      bytesSinceStatus(0),
+      pauses(0),
+      stalls(0)
+{
+    if (this->profile.lowWatermark > this->profile.highWatermark)
+    {
+        this->profile.lowWatermark = this->profile.highWatermark;
+    }
+}
+
+void FlowController::Advance(int64_t nowUs)
+{
+    if (levelAt != 0 && nowUs > levelAt && drainRate > 0)
+    {
+        level = std::max(0.0, level - drainRate * static_cast<double>(nowUs - levelAt) / 1e6);
+    }
+    if (nowUs > levelAt)
+    {
+        levelAt = nowUs;
+    }
+}
+
+double FlowController::Level(int64_t nowUs) const
+{
+    if (levelAt == 0 || nowUs <= levelAt || drainRate <= 0)
+    {
+        return level;
+    }
+    return std::max(0.0, level - drainRate * static_cast<double>(nowUs - levelAt) / 1e6);
+}
+
+void FlowController::AddSample(double rate)
+{
+    // 两次"已满"或两次查询之间的平均速度是直接测量值, 不再平滑
+    if (rate > 0)
+    {
+        drainRate = rate;
+    }
+}
+
+int64_t FlowController::DelayBefore(size_t length, int64_t nowUs)
+{
+    // 速度未知时无法预测何时有空间, 交给写入阻塞节流, 同时从阻塞中学习速度
+    if (!Enabled() || drainRate <= 0)
+    {
+        return 0;
+    }
+
+    Advance(nowUs);
+    double high = profile.bufferSize * profile.highWatermark;
+    double low = profile.bufferSize * profile.lowWatermark;
+
+    if (!paused && level + static_cast<double>(length) > high)
+    {
+        paused = true;
+        pauses++;
+    }
+    if (!paused)
+    {
+        return 0;
+    }
+
+    if (level > low)
+    {
+        return static_cast<int64_t>((level - low) / drainRate * 1e6) + 1;
+    }
+
+    // 已降到低水位: 这一轮没有被写入阻塞过, 说明设备至少有当前估计的速度, 试探性地上调
+    paused = false;
+    drainRate *= 1.0 + probe;
+    probe = std::min(probe * 2, RATE_PROBE_MAX);
+    return 0;
+}
+
+void FlowController::OnWrite(size_t length, int64_t startUs, int64_t endUs)
+{
+    if (!Enabled())
+    {
+        return;
+    }
+
+    Advance(startUs);
+    level += static_cast<double>(length);
+    Advance(endUs);
+    bytesSinceStall += length;
+    bytesSinceStatus += length;
+
+    if (endUs - startUs < STALL_US)
+    {
+        return;
+    }
+
+    // 写入被挡住: 缓冲区此刻是满的, 两次满之间写入的数据都已被设备消费
+    stalls++;
+    probe = RATE_PROBE;
+    if (lastStallUs == 0)
+    {
+        // 第一次阻塞: 速度未知时用这次写入本身的速度作为初值
+        if (drainRate <= 0)
+        {
+            AddSample(static_cast<double>(length) * 1e6 / static_cast<double>(endUs - startUs));
+        }
+        lastStallUs = endUs;
+        bytesSinceStall = 0;
+    }
+    else if (endUs - lastStallUs >= MIN_SAMPLE_US)
+    {
+        // 间隔太短时不取样, 继续累积到下一次阻塞 (起点仍是"已满"的时刻)
+        AddSample(static_cast<double>(bytesSinceStall) * 1e6 / static_cast<double>(endUs - lastStallUs));
+        lastStallUs = endUs;
+        bytesSinceStall = 0;
+    }
+    level = profile.bufferSize;
+    levelAt = endUs;
+}
+
+bool FlowController::StatusDue(int64_t nowUs) const
+{
+    if (!Enabled() || profile.statusCommand.empty())
+    {
+        return false;
+    }
+    return lastStatusUs == 0 || nowUs - lastStatusUs >= static_cast<int64_t>(profile.statusInterval) * 1000;
+}
+
+void FlowController::OnStatus(uint64_t freeBytes, int64_t nowUs)
+{
+    double reported = freeBytes >= profile.bufferSize ? 0.0 : static_cast<double>(profile.bufferSize - freeBytes);
+
+    // 上次查询以来: 排出量 = 上次占用 + 写入量 - 本次占用
+    if (lastStatusUs != 0 && nowUs - lastStatusUs >= MIN_SAMPLE_US)
+    {
+        double drained = lastStatusLevel + static_cast<double>(bytesSinceStatus) - reported;
+        // 缓冲区被排空时排出量只是下限, 不能作为速度样本
+        if (reported > 0)
+        {
+            AddSample(drained * 1e6 / static_cast<double>(nowUs - lastStatusUs));
+        }
+    }
+
+    lastStatusUs = nowUs;
+    lastStatusLevel = reported;
+    bytesSinceStatus = 0;
+    level = reported;
+    levelAt = nowUs;
+}
+
+bool FlowController::ParseStatus(const uint8_t *data, size_t length, uint64_t &freeBytes)
+{
+    size_t i = 0;
+    while (i < length && (data[i] < '0' || data[i] > '9'))
+    {
+        i++;
+    }
+    if (i == length)
+    {
+        return false;
+    }
+
+    uint64_t value = 0;
+    while (i < length && data[i] >= '0' && data[i] <= '9')
+    {
+        value = value * 10 + (data[i] - '0');
+        i++;
+    }
+    freeBytes = value;
+    return true;
+}
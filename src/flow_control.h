@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 设备流控参数 (setFlowControl)
+struct FlowProfile {
+    uint32_t bufferSize = 0;       // 设备接收缓冲区字节数, 0 表示不做流控 (只靠写入阻塞)
+    double highWatermark = 0.9;    // 估计的缓冲区占用超过 bufferSize * highWatermark 时暂停写入
+    double lowWatermark = 0.5;     // 暂停后降到 bufferSize * lowWatermark 再继续
+    double drainRate = 0;          // 已知的设备消费速度 (字节/秒), 0 表示根据写入阻塞自动估计
+    std::string statusCommand;     // 可选: 查询缓冲区剩余空间的命令, 响应中的第一个整数为剩余字节数
+    int statusInterval = 200;      // 作业进行中查询的最小间隔 (毫秒)
+};
+
+// 设备缓冲区占用的估计与写入节奏控制
+// 把设备缓冲区看作以 drainRate 匀速排空的水桶: 每次写入加水, 随时间排出.
+// 占用超过高水位时暂停, 按估计的速度等到低水位再继续, 这样既不会写满设备, 也不会让设备空等.
+// 排空速度的来源 (按可信程度):
+//   1. 状态查询: 两次查询之间的排出量 / 时间, 同时直接校正占用
+//   2. 写入阻塞: 写入被内核挡住说明缓冲区已满, 两次"已满"之间写入的字节数 / 时间
+//   3. 没有观测到阻塞时每个暂停周期把估计值上调一点 (连续没有阻塞时加快), 逐步逼近设备的真实速度
+// 所有时间为单调时钟微秒数, 由调用方传入; 只在发送线程上使用, 不加锁.
+class FlowController {
+public:
+    explicit FlowController(const FlowProfile &profile);
+
+    bool Enabled() const { return profile.bufferSize > 0; }
+
+    // 写入 length 字节前需要等待的微秒数, 0 表示可以立即写入
+    int64_t DelayBefore(size_t length, int64_t nowUs);
+
+    // 一次写入完成, startUs/endUs 为写入开始与结束时刻
+    void OnWrite(size_t length, int64_t startUs, int64_t endUs);
+
+    // 是否该发送一次状态查询
+    bool StatusDue(int64_t nowUs) const;
+
+    // 状态查询的结果: 设备报告的剩余空间
+    void OnStatus(uint64_t freeBytes, int64_t nowUs);
+
+    // 从状态查询响应中取出剩余字节数 (第一个十进制整数); 没有数字时返回 false
+    static bool ParseStatus(const uint8_t *data, size_t length, uint64_t &freeBytes);
+
+    double Level(int64_t nowUs) const;
+    double DrainRate() const { return drainRate; }
+
+    uint64_t Pauses() const { return pauses; }
+    uint64_t Stalls() const { return stalls; }
+
+    // 写入阻塞超过这个时间 (微秒) 视为设备缓冲区已满
+    static constexpr int64_t STALL_US = 2000;
+
+private:
+    void Advance(int64_t nowUs);
+    void AddSample(double rate);
+
+    FlowProfile profile;
+    double level;            // 估计的缓冲区占用 (字节), 对应时刻 levelAt
+    int64_t levelAt;
+    double drainRate;        // 估计的排空速度 (字节/秒), 0 表示未知
+    double probe;            // 下一次上调排空速度的比例
+    bool paused;             // 已超过高水位, 等待降到低水位
+
+    int64_t lastStallUs;     // 上一次写入阻塞的时刻, 0 表示还没有
+    uint64_t bytesSinceStall;
+
+    int64_t lastStatusUs;    // 上一次状态查询的时刻与当时的占用, 0 表示还没有
+    double lastStatusLevel;
+    uint64_t bytesSinceStatus;
+
+    uint64_t pauses;
+    uint64_t stalls;
+};
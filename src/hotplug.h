@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 一次热插拔变化 (与平台无关), 定长字段, 不分配内存
+struct HotplugChange {
+    bool arrival = false;      // true: 设备到达, false: 设备移除
+    bool hasIds = false;       // 是否得到了 VID/PID
+    uint16_t vendorId = 0;
+    uint16_t productId = 0;
+    char path[128] = {0};      // 设备路径 (/dev/usb/lpN 或 Windows 设备接口路径), 可能被截断
+};
+
+inline int HexDigitValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// 从 "...VID_0483&PID_5740..." 形式的文本中取出 VID/PID (不区分大小写), 代替 std::regex
+inline bool ParseVidPid(const char *text, uint16_t &vendorId, uint16_t &productId)
+{
+    bool hasVid = false;
+    bool hasPid = false;
+    for (const char *p = text; p[0] && p[1] && p[2] && p[3]; p++)
+    {
+        char c0 = static_cast<char>(p[0] & ~0x20);
+        char c1 = static_cast<char>(p[1] & ~0x20);
+        char c2 = static_cast<char>(p[2] & ~0x20);
+        if (p[3] != '_' || !((c0 == 'V' && c1 == 'I' && c2 == 'D') || (c0 == 'P' && c1 == 'I' && c2 == 'D')))
+        {
+            continue;
+        }
+
+        unsigned value = 0;
+        int digits = 0;
+        for (; digits < 4; digits++)
+        {
+            int d = HexDigitValue(p[4 + digits]);
+            if (d < 0)
+            {
+                break;
+            }
+            value = value * 16 + static_cast<unsigned>(d);
+        }
+        if (digits != 4)
+        {
+            continue;
+        }
+
+        if (c0 == 'V' && !hasVid)
+        {
+            vendorId = static_cast<uint16_t>(value);
+            hasVid = true;
+        }
+        else if (c0 == 'P' && !hasPid)
+        {
+            productId = static_cast<uint16_t>(value);
+            hasPid = true;
+        }
+        p += 3 + digits;
+    }
+    return hasVid && hasPid;
+}
+
+// 写出 4 位大写十六进制 (含结尾 '\0'), 与 Windows 硬件 ID 中的格式一致
+inline void FormatHex4(uint16_t value, char out[5])
+{
+    static const char DIGITS[] = "0123456789ABCDEF";
+    out[0] = DIGITS[(value >> 12) & 0xF];
+    out[1] = DIGITS[(value >> 8) & 0xF];
+    out[2] = DIGITS[(value >> 4) & 0xF];
+    out[3] = DIGITS[value & 0xF];
+    out[4] = '\0';
+}
+
+inline void CopyPath(char (&dst)[128], const char *src, size_t length)
+{
+    if (length >= sizeof(dst))
+    {
+        length = sizeof(dst) - 1;
+    }
+    memcpy(dst, src, length);
+    dst[length] = '\0';
+}
@@ -0,0 +1,204 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// HDR 风格的延迟直方图 (单位: 微秒)
+// 每个 2 的幂区间再等分为 SUB_BUCKETS 格, 相对误差不超过 1/SUB_BUCKETS; 小于 2*SUB_BUCKETS 的值精确记录.
+// 所有计数都是原子的, 多个线程可以同时 Record, 不加锁也不分配内存.
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_EXPONENT = 40;   // 超过 2^40 微秒 (约 12 天) 的值记在最后一格
+    static const int BUCKET_COUNT = 2 * SUB_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS - 1) * SUB_BUCKETS;
+
+    struct Snapshot {
+        uint64_t count;
+        uint64_t min;
+        uint64_t max;
+        double mean;
+        uint64_t p50;
+        uint64_t p90;
+        uint64_t p99;
+        uint64_t p999;
+    };
+
+    LatencyHistogram()
+    {
+        Reset();
+    }
+
+    void Record(uint64_t micros)
+    {
+        counts[BucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(micros, std::memory_order_relaxed);
+
+        uint64_t current = minValue.load(std::memory_order_relaxed);
+        while (micros < current && !minValue.compare_exchange_weak(current, micros, std::memory_order_relaxed))
+        {
+        }
+        current = maxValue.load(std::memory_order_relaxed);
+        while (micros > current && !maxValue.compare_exchange_weak(current, micros, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // 与 Record 并发时得到的是近似一致的快照
+    void Reset()
+    {
+        for (int i = 0; i < BUCKET_COUNT; i++)
+        {
+            counts[i].store(0, std::memory_order_relaxed);
+        }
+        sum.store(0, std::memory_order_relaxed);
+        minValue.store(UINT64_MAX, std::memory_order_relaxed);
+        maxValue.store(0, std::memory_order_relaxed);
+    }
+
+    // 百分位数取所在格的上界 (不超过最大值), 没有样本时全部为 0
+    Snapshot Read() const
+    {
+        Snapshot snapshot = {};
+        uint64_t bucketCounts[BUCKET_COUNT];
+        uint64_t count = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++)
+        {
+            bucketCounts[i] = counts[i].load(std::memory_order_relaxed);
+            count += bucketCounts[i];
+        }
+        if (count == 0)
+        {
+            return snapshot;
+        }
+
+        snapshot.count = count;
+        snapshot.min = minValue.load(std::memory_order_relaxed);
+        snapshot.max = maxValue.load(std::memory_order_relaxed);
+        snapshot.mean = static_cast<double>(sum.load(std::memory_order_relaxed)) / static_cast<double>(count);
+
+        const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+        uint64_t *results[] = {&snapshot.p50, &snapshot.p90, &snapshot.p99, &snapshot.p999};
+        uint64_t seen = 0;
+        int q = 0;
+        for (int i = 0; i < BUCKET_COUNT && q < 4; i++)
+        {
+            seen += bucketCounts[i];
+            while (q < 4 && static_cast<double>(seen) >= quantiles[q] * static_cast<double>(count))
+            {
+                uint64_t value = BucketUpperBound(i);
+                *results[q] = value < snapshot.max ? value : snapshot.max;
+                q++;
+            }
+        }
+        return snapshot;
+    }
+
+    static int BucketIndex(uint64_t value)
+    {
+        if (value < static_cast<uint64_t>(2 * SUB_BUCKETS))
+        {
+            return static_cast<int>(value);
+        }
+
+        const uint64_t limit = (static_cast<uint64_t>(1) << MAX_EXPONENT) - 1;
+        if (value > limit)
+        {
+            value = limit;
+        }
+
+        int top = HighestBit(value);
+        int shift = top - SUB_BUCKET_BITS;
+        int mantissa = static_cast<int>(value >> shift);   // [SUB_BUCKETS, 2*SUB_BUCKETS)
+        return 2 * SUB_BUCKETS + (top - SUB_BUCKET_BITS - 1) * SUB_BUCKETS + (mantissa - SUB_BUCKETS);
+    }
+
+    static uint64_t BucketUpperBound(int index)
+    {
+        if (index < 2 * SUB_BUCKETS)
+        {
+            return static_cast<uint64_t>(index);
+        }
+
+        int offset = index - 2 * SUB_BUCKETS;
+        int top = SUB_BUCKET_BITS + 1 + offset / SUB_BUCKETS;
+        uint64_t mantissa = static_cast<uint64_t>(SUB_BUCKETS + offset % SUB_BUCKETS);
+        int shift = top - SUB_BUCKET_BITS;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+private:
+    static int HighestBit(uint64_t value)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    std::atomic<uint64_t> counts[BUCKET_COUNT];
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> minValue;
+    std::atomic<uint64_t> maxValue;
+};
+
+// 一个设备的 I/O 统计, 由 I/O 路径直接更新, 由 getStats() 读取
+struct IoStats {
+    typedef std::chrono::steady_clock Clock;
+
+    LatencyHistogram write;       // 单次 Transport::Write (命令或 PLT 分块) 的耗时
+    LatencyHistogram firstByte;   // 命令写完到收到第一个字节
+    LatencyHistogram roundTrip;   // 命令从提交到收到完整响应
+
+    std::atomic<uint64_t> bytesOut;
+    std::atomic<uint64_t> bytesIn;
+    std::atomic<uint64_t> timeouts;   // 超时未收到响应的命令
+    std::atomic<uint64_t> errors;     // 写入失败或因设备断开而失败的命令、PLT 分块
+
+    // PLT 流控 (setFlowControl)
+    std::atomic<uint64_t> pauses;     // 估计的设备缓冲区超过高水位而暂停的次数
+    std::atomic<uint64_t> pausedUs;   // 暂停等待的总时间
+    std::atomic<uint64_t> stalls;     // 写入被阻塞 (设备缓冲区已满) 的次数
+    std::atomic<double> drainRate;    // 最近估计的设备消费速度 (字节/秒)
+
+    std::atomic<int64_t> resetAtUs;   // 上次清零的时刻, 用于计算吞吐
+
+    IoStats()
+        : bytesOut(0), bytesIn(0), timeouts(0), errors(0),
+          pauses(0), pausedUs(0), stalls(0), drainRate(0), resetAtUs(NowUs())
+    {
+    }
+
+    void Reset()
+    {
+        write.Reset();
+        firstByte.Reset();
+        roundTrip.Reset();
+        bytesOut = 0;
+        bytesIn = 0;
+        timeouts = 0;
+        errors = 0;
+        pauses = 0;
+        pausedUs = 0;
+        stalls = 0;
+        drainRate = 0;
+        resetAtUs = NowUs();
+    }
+
+    static int64_t NowUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    static uint64_t MicrosSince(Clock::time_point start)
+    {
+        int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+        return micros > 0 ? static_cast<uint64_t>(micros) : 0;
+    }
+};
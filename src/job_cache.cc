@@ -0,0 +1,600 @@
+#include "job_cache.h"
+#include "logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+namespace {
+
+// XXH64 (xxHash 的 64 位版本), 每字节不到一个周期, 比读入作业本身还快; 不需要抗碰撞, 不用加密散列
+const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t Rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+// 按小端读取 (与 xxHash 参考实现一致)
+inline uint64_t Read64(const uint8_t *p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--)
+    {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+inline uint32_t Read32(const uint8_t *p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint64_t Round(uint64_t acc, uint64_t input)
+{
+    acc += input * PRIME64_2;
+    acc = Rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+inline uint64_t MergeRound(uint64_t acc, uint64_t val)
+{
+    acc ^= Round(0, val);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+uint64_t Xxh64(const uint8_t *p, size_t length, uint64_t seed)
+{
+    const uint8_t *end = p + length;
+    uint64_t h;
+
+    if (length >= 32)
+    {
+        const uint8_t *limit = end - 32;
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        do
+        {
+            v1 = Round(v1, Read64(p));
+            v2 = Round(v2, Read64(p + 8));
+            v3 = Round(v3, Read64(p + 16));
+            v4 = Round(v4, Read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = Rotl64(v1, 1) + Rotl64(v2, 7) + Rotl64(v3, 12) + Rotl64(v4, 18);
+        h = MergeRound(h, v1);
+        h = MergeRound(h, v2);
+        h = MergeRound(h, v3);
+        h = MergeRound(h, v4);
+    }
+    else
+    {
+        h = seed + PRIME64_5;
+    }
+
+    h += static_cast<uint64_t>(length);
+
+    while (p + 8 <= end)
+    {
+        h ^= Round(0, Read64(p));
+        h = Rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end)
+    {
+        h ^= static_cast<uint64_t>(Read32(p)) * PRIME64_1;
+        h = Rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    while (p < end)
+    {
+        h ^= (*p) * PRIME64_5;
+        h = Rotl64(h, 11) * PRIME64_1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+const size_t KEY_LENGTH = 16;
+const char *const ENTRY_SUFFIX = ".plt";
+const char *const TEMP_SUFFIX = ".tmp";
+
+// 键只能是 16 位小写十六进制, 同时保证拼出的路径不会跑出缓存目录
+bool IsValidKey(const std::string &key)
+{
+    if (key.size() != KEY_LENGTH)
+    {
+        return false;
+    }
+    for (char c : key)
+    {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EndsWith(const std::string &s, const char *suffix)
+{
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+struct DirEntry {
+    std::string name;
+    uint64_t size;
+    int64_t mtime;
+};
+
+#ifdef _WIN32
+
+std::string SystemError(const std::string &what)
+{
+    return what + ": " + std::to_string(GetLastError());
+}
+
+bool MakeDir(const std::string &dir, std::string &error)
+{
+    if (!CreateDirectoryA(dir.c_str(), NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        error = SystemError("Failed to create " + dir);
+        return false;
+    }
+    return true;
+}
+
+std::vector<DirEntry> ListDir(const std::string &dir)
+{
+    std::vector<DirEntry> result;
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA((dir + "\\*").c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE)
+    {
+        return result;
+    }
+    do
+    {
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            continue;
+        }
+        DirEntry entry;
+        entry.name = data.cFileName;
+        entry.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        entry.mtime = static_cast<int64_t>((static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) |
+                                           data.ftLastWriteTime.dwLowDateTime);
+        result.push_back(entry);
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+    return result;
+}
+
+bool MoveIntoPlace(const std::string &from, const std::string &to, std::string &error)
+{
+    if (!MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING))
+    {
+        error = SystemError("Failed to rename " + from);
+        return false;
+    }
+    return true;
+}
+
+void TouchFile(const std::string &path)
+{
+    _utime(path.c_str(), NULL);
+}
+
+#else
+
+std::string SystemError(const std::string &what)
+{
+    return what + ": " + strerror(errno);
+}
+
+bool MakeDir(const std::string &dir, std::string &error)
+{
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        error = SystemError("Failed to create " + dir);
+        return false;
+    }
+    return true;
+}
+
+std::vector<DirEntry> ListDir(const std::string &dir)
+{
+    std::vector<DirEntry> result;
+    DIR *handle = opendir(dir.c_str());
+    if (!handle)
+    {
+        return result;
+    }
+    while (struct dirent *ent = readdir(handle))
+    {
+        struct stat info;
+        std::string path = dir + "/" + ent->d_name;
+        if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            continue;
+        }
+        DirEntry entry;
+        entry.name = ent->d_name;
+        entry.size = static_cast<uint64_t>(info.st_size);
+        entry.mtime = static_cast<int64_t>(info.st_mtime);
+        result.push_back(entry);
+    }
+    closedir(handle);
+    return result;
+}
+
+bool MoveIntoPlace(const std::string &from, const std::string &to, std::string &error)
+{
+    if (rename(from.c_str(), to.c_str()) != 0)
+    {
+        error = SystemError("Failed to rename " + from);
+        return false;
+    }
+    return true;
+}
+
+void TouchFile(const std::string &path)
+{
+    utime(path.c_str(), NULL);
+}
+
+#endif
+
+} // namespace
+
+// 发送缓存项的数据源: 持有只读映射, 析构时解除对该项的占用
+class JobCache::CachedSource : public MappedFileSource {
+public:
+    CachedSource(const std::string &dir, const std::string &key)
+        : dir(dir), key(key), holding(false)
+    {
+    }
+
+    ~CachedSource() override
+    {
+        if (holding)
+        {
+            JobCache::Shared().Release(dir, key);
+        }
+    }
+
+    // 计入占用之后才需要在析构时解除
+    void Hold()
+    {
+        holding = true;
+    }
+
+private:
+    std::string dir;
+    std::string key;
+    bool holding;
+};
+
+JobCache &JobCache::Shared()
+{
+    static JobCache instance;
+    return instance;
+}
+
+JobCache::JobCache()
+    : maxBytes(0),
+      totalBytes(0),
+      hits(0),
+      misses(0),
+      evictions(0),
+      tempCounter(0)
+{
+}
+
+std::string JobCache::Key(const uint8_t *source, size_t length, const std::string &options)
+{
+    // 先散列源作业, 再以其结果为种子散列变换参数
+    uint64_t hash = Xxh64(source, length, 0);
+    hash = Xxh64(reinterpret_cast<const uint8_t *>(options.data()), options.size(), hash);
+
+    char hex[KEY_LENGTH + 1];
+    snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    return hex;
+}
+
+bool JobCache::Configure(const std::string &newDir, uint64_t newMaxBytes, std::string &error)
+{
+    if (newDir.empty() || newMaxBytes == 0)
+    {
+        error = "Expected cache directory and maxBytes > 0";
+        return false;
+    }
+    if (!MakeDir(newDir, error))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    maxBytes = newMaxBytes;
+    if (newDir != dir)
+    {
+        dir = newDir;
+        Scan();
+    }
+    Evict();
+    return true;
+}
+
+bool JobCache::IsConfigured()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return !dir.empty();
+}
+
+std::string JobCache::PathOf(const std::string &key) const
+{
+    return dir + "/" + key + ENTRY_SUFFIX;
+}
+
+// 重建索引: 使用顺序取自文件修改时间 (Touch 在每次命中时更新), 并清理上次退出时残留的临时文件
+void JobCache::Scan()
+{
+    lru.clear();
+    entries.clear();
+    totalBytes = 0;
+
+    std::vector<DirEntry> files = ListDir(dir);
+    std::sort(files.begin(), files.end(), [](const DirEntry &a, const DirEntry &b) {
+        return a.mtime > b.mtime;
+    });
+
+    for (const DirEntry &file : files)
+    {
+        if (EndsWith(file.name, TEMP_SUFFIX))
+        {
+            std::remove((dir + "/" + file.name).c_str());
+            continue;
+        }
+        if (!EndsWith(file.name, ENTRY_SUFFIX))
+        {
+            continue;
+        }
+        std::string key = file.name.substr(0, file.name.size() - strlen(ENTRY_SUFFIX));
+        if (!IsValidKey(key) || file.size == 0)
+        {
+            continue;
+        }
+        lru.push_back(key);
+        Entry entry;
+        entry.size = file.size;
+        entry.lru = std::prev(lru.end());
+        entry.users = 0;
+        entries[key] = entry;
+        totalBytes += file.size;
+    }
+
+    LOG_INFO("Job cache %s: %zu entries, %llu bytes", dir.c_str(), entries.size(),
+             static_cast<unsigned long long>(totalBytes));
+}
+
+void JobCache::Touch(const std::string &key)
+{
+    Entry &entry = entries[key];
+    lru.splice(lru.begin(), lru, entry.lru);
+    TouchFile(PathOf(key));
+}
+
+void JobCache::Evict()
+{
+    // 最近使用的一项 (通常是刚写入的) 不淘汰; 其他项都在发送中时, 总大小可以暂时超过上限
+    if (lru.empty())
+    {
+        return;
+    }
+    auto it = lru.end();
+    while (totalBytes > maxBytes && std::prev(it) != lru.begin())
+    {
+        --it;
+        auto found = entries.find(*it);
+        if (found->second.users > 0)
+        {
+            continue;
+        }
+        // Windows 上删除失败 (例如文件被其他进程打开) 时保留索引, 下次再试
+        if (std::remove(PathOf(*it).c_str()) != 0)
+        {
+            continue;
+        }
+        LOG_DEBUG("Evicted cache entry %s (%llu bytes)", it->c_str(), static_cast<unsigned long long>(found->second.size));
+        totalBytes -= found->second.size;
+        entries.erase(found);
+        it = lru.erase(it);
+        evictions++;
+    }
+}
+
+bool JobCache::Put(const std::string &key, const uint8_t *data, size_t length, std::string &error)
+{
+    if (!IsValidKey(key))
+    {
+        error = "Invalid cache key";
+        return false;
+    }
+    if (length == 0)
+    {
+        error = "Empty job";
+        return false;
+    }
+
+    std::string targetDir;
+    std::string tempPath;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (dir.empty())
+        {
+            error = "Job cache not configured";
+            return false;
+        }
+        if (length > maxBytes)
+        {
+            error = "Job larger than cache limit";
+            return false;
+        }
+        if (entries.count(key))
+        {
+            Touch(key);
+            return true;
+        }
+        targetDir = dir;
+        tempPath = dir + "/" + key + "." + std::to_string(++tempCounter) + TEMP_SUFFIX;
+    }
+
+    // 写文件不持锁, 其他线程可以同时发送缓存中的作业
+    {
+        MappedFile file;
+        if (!file.OpenWrite(tempPath, length, error))
+        {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+        memcpy(file.Data(), data, length);
+    }
+
+    std::string path = targetDir + "/" + key + ENTRY_SUFFIX;
+    if (!MoveIntoPlace(tempPath, path, error))
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // 写入期间目录被改掉了: 文件留在旧目录, 下次配置回来时由 Scan 收录
+    if (dir != targetDir)
+    {
+        return true;
+    }
+    // 另一个线程同时写入了同一个键 (内容相同)
+    if (entries.count(key))
+    {
+        Touch(key);
+        return true;
+    }
+    lru.push_front(key);
+    Entry entry;
+    entry.size = length;
+    entry.lru = lru.begin();
+    entry.users = 0;
+    entries[key] = entry;
+    totalBytes += length;
+    Evict();
+    return true;
+}
+
+bool JobCache::Contains(const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.count(key) != 0;
+}
+
+std::unique_ptr<ChunkSource> JobCache::Open(const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end())
+    {
+        misses++;
+        return nullptr;
+    }
+
+    std::unique_ptr<CachedSource> source(new CachedSource(dir, key));
+    std::string error;
+    if (!source->Open(PathOf(key), error))
+    {
+        // 文件被外部删除: 从索引中去掉, 按未命中处理
+        LOG_WARN("Dropping cache entry %s: %s", key.c_str(), error.c_str());
+        totalBytes -= it->second.size;
+        lru.erase(it->second.lru);
+        entries.erase(it);
+        misses++;
+        return nullptr;
+    }
+
+    it->second.users++;
+    source->Hold();
+    Touch(key);
+    hits++;
+    return std::unique_ptr<ChunkSource>(source.release());
+}
+
+void JobCache::Release(const std::string &fromDir, const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fromDir != dir)
+    {
+        return;
+    }
+    auto it = entries.find(key);
+    if (it != entries.end() && it->second.users > 0)
+    {
+        it->second.users--;
+    }
+}
+
+bool JobCache::Remove(const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end() || it->second.users > 0)
+    {
+        return false;
+    }
+    if (std::remove(PathOf(key).c_str()) != 0)
+    {
+        return false;
+    }
+    totalBytes -= it->second.size;
+    lru.erase(it->second.lru);
+    entries.erase(it);
+    return true;
+}
+
+JobCache::Stats JobCache::GetStats()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats stats;
+    stats.dir = dir;
+    stats.maxBytes = maxBytes;
+    stats.totalBytes = totalBytes;
+    stats.entries = entries.size();
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.evictions = evictions;
+    return stats;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "file_source.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// 准备好的 PLT 作业的磁盘缓存 (按内容寻址)
+// 键是源作业内容和变换参数的 XXH64 (16 位十六进制), 值是准备好的作业字节, 每项一个 <key>.plt 文件.
+// 发送时只读映射缓存文件, 发送线程直接从映射页切块 (与 sendPltFile 相同), 重复的作业不必再做 JS 侧的准备.
+// 总大小超过上限时按最近使用顺序淘汰; 正在发送的项不会被淘汰.
+// 进程级共享: 各 JS 环境 (worker_threads) 使用同一个缓存目录和索引.
+class JobCache {
+public:
+    static JobCache &Shared();
+
+    // 源作业和变换参数 (序列化后的字符串) 的缓存键
+    static std::string Key(const uint8_t *source, size_t length, const std::string &options);
+
+    // 设置缓存目录 (不存在时创建) 和大小上限, 扫描目录中已有的缓存项;
+    // 目录改变时丢弃旧目录的索引 (文件保留在磁盘上)
+    bool Configure(const std::string &dir, uint64_t maxBytes, std::string &error);
+
+    bool IsConfigured();
+
+    // 写入一项: 先写临时文件再改名, 中途失败或进程退出不会留下不完整的缓存项.
+    // 键已存在时只更新使用顺序 (内容相同)
+    bool Put(const std::string &key, const uint8_t *data, size_t length, std::string &error);
+
+    bool Contains(const std::string &key);
+
+    // 打开一项用于发送, 返回的数据源析构前该项不会被淘汰; 不存在 (或文件已被外部删除) 时返回空并计入未命中
+    std::unique_ptr<ChunkSource> Open(const std::string &key);
+
+    // 删除一项 (正在发送时返回 false)
+    bool Remove(const std::string &key);
+
+    struct Stats {
+        std::string dir;
+        uint64_t maxBytes = 0;
+        uint64_t totalBytes = 0;
+        size_t entries = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+    Stats GetStats();
+
+private:
+    JobCache();
+
+    struct Entry {
+        uint64_t size;
+        std::list<std::string>::iterator lru;
+        int users;
+    };
+
+    class CachedSource;
+
+    std::string PathOf(const std::string &key) const;
+    void Scan();
+    void Touch(const std::string &key);
+    void Release(const std::string &fromDir, const std::string &key);
+    // 淘汰最久未使用且没有在发送的项, 直到总大小不超过上限
+    void Evict();
+
+    std::mutex mutex;
+    std::string dir;
+    uint64_t maxBytes;
+    uint64_t totalBytes;
+    // 最近使用的在前
+    std::list<std::string> lru;
+    std::unordered_map<std::string, Entry> entries;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint32_t tempCounter;
+};
@@ -0,0 +1,296 @@
+#include "job_cache_binding.h"
+#include "job_cache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool ReadKey(const Napi::CallbackInfo &info, std::string &key)
+{
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        Napi::TypeError::New(info.Env(), "Expected cache key").ThrowAsJavaScriptException();
+        return false;
+    }
+    key = info[0].As<Napi::String>().Utf8Value();
+    return true;
+}
+
+// setJobCache({ dir, maxBytes }); 目录不存在时创建 (上级目录必须存在)
+Napi::Value SetJobCache(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject())
+    {
+        Napi::TypeError::New(env, "Expected options object").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Object options = info[0].As<Napi::Object>();
+    if (!options.Get("dir").IsString() || !options.Get("maxBytes").IsNumber())
+    {
+        Napi::TypeError::New(env, "Expected dir and maxBytes").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    double maxBytes = options.Get("maxBytes").As<Napi::Number>().DoubleValue();
+    std::string error;
+    if (!JobCache::Shared().Configure(options.Get("dir").As<Napi::String>().Utf8Value(),
+                                      maxBytes > 0 ? static_cast<uint64_t>(maxBytes) : 0, error))
+    {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return env.Undefined();
+}
+
+// 嵌套层数上限, 同时挡住循环引用
+const int MAX_OPTIONS_DEPTH = 32;
+
+void AppendJsonString(const std::string &text, std::string &out)
+{
+    out += '"';
+    for (unsigned char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += static_cast<char>(c);
+        }
+        else if (c < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        }
+        else
+        {
+            out += static_cast<char>(c);
+        }
+    }
+    out += '"';
+}
+
+// 把变换参数序列化为规范形式: 与 JSON 相同, 但对象属性按键名排序, 写法不同的同一组参数得到同一个键.
+// 和 JSON.stringify 一样跳过值为 undefined 或函数的属性, 支持 toJSON (如 Date).
+// 无法序列化 (嵌套过深或循环引用) 时抛出 TypeError 并返回 false
+bool AppendCanonical(Napi::Env env, Napi::Value value, std::string &out, int depth)
+{
+    if (depth > MAX_OPTIONS_DEPTH)
+    {
+        Napi::TypeError::New(env, "Job options are nested too deeply or circular").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    if (value.IsObject() && !value.IsFunction())
+    {
+        Napi::Object object = value.As<Napi::Object>();
+        Napi::Value toJson = object.Get("toJSON");
+        if (toJson.IsFunction())
+        {
+            value = toJson.As<Napi::Function>().Call(object, {});
+            if (env.IsExceptionPending())
+            {
+                return false;
+            }
+        }
+    }
+
+    if (value.IsNull() || value.IsUndefined() || value.IsFunction())
+    {
+        out += "null";
+    }
+    else if (value.IsBoolean())
+    {
+        out += value.As<Napi::Boolean>().Value() ? "true" : "false";
+    }
+    else if (value.IsNumber())
+    {
+        double number = value.As<Napi::Number>().DoubleValue();
+        if (!std::isfinite(number))
+        {
+            out += "null";
+        }
+        else
+        {
+            char text[32];
+            snprintf(text, sizeof(text), "%.17g", number);
+            out += text;
+        }
+    }
+    else if (value.IsString())
+    {
+        AppendJsonString(value.As<Napi::String>().Utf8Value(), out);
+    }
+    else if (value.IsArray())
+    {
+        Napi::Array array = value.As<Napi::Array>();
+        out += '[';
+        for (uint32_t i = 0; i < array.Length(); i++)
+        {
+            if (i > 0)
+            {
+                out += ',';
+            }
+            if (!AppendCanonical(env, array.Get(i), out, depth + 1))
+            {
+                return false;
+            }
+        }
+        out += ']';
+    }
+    else if (value.IsObject())
+    {
+        Napi::Object object = value.As<Napi::Object>();
+        Napi::Array names = object.GetPropertyNames();
+        std::vector<std::string> keys;
+        keys.reserve(names.Length());
+        for (uint32_t i = 0; i < names.Length(); i++)
+        {
+            keys.push_back(names.Get(i).ToString().Utf8Value());
+        }
+        std::sort(keys.begin(), keys.end());
+
+        out += '{';
+        bool first = true;
+        for (const std::string &key : keys)
+        {
+            Napi::Value member = object.Get(key);
+            if (member.IsUndefined() || member.IsFunction())
+            {
+                continue;
+            }
+            if (!first)
+            {
+                out += ',';
+            }
+            first = false;
+            AppendJsonString(key, out);
+            out += ':';
+            if (!AppendCanonical(env, member, out, depth + 1))
+            {
+                return false;
+            }
+        }
+        out += '}';
+    }
+    else
+    {
+        Napi::TypeError::New(env, "Job options must be JSON-serialisable").ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+// jobCacheKey(source, options) -> string
+// options 是准备作业时用到的变换参数: 字符串原样参与散列, 其他值先按键名排序序列化 (与属性顺序无关)
+Napi::Value JobCacheKey(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsBuffer())
+    {
+        Napi::TypeError::New(env, "Expected source buffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string options;
+    if (info.Length() > 1 && info[1].IsString())
+    {
+        options = info[1].As<Napi::String>().Utf8Value();
+    }
+    else if (info.Length() > 1 && !info[1].IsUndefined() && !info[1].IsNull())
+    {
+        if (!AppendCanonical(env, info[1], options, 0))
+        {
+            return env.Null();
+        }
+    }
+
+    Napi::Buffer<uint8_t> source = info[0].As<Napi::Buffer<uint8_t>>();
+    return Napi::String::New(env, JobCache::Key(source.Data(), source.Length(), options));
+}
+
+// cacheJob(key, prepared) -> true; 写入准备好的作业, 键已存在时不重复写入
+Napi::Value CacheJob(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    std::string key;
+    if (!ReadKey(info, key))
+    {
+        return env.Null();
+    }
+    if (info.Length() < 2 || !info[1].IsBuffer())
+    {
+        Napi::TypeError::New(env, "Expected prepared job buffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Buffer<uint8_t> prepared = info[1].As<Napi::Buffer<uint8_t>>();
+    std::string error;
+    if (!JobCache::Shared().Put(key, prepared.Data(), prepared.Length(), error))
+    {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value HasCachedJob(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    std::string key;
+    if (!ReadKey(info, key))
+    {
+        return env.Null();
+    }
+    return Napi::Boolean::New(env, JobCache::Shared().Contains(key));
+}
+
+// removeCachedJob(key) -> boolean; 正在发送的项不能删除
+Napi::Value RemoveCachedJob(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    std::string key;
+    if (!ReadKey(info, key))
+    {
+        return env.Null();
+    }
+    return Napi::Boolean::New(env, JobCache::Shared().Remove(key));
+}
+
+Napi::Value GetJobCacheStats(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    JobCache::Stats stats = JobCache::Shared().GetStats();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("dir", Napi::String::New(env, stats.dir));
+    result.Set("maxBytes", Napi::Number::New(env, static_cast<double>(stats.maxBytes)));
+    result.Set("totalBytes", Napi::Number::New(env, static_cast<double>(stats.totalBytes)));
+    result.Set("entries", Napi::Number::New(env, static_cast<double>(stats.entries)));
+    result.Set("hits", Napi::Number::New(env, static_cast<double>(stats.hits)));
+    result.Set("misses", Napi::Number::New(env, static_cast<double>(stats.misses)));
+    result.Set("evictions", Napi::Number::New(env, static_cast<double>(stats.evictions)));
+    return result;
+}
+
+} // namespace
+
+Napi::Object InitJobCache(Napi::Env env, Napi::Object exports)
+{
+    exports.Set("setJobCache", Napi::Function::New(env, SetJobCache, "setJobCache"));
+    exports.Set("jobCacheKey", Napi::Function::New(env, JobCacheKey, "jobCacheKey"));
+    exports.Set("cacheJob", Napi::Function::New(env, CacheJob, "cacheJob"));
+    exports.Set("hasCachedJob", Napi::Function::New(env, HasCachedJob, "hasCachedJob"));
+    exports.Set("removeCachedJob", Napi::Function::New(env, RemoveCachedJob, "removeCachedJob"));
+    exports.Set("getJobCacheStats", Napi::Function::New(env, GetJobCacheStats, "getJobCacheStats"));
+    return exports;
+}
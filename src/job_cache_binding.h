@@ -0,0 +1,12 @@
+#pragma once
+#include <napi.h>
+
+// 作业缓存 (JobCache) 的 JS 接口, 作为模块级函数导出:
+//   setJobCache({ dir, maxBytes })
+//   jobCacheKey(source, options) -> 16 位十六进制键
+//   cacheJob(key, prepared) -> true
+//   hasCachedJob(key) -> boolean
+//   removeCachedJob(key) -> boolean
+//   getJobCacheStats() -> { dir, maxBytes, totalBytes, entries, hits, misses, evictions }
+// 发送缓存中的作业用 UsbDevice.sendCached(key, options)
+Napi::Object InitJobCache(Napi::Env env, Napi::Object exports);
@@ -0,0 +1,20 @@
+#pragma once
+#include "buffer_pool.h"
+#include <napi.h>
+
+// 把池中的缓冲区 (设备响应、生成的 PLT) 直接交给 JS (不复制), JS 回收 Buffer 时归还到池中
+inline Napi::Buffer<uint8_t> ToJsBuffer(Napi::Env env, std::vector<uint8_t> *storage)
+{
+    if (storage->empty())
+    {
+        BufferPool::Shared().Release(storage);
+        return Napi::Buffer<uint8_t>::New(env, 0);
+    }
+
+    return Napi::Buffer<uint8_t>::New(
+        env, storage->data(), storage->size(),
+        [](Napi::Env, uint8_t *, std::vector<uint8_t> *hint) {
+            BufferPool::Shared().Release(hint);
+        },
+        storage);
+}
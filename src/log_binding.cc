@@ -0,0 +1,150 @@
+#include "log_binding.h"
+#include "logger.h"
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 待 JS 线程处理的日志批次上限; 超过时后台线程直接丢弃该批, 不等待 JS
+const size_t MAX_PENDING_BATCHES = 16;
+
+// 日志输出端是进程级的, 最后一次 setLogHandler 的环境 (主线程或某个 worker) 接收所有日志.
+// 该环境销毁时 tsfn 被 Node 回收, 按 generation 判断是否仍是当前的回调, 以免其他环境再释放它
+std::mutex logHandlerMutex;
+Napi::ThreadSafeFunction logHandler;
+uint64_t logHandlerGeneration = 0;
+
+// 级别可以是名称 ("trace" ... "off") 或数字 0-5
+bool ToLogLevel(const Napi::Value &value, LogLevel &level)
+{
+    if (value.IsString())
+    {
+        return Logger::ParseLevel(value.As<Napi::String>().Utf8Value().c_str(), level);
+    }
+    if (value.IsNumber())
+    {
+        int number = value.As<Napi::Number>().Int32Value();
+        if (number < static_cast<int>(LogLevel::TRACE) || number > static_cast<int>(LogLevel::OFF))
+        {
+            return false;
+        }
+        level = static_cast<LogLevel>(number);
+        return true;
+    }
+    return false;
+}
+
+Napi::Value SetLogLevel(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    LogLevel level;
+    if (info.Length() < 1 || !ToLogLevel(info[0], level))
+    {
+        Napi::TypeError::New(env, "Expected log level: trace, debug, info, warn, error or off").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    LogLevel previous = Logger::Level();
+    Logger::SetLevel(level);
+    return Napi::String::New(env, Logger::LevelName(previous));
+}
+
+Napi::Value GetLogLevel(const Napi::CallbackInfo &info)
+{
+    return Napi::String::New(info.Env(), Logger::LevelName(Logger::Level()));
+}
+
+// 调用时必须持有 logHandlerMutex
+void ReleaseLogHandler()
+{
+    if (logHandler)
+    {
+        // 先摘下输出端, 之后后台线程不会再使用旧的 tsfn
+        Logger::Shared().SetSink(nullptr);
+        logHandler.Release();
+        logHandler = Napi::ThreadSafeFunction();
+    }
+}
+
+Napi::Value SetLogHandler(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || (!info[0].IsFunction() && !info[0].IsNull() && !info[0].IsUndefined()))
+    {
+        Napi::TypeError::New(env, "Expected callback function or null").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::lock_guard<std::mutex> lock(logHandlerMutex);
+    ReleaseLogHandler();
+    if (!info[0].IsFunction())
+    {
+        return env.Undefined();
+    }
+
+    uint64_t generation = ++logHandlerGeneration;
+    logHandler = Napi::ThreadSafeFunction::New(
+        env,
+        info[0].As<Napi::Function>(),
+        "LogHandler",
+        MAX_PENDING_BATCHES,
+        1,
+        [generation](Napi::Env) {
+            // 环境销毁时 tsfn 随之失效, 恢复写 stderr; 已被替换的旧回调不影响新的
+            std::lock_guard<std::mutex> lock(logHandlerMutex);
+            if (generation == logHandlerGeneration && logHandler)
+            {
+                Logger::Shared().SetSink(nullptr);
+                logHandler = Napi::ThreadSafeFunction();
+            }
+        });
+    // 日志回调不阻止进程退出
+    logHandler.Unref(env);
+
+    Napi::ThreadSafeFunction handler = logHandler;
+    Logger::Shared().SetSink([handler](const std::vector<LogRecord> &records) mutable {
+        auto batch = new std::vector<LogRecord>(records);
+        napi_status status = handler.NonBlockingCall(batch, [](Napi::Env env, Napi::Function jsCallback, std::vector<LogRecord> *batch) {
+            std::unique_ptr<std::vector<LogRecord>> owner(batch);
+            if (env == nullptr || jsCallback.IsEmpty())
+            {
+                return;
+            }
+            for (const LogRecord &record : *batch)
+            {
+                jsCallback.Call({
+                    Napi::String::New(env, Logger::LevelName(record.level)),
+                    Napi::String::New(env, record.message, record.length),
+                    Napi::Number::New(env, static_cast<double>(record.timeMs))
+                });
+            }
+        });
+        if (status != napi_ok)
+        {
+            delete batch;
+        }
+    });
+    return env.Undefined();
+}
+
+} // namespace
+
+Napi::Object InitLogging(Napi::Env env, Napi::Object exports)
+{
+    LogLevel level;
+    const char *initial = getenv("USB_ADDON_LOG");
+    if (initial != nullptr && Logger::ParseLevel(initial, level))
+    {
+        Logger::SetLevel(level);
+    }
+
+    exports.Set("setLogLevel", Napi::Function::New(env, SetLogLevel, "setLogLevel"));
+    exports.Set("getLogLevel", Napi::Function::New(env, GetLogLevel, "getLogLevel"));
+    exports.Set("setLogHandler", Napi::Function::New(env, SetLogHandler, "setLogHandler"));
+    return exports;
+}
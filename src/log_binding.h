@@ -0,0 +1,9 @@
+#pragma once
+#include <napi.h>
+
+// 原生日志的 JS 接口, 作为模块级函数导出:
+//   setLogLevel(level) -> 之前的级别
+//   getLogLevel() -> 当前级别
+//   setLogHandler(callback | null), callback(level, message, time)
+// 模块加载时从环境变量 USB_ADDON_LOG 读取初始级别
+Napi::Object InitLogging(Napi::Env env, Napi::Object exports);
@@ -0,0 +1,185 @@
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// 后台线程没有被唤醒时的最长等待, 决定 TRACE..INFO 日志的最大延迟
+const int WRITER_INTERVAL_MS = 50;
+
+const char *const LEVEL_NAMES[] = {"trace", "debug", "info", "warn", "error", "off"};
+
+} // namespace
+
+// 默认只输出警告和错误
+std::atomic<int> Logger::runtimeLevel(static_cast<int>(LogLevel::WARN));
+
+Logger &Logger::Shared()
+{
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+    : queue(CAPACITY),
+      dropped(0),
+      reportedDropped(0),
+      wakeRequested(false),
+      stopping(false)
+{
+    batch.reserve(queue.Capacity());
+    writer = std::thread(&Logger::WriterLoop, this);
+}
+
+Logger::~Logger()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCv.notify_one();
+    if (writer.joinable())
+    {
+        writer.join();
+    }
+}
+
+const char *Logger::LevelName(LogLevel level)
+{
+    int index = static_cast<int>(level);
+    if (index < 0 || index > static_cast<int>(LogLevel::OFF))
+    {
+        return "unknown";
+    }
+    return LEVEL_NAMES[index];
+}
+
+bool Logger::ParseLevel(const char *name, LogLevel &level)
+{
+    for (int i = 0; i <= static_cast<int>(LogLevel::OFF); i++)
+    {
+        if (strcmp(name, LEVEL_NAMES[i]) == 0)
+        {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Logger::Write(LogLevel level, const char *format, ...)
+{
+    int64_t timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+
+    va_list args;
+    va_start(args, format);
+    bool queued = queue.Push([&](LogRecord &record) {
+        record.level = level;
+        record.timeMs = timeMs;
+        int length = vsnprintf(record.message, LogRecord::MESSAGE_SIZE, format, args);
+        if (length < 0)
+        {
+            length = 0;
+        }
+        record.length = static_cast<uint32_t>(
+            std::min(static_cast<size_t>(length), LogRecord::MESSAGE_SIZE - 1));
+    });
+    va_end(args);
+
+    if (!queued)
+    {
+        dropped++;
+        return;
+    }
+
+    // 警告和错误尽快写出; 其余的等后台线程下一次定时醒来
+    if (level >= LogLevel::WARN && !wakeRequested.exchange(true))
+    {
+        wakeCv.notify_one();
+    }
+}
+
+void Logger::SetSink(Sink newSink)
+{
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    sink = std::move(newSink);
+}
+
+void Logger::Flush()
+{
+    DrainOnce();
+}
+
+void Logger::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    while (!stopping)
+    {
+        wakeCv.wait_for(lock, std::chrono::milliseconds(WRITER_INTERVAL_MS), [this] {
+            return stopping || wakeRequested.load();
+        });
+        wakeRequested = false;
+
+        lock.unlock();
+        DrainOnce();
+        lock.lock();
+    }
+    lock.unlock();
+    DrainOnce();
+}
+
+void Logger::DrainOnce()
+{
+    std::lock_guard<std::mutex> drainLock(drainMutex);
+
+    batch.clear();
+    queue.Drain([this](LogRecord &record) {
+        batch.push_back(record);
+    }, queue.Capacity());
+
+    // 丢弃的条数作为一条警告补在这一批末尾
+    uint64_t droppedNow = dropped.load();
+    if (droppedNow != reportedDropped)
+    {
+        LogRecord record;
+        record.level = LogLevel::WARN;
+        record.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::system_clock::now().time_since_epoch())
+                            .count();
+        int length = snprintf(record.message, LogRecord::MESSAGE_SIZE, "%llu log messages dropped",
+                              static_cast<unsigned long long>(droppedNow - reportedDropped));
+        record.length = static_cast<uint32_t>(length > 0 ? length : 0);
+        batch.push_back(record);
+        reportedDropped = droppedNow;
+    }
+
+    if (batch.empty())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> sinkLock(sinkMutex);
+    if (sink)
+    {
+        sink(batch);
+    }
+    else
+    {
+        WriteToStderr(batch);
+    }
+}
+
+void Logger::WriteToStderr(const std::vector<LogRecord> &records)
+{
+    for (const LogRecord &record : records)
+    {
+        fprintf(stderr, "[usb_addon] %-5s %.*s\n", LevelName(record.level),
+                static_cast<int>(record.length), record.message);
+    }
+    fflush(stderr);
+}
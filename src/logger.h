@@ -0,0 +1,120 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "event_queue.h"
+
+// 日志级别; 不用 ERROR 是因为 Windows 头文件中定义了同名宏
+enum class LogLevel : int {
+    TRACE = 0,
+    DEBUG = 1,
+    INFO = 2,
+    WARN = 3,
+    ERR = 4,
+    OFF = 5
+};
+
+// 编译期最低级别: 低于它的 LOG_xxx 调用连同参数求值一起被编译器删除
+// 例如 -DUSB_LOG_COMPILE_LEVEL=2 去掉所有 TRACE/DEBUG 日志
+#ifndef USB_LOG_COMPILE_LEVEL
+#define USB_LOG_COMPILE_LEVEL 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define USB_LOG_PRINTF_FORMAT(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+#define USB_LOG_PRINTF_FORMAT(fmt, args)
+#endif
+
+#define USB_LOG(level, ...)                                                        \
+    do                                                                             \
+    {                                                                              \
+        if (static_cast<int>(level) >= USB_LOG_COMPILE_LEVEL && Logger::Enabled(level)) \
+        {                                                                          \
+            Logger::Shared().Write(level, __VA_ARGS__);                            \
+        }                                                                          \
+    } while (0)
+
+#define LOG_TRACE(...) USB_LOG(LogLevel::TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...) USB_LOG(LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) USB_LOG(LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARN(...) USB_LOG(LogLevel::WARN, __VA_ARGS__)
+#define LOG_ERROR(...) USB_LOG(LogLevel::ERR, __VA_ARGS__)
+
+// 一条日志; 消息超长时截断
+struct LogRecord {
+    static const size_t MESSAGE_SIZE = 232;
+
+    LogLevel level;
+    int64_t timeMs;     // 墙上时钟, 自 1970 年起的毫秒数
+    uint32_t length;
+    char message[MESSAGE_SIZE];
+};
+
+// 异步日志
+// 调用线程只做格式化并无锁写入环形队列 (满时丢弃并计数), 不做任何 I/O;
+// 后台线程成批取出后交给输出端: 默认写 stderr, 也可以换成 JS 回调.
+class Logger {
+public:
+    typedef std::function<void(const std::vector<LogRecord> &records)> Sink;
+
+    static const size_t CAPACITY = 1024;
+
+    static Logger &Shared();
+
+    // 运行期级别检查, 只是一次 relaxed 原子读
+    static bool Enabled(LogLevel level)
+    {
+        return static_cast<int>(level) >= runtimeLevel.load(std::memory_order_relaxed);
+    }
+
+    static LogLevel Level() { return static_cast<LogLevel>(runtimeLevel.load(std::memory_order_relaxed)); }
+    static void SetLevel(LogLevel level) { runtimeLevel.store(static_cast<int>(level), std::memory_order_relaxed); }
+
+    static const char *LevelName(LogLevel level);
+    // 解析 "trace"/"debug"/"info"/"warn"/"error"/"off"; 无法识别时返回 false
+    static bool ParseLevel(const char *name, LogLevel &level);
+
+    void Write(LogLevel level, const char *format, ...) USB_LOG_PRINTF_FORMAT(3, 4);
+
+    // 替换输出端, nullptr 恢复 stderr; 返回后旧的输出端不会再被调用
+    void SetSink(Sink sink);
+
+    // 在调用线程上立即写出已入队的日志
+    void Flush();
+
+    uint64_t Dropped() const { return dropped.load(); }
+
+private:
+    Logger();
+    ~Logger();
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    void WriterLoop();
+    void DrainOnce();
+    static void WriteToStderr(const std::vector<LogRecord> &records);
+
+    static std::atomic<int> runtimeLevel;
+
+    EventQueue<LogRecord> queue;
+    std::atomic<uint64_t> dropped;
+    uint64_t reportedDropped;   // 只在 drainMutex 下访问
+
+    std::mutex drainMutex;      // 队列只有一个消费者: 后台线程或 Flush
+    std::vector<LogRecord> batch;
+
+    std::mutex sinkMutex;
+    Sink sink;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    std::atomic<bool> wakeRequested;
+    bool stopping;
+    std::thread writer;
+};
@@ -0,0 +1,247 @@
+#include "mapped_file.h"
+#include <cerrno>
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+std::string SystemError(const std::string &what)
+{
+    return what + ": " + std::to_string(GetLastError());
+}
+#else
+std::string SystemError(const std::string &what)
+{
+    return what + ": " + strerror(errno);
+}
+#endif
+
+} // namespace
+
+MappedFile::MappedFile()
+    : data(nullptr),
+      size(0),
+      opened(false)
+#ifdef _WIN32
+      ,
+      file(INVALID_HANDLE_VALUE),
+      mapping(NULL)
+#else
+      ,
+      fd(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::OpenRead(const std::string &path, std::string &error)
+{
+    Close();
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                       OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        error = SystemError("Failed to open " + path);
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        error = SystemError("Failed to get size of " + path);
+        Close();
+        return false;
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+    return Map(false, error);
+}
+
+bool MappedFile::OpenWrite(const std::string &path, size_t newSize, std::string &error)
+{
+    Close();
+    file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                       OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        error = SystemError("Failed to open " + path);
+        return false;
+    }
+
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(newSize);
+    if (!SetFilePointerEx(file, end, NULL, FILE_BEGIN) || !SetEndOfFile(file))
+    {
+        error = SystemError("Failed to resize " + path);
+        Close();
+        return false;
+    }
+    size = newSize;
+    return Map(true, error);
+}
+
+bool MappedFile::Map(bool writable, std::string &error)
+{
+    opened = true;
+    if (size == 0)
+    {
+        return true;
+    }
+
+    mapping = CreateFileMappingA(file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+    {
+        error = SystemError("Failed to map file");
+        Close();
+        return false;
+    }
+
+    data = static_cast<uint8_t *>(MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size));
+    if (data == nullptr)
+    {
+        error = SystemError("Failed to map file");
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data)
+    {
+        UnmapViewOfFile(data);
+        data = nullptr;
+    }
+    if (mapping != NULL)
+    {
+        CloseHandle(mapping);
+        mapping = NULL;
+    }
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+    }
+    size = 0;
+    opened = false;
+}
+
+void MappedFile::Flush()
+{
+    if (data)
+    {
+        FlushViewOfFile(data, size);
+    }
+}
+
+void MappedFile::AdviseSequential()
+{
+}
+
+#else
+
+bool MappedFile::OpenRead(const std::string &path, std::string &error)
+{
+    Close();
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        error = SystemError("Failed to open " + path);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        error = SystemError("Failed to stat " + path);
+        Close();
+        return false;
+    }
+    size = static_cast<size_t>(info.st_size);
+    return Map(false, error);
+}
+
+bool MappedFile::OpenWrite(const std::string &path, size_t newSize, std::string &error)
+{
+    Close();
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        error = SystemError("Failed to open " + path);
+        return false;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(newSize)) != 0)
+    {
+        error = SystemError("Failed to resize " + path);
+        Close();
+        return false;
+    }
+    size = newSize;
+    return Map(true, error);
+}
+
+bool MappedFile::Map(bool writable, std::string &error)
+{
+    opened = true;
+    if (size == 0)
+    {
+        return true;
+    }
+
+    void *address = mmap(nullptr, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED)
+    {
+        error = SystemError("Failed to map file");
+        Close();
+        return false;
+    }
+    data = static_cast<uint8_t *>(address);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data)
+    {
+        munmap(data, size);
+        data = nullptr;
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    size = 0;
+    opened = false;
+}
+
+void MappedFile::Flush()
+{
+    if (data)
+    {
+        msync(data, size, MS_ASYNC);
+    }
+}
+
+void MappedFile::AdviseSequential()
+{
+    if (data)
+    {
+        madvise(data, size, MADV_SEQUENTIAL);
+    }
+}
+
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// 内存映射文件 (POSIX mmap / Windows 文件映射)
+// 只读映射用于读取大文件而不复制到用户缓冲区; 读写映射用于追加写入的跟踪文件等,
+// 写入只是内存复制, 由内核在后台写回磁盘, 进程崩溃时已写入的内容也不会丢失.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // 只读映射整个文件; 空文件可以打开, Data() 为 nullptr
+    bool OpenRead(const std::string &path, std::string &error);
+
+    // 读写映射, 文件大小设为 size (不存在时创建)
+    bool OpenWrite(const std::string &path, size_t size, std::string &error);
+
+    void Close();
+
+    // 异步写回已修改的页 (不等待完成)
+    void Flush();
+
+    bool IsOpen() const { return opened; }
+    uint8_t *Data() const { return data; }
+    size_t Size() const { return size; }
+
+    // 提示内核将按顺序访问 (预读), 对不支持的平台无作用
+    void AdviseSequential();
+
+private:
+    bool Map(bool writable, std::string &error);
+
+    uint8_t *data;
+    size_t size;
+    bool opened;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+};
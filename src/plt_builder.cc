@@ -0,0 +1,51 @@
+#include "plt_builder.h"
+#include "plt_writer.h"
+
+namespace {
+
+// 单点命令的最大长度: "PD" + x + "," + y + ";"
+const size_t MAX_POINT_CHARS = 2 + MAX_INT_CHARS + 1 + MAX_INT_CHARS + 1;
+
+inline bool PenDown(const uint8_t *pens, size_t i)
+{
+    return pens ? pens[i] != 0 : i > 0;
+}
+
+} // namespace
+
+size_t PltBuildBound(size_t points)
+{
+    return points * MAX_POINT_CHARS;
+}
+
+void BuildPlt(const int32_t *coords, const uint8_t *pens, size_t points,
+              const PltBuildOptions &options, std::vector<uint8_t> &out)
+{
+    // 只预留不填充: resize 到最坏情况会先把整块缓冲区清零, 通常比实际输出多写一倍以上
+    out.reserve(out.size() + PltBuildBound(points));
+
+    char line[MAX_POINT_CHARS];
+    for (size_t i = 0; i < points; i++)
+    {
+        bool down = PenDown(pens, i);
+        bool continues = options.mergePoints && i > 0 && PenDown(pens, i - 1) == down;
+
+        char *p = line;
+        if (continues)
+        {
+            // 把上一条命令结尾的 ';' 改成 ',' 继续追加坐标
+            out.back() = ',';
+        }
+        else
+        {
+            *p++ = 'P';
+            *p++ = down ? 'D' : 'U';
+        }
+
+        p = FormatInt(p, coords[2 * i]);
+        *p++ = ',';
+        p = FormatInt(p, coords[2 * i + 1]);
+        *p++ = ';';
+        out.insert(out.end(), line, p);
+    }
+}
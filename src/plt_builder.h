@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct PltBuildOptions {
+    bool mergePoints = false;   // 连续同一刀状态的点合并为一条命令: PDx1,y1,x2,y2...;
+};
+
+// 由坐标流生成 PLT:
+//   coords: x0,y0,x1,y1,... (设备单位)
+//   pens:   每个点的刀状态, 0 = 抬刀 (PU), 非 0 = 落刀 (PD); 为 nullptr 时第一个点抬刀, 其余落刀
+// 输出追加到 out 末尾; 先按最坏情况一次性预留容量 (不填充), 每个点在栈上格式化后追加
+void BuildPlt(const int32_t *coords, const uint8_t *pens, size_t points,
+              const PltBuildOptions &options, std::vector<uint8_t> &out);
+
+// 输出 points 个点所需的最大字节数
+size_t PltBuildBound(size_t points);
@@ -0,0 +1,289 @@
+#include "plt_flatten.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 单条曲线的最大分段数, 防止异常输入导致输出无限膨胀
+const size_t MAX_SUBDIVISIONS = 1 << 16;
+
+// 按批计算分段点, 批内循环没有分支和依赖, 便于向量化
+const size_t BATCH = 64;
+
+const double PI = 3.14159265358979323846;
+
+// 输入坐标的绝对值上限, 保证四舍五入后能放进 int32
+const double MAX_COORDINATE = 2147483647.0;
+
+// 四舍五入到整数; 用截断转换实现, 避免 lround 阻止向量化.
+// 圆弧上的点可能超出输入坐标的范围, 先限制在 int32 范围内 (min/max 同样可以向量化)
+inline int32_t RoundToInt(double v)
+{
+    v += v >= 0 ? 0.5 : -0.5;
+    return static_cast<int32_t>(std::min(std::max(v, -MAX_COORDINATE - 1), MAX_COORDINATE));
+}
+
+size_t ClampSubdivisions(double n)
+{
+    if (!(n >= 1))
+    {
+        return 1;
+    }
+    if (n > MAX_SUBDIVISIONS)
+    {
+        return MAX_SUBDIVISIONS;
+    }
+    return static_cast<size_t>(std::ceil(n));
+}
+
+class Flattener {
+public:
+    Flattener(std::vector<int32_t> &points, std::vector<uint8_t> &pens)
+        : points(points), pens(pens)
+    {
+    }
+
+    void MoveTo(double x, double y)
+    {
+        currentX = startX = x;
+        currentY = startY = y;
+        Append(RoundToInt(x), RoundToInt(y), 0);
+    }
+
+    void LineTo(double x, double y)
+    {
+        currentX = x;
+        currentY = y;
+        Append(RoundToInt(x), RoundToInt(y), 1);
+    }
+
+    void Close()
+    {
+        LineTo(startX, startY);
+    }
+
+    // 多项式形式: P(t) = ((a t + b) t + c) t + d
+    void Cubic(double c1x, double c1y, double c2x, double c2y, double x, double y, double tolerance)
+    {
+        double x0 = currentX;
+        double y0 = currentY;
+
+        // Wang 公式: n = sqrt(3 * 2 / 8 * max|P[i] - 2P[i+1] + P[i+2]| / tolerance)
+        double ddx1 = x0 - 2 * c1x + c2x;
+        double ddy1 = y0 - 2 * c1y + c2y;
+        double ddx2 = c1x - 2 * c2x + x;
+        double ddy2 = c1y - 2 * c2y + y;
+        double m = std::sqrt(std::max(ddx1 * ddx1 + ddy1 * ddy1, ddx2 * ddx2 + ddy2 * ddy2));
+        size_t n = ClampSubdivisions(std::sqrt(0.75 * m / tolerance));
+
+        double ax = -x0 + 3 * c1x - 3 * c2x + x;
+        double ay = -y0 + 3 * c1y - 3 * c2y + y;
+        double bx = 3 * x0 - 6 * c1x + 3 * c2x;
+        double by = 3 * y0 - 6 * c1y + 3 * c2y;
+        double cx = 3 * (c1x - x0);
+        double cy = 3 * (c1y - y0);
+
+        EmitPolynomial(n, ax, ay, bx, by, cx, cy, x0, y0);
+        currentX = x;
+        currentY = y;
+    }
+
+    void Quad(double qx, double qy, double x, double y, double tolerance)
+    {
+        double x0 = currentX;
+        double y0 = currentY;
+
+        // Wang 公式 (二次): n = sqrt(2 * 1 / 8 * |P0 - 2P1 + P2| / tolerance)
+        double ddx = x0 - 2 * qx + x;
+        double ddy = y0 - 2 * qy + y;
+        size_t n = ClampSubdivisions(std::sqrt(0.25 * std::sqrt(ddx * ddx + ddy * ddy) / tolerance));
+
+        EmitPolynomial(n, 0, 0, ddx, ddy, 2 * (qx - x0), 2 * (qy - y0), x0, y0);
+        currentX = x;
+        currentY = y;
+    }
+
+    void Arc(double cx, double cy, double sweep, double tolerance)
+    {
+        double dx = currentX - cx;
+        double dy = currentY - cy;
+        double radius = std::sqrt(dx * dx + dy * dy);
+        if (radius == 0 || sweep == 0)
+        {
+            return;
+        }
+
+        // 弦高 = r (1 - cos(step / 2)) <= tolerance
+        double step = tolerance < radius ? 2 * std::acos(1 - tolerance / radius) : PI / 2;
+        size_t n = ClampSubdivisions(std::fabs(sweep) / step);
+        double start = std::atan2(dy, dx);
+        double delta = sweep / static_cast<double>(n);
+
+        double xs[BATCH];
+        double ys[BATCH];
+        for (size_t base = 1; base <= n; base += BATCH)
+        {
+            size_t count = std::min(BATCH, n - base + 1);
+            for (size_t i = 0; i < count; i++)
+            {
+                double angle = start + delta * static_cast<double>(base + i);
+                xs[i] = cx + radius * std::cos(angle);
+                ys[i] = cy + radius * std::sin(angle);
+            }
+            AppendBatch(xs, ys, count);
+        }
+
+        currentX = cx + radius * std::cos(start + sweep);
+        currentY = cy + radius * std::sin(start + sweep);
+    }
+
+private:
+    // 计算 t = i / n (i = 1..n) 处的点; 最后一个点精确落在 t = 1
+    void EmitPolynomial(size_t n, double ax, double ay, double bx, double by,
+                        double cx, double cy, double dx, double dy)
+    {
+        double xs[BATCH];
+        double ys[BATCH];
+        double inv = 1.0 / static_cast<double>(n);
+
+        for (size_t base = 1; base <= n; base += BATCH)
+        {
+            size_t count = std::min(BATCH, n - base + 1);
+            for (size_t i = 0; i < count; i++)
+            {
+                double t = static_cast<double>(base + i) * inv;
+                xs[i] = ((ax * t + bx) * t + cx) * t + dx;
+                ys[i] = ((ay * t + by) * t + cy) * t + dy;
+            }
+            AppendBatch(xs, ys, count);
+        }
+    }
+
+    void AppendBatch(const double *xs, const double *ys, size_t count)
+    {
+        int32_t ix[BATCH];
+        int32_t iy[BATCH];
+        for (size_t i = 0; i < count; i++)
+        {
+            ix[i] = RoundToInt(xs[i]);
+            iy[i] = RoundToInt(ys[i]);
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            Append(ix[i], iy[i], 1);
+        }
+    }
+
+    // 跳过与上一个落刀点相同的整数坐标
+    void Append(int32_t x, int32_t y, uint8_t pen)
+    {
+        if (pen && !pens.empty() && points[points.size() - 2] == x && points.back() == y)
+        {
+            return;
+        }
+        // 连续的抬刀移动只保留最后一个
+        if (!pen && !pens.empty() && pens.back() == 0)
+        {
+            points[points.size() - 2] = x;
+            points.back() = y;
+            return;
+        }
+        points.push_back(x);
+        points.push_back(y);
+        pens.push_back(pen);
+    }
+
+    std::vector<int32_t> &points;
+    std::vector<uint8_t> &pens;
+    double currentX = 0;
+    double currentY = 0;
+    double startX = 0;
+    double startY = 0;
+};
+
+size_t VerbArgCount(uint8_t verb)
+{
+    switch (static_cast<CurveVerb>(verb))
+    {
+    case CurveVerb::MOVE:
+    case CurveVerb::LINE:
+        return 2;
+    case CurveVerb::QUAD:
+        return 4;
+    case CurveVerb::CUBIC:
+        return 6;
+    case CurveVerb::ARC:
+        return 3;
+    case CurveVerb::CLOSE:
+        return 0;
+    }
+    return SIZE_MAX;
+}
+
+} // namespace
+
+bool FlattenCurves(const uint8_t *verbs, size_t verbCount, const double *coords, size_t coordCount,
+                   const PltFlattenOptions &options, std::vector<int32_t> &points, std::vector<uint8_t> &pens,
+                   std::string &error)
+{
+    if (!(options.tolerance > 0))
+    {
+        error = "tolerance must be greater than 0";
+        return false;
+    }
+
+    Flattener flattener(points, pens);
+    double tolerance = options.tolerance;
+    size_t offset = 0;
+
+    for (size_t v = 0; v < verbCount; v++)
+    {
+        size_t argCount = VerbArgCount(verbs[v]);
+        if (argCount == SIZE_MAX)
+        {
+            error = "Unknown curve verb " + std::to_string(verbs[v]) + " at index " + std::to_string(v);
+            return false;
+        }
+        if (coordCount - offset < argCount)
+        {
+            error = "Coordinate array is too short for verb at index " + std::to_string(v);
+            return false;
+        }
+
+        const double *a = coords + offset;
+        for (size_t k = 0; k < argCount; k++)
+        {
+            // 圆弧的第三个参数是角度, 只要求是有限数
+            bool isSweep = verbs[v] == static_cast<uint8_t>(CurveVerb::ARC) && k == 2;
+            if (!std::isfinite(a[k]) || (!isSweep && std::fabs(a[k]) > MAX_COORDINATE))
+            {
+                error = "Coordinate at index " + std::to_string(offset + k) + " is not finite or out of range";
+                return false;
+            }
+        }
+        offset += argCount;
+
+        switch (static_cast<CurveVerb>(verbs[v]))
+        {
+        case CurveVerb::MOVE:
+            flattener.MoveTo(a[0], a[1]);
+            break;
+        case CurveVerb::LINE:
+            flattener.LineTo(a[0], a[1]);
+            break;
+        case CurveVerb::QUAD:
+            flattener.Quad(a[0], a[1], a[2], a[3], tolerance);
+            break;
+        case CurveVerb::CUBIC:
+            flattener.Cubic(a[0], a[1], a[2], a[3], a[4], a[5], tolerance);
+            break;
+        case CurveVerb::ARC:
+            flattener.Arc(a[0], a[1], a[2], tolerance);
+            break;
+        case CurveVerb::CLOSE:
+            flattener.Close();
+            break;
+        }
+    }
+    return true;
+}
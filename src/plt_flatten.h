@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 路径指令, 每条指令从 coords 中消耗固定数量的参数 (设备单位)
+enum class CurveVerb : uint8_t {
+    MOVE = 0,     // x, y                      抬刀移动到起点
+    LINE = 1,     // x, y
+    QUAD = 2,     // cx, cy, x, y              二次贝塞尔
+    CUBIC = 3,    // c1x, c1y, c2x, c2y, x, y  三次贝塞尔
+    ARC = 4,      // cx, cy, sweep             以 (cx, cy) 为圆心从当前点转过 sweep 弧度, 正数为逆时针
+    CLOSE = 5     //                           直线回到当前子路径的起点
+};
+
+struct PltFlattenOptions {
+    double tolerance = 0.5;   // 折线与曲线之间允许的最大弦高误差 (设备单位)
+};
+
+// 把曲线路径展开为折线, 输出与 BuildPlt 相同格式的坐标流:
+//   points: x0,y0,x1,y1,... (已四舍五入为整数, 去掉了连续重复的点)
+//   pens:   每个点一个字节, 0 = 抬刀, 1 = 落刀
+// 每段曲线根据控制点的二阶差分 (Wang 公式) 计算满足误差要求的最少分段数,
+// 分段点按批计算, 内层循环可被编译器自动向量化
+// 指令或参数不合法 (参数数量不足、坐标不是有限数或超出 int32 范围) 时返回 false 并设置 error
+bool FlattenCurves(const uint8_t *verbs, size_t verbCount, const double *coords, size_t coordCount,
+                   const PltFlattenOptions &options, std::vector<int32_t> &points, std::vector<uint8_t> &pens,
+                   std::string &error);
@@ -0,0 +1,487 @@
+#include "plt_parser.h"
+#include "plt_writer.h"
+#include <cmath>
+
+namespace {
+
+bool IsSpace(uint8_t c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool IsAlpha(uint8_t c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+bool IsDigit(uint8_t c)
+{
+    return c >= '0' && c <= '9';
+}
+
+uint8_t Upper(uint8_t c)
+{
+    return (c >= 'a' && c <= 'z') ? static_cast<uint8_t>(c - 'a' + 'A') : c;
+}
+
+PltOp LookupOp(uint8_t a, uint8_t b)
+{
+    a = Upper(a);
+    b = Upper(b);
+    switch (a)
+    {
+    case 'I':
+        return b == 'N' ? PltOp::IN : PltOp::OTHER;
+    case 'P':
+        if (b == 'U') return PltOp::PU;
+        if (b == 'D') return PltOp::PD;
+        if (b == 'G') return PltOp::PG;
+        return PltOp::OTHER;
+    case 'T':
+        return b == 'B' ? PltOp::TB : PltOp::OTHER;
+    case 'C':
+        return b == 'T' ? PltOp::CT : PltOp::OTHER;
+    default:
+        return PltOp::OTHER;
+    }
+}
+
+const char *OpName(PltOp op)
+{
+    switch (op)
+    {
+    case PltOp::IN: return "IN";
+    case PltOp::PU: return "PU";
+    case PltOp::PD: return "PD";
+    case PltOp::TB: return "TB";
+    case PltOp::CT: return "CT";
+    case PltOp::PG: return "PG";
+    default: return "";
+    }
+}
+
+// 跳到下一个 ';' 之后 (或数据末尾)
+size_t SkipToTerminator(const uint8_t *data, size_t length, size_t i)
+{
+    while (i < length && data[i] != ';')
+    {
+        i++;
+    }
+    return i < length ? i + 1 : i;
+}
+
+struct Point {
+    int32_t x;
+    int32_t y;
+};
+
+// 点 q 到线段 a-b 的距离是否在 tolerance 内, 且投影落在线段上 (避免删掉折返点)
+bool NearSegment(Point a, Point b, Point q, double tolerance)
+{
+    double dx = static_cast<double>(b.x) - a.x;
+    double dy = static_cast<double>(b.y) - a.y;
+    double qx = static_cast<double>(q.x) - a.x;
+    double qy = static_cast<double>(q.y) - a.y;
+    double lengthSq = dx * dx + dy * dy;
+
+    if (lengthSq == 0)
+    {
+        return qx * qx + qy * qy <= tolerance * tolerance;
+    }
+
+    double t = (qx * dx + qy * dy) / lengthSq;
+    if (t < 0 || t > 1)
+    {
+        return false;
+    }
+
+    double cross = qx * dy - qy * dx;
+    return cross * cross <= tolerance * tolerance * lengthSq;
+}
+
+class Optimizer {
+public:
+    Optimizer(const PltOptimizeOptions &options, PltWriter &writer)
+        : options(options), writer(writer),
+          hasPosition(false), penDown(false), relative(false), hasPendingPu(false), pendingPuHasCoords(false)
+    {
+    }
+
+    // PR 模式下的坐标是相对位移, 去重和共线判定都不成立; 抬刀/落刀命令原样输出
+    bool Relative() const
+    {
+        return relative;
+    }
+
+    void Verbatim(const PltProgram &program, const PltCommand &command)
+    {
+        Flush();
+        WritePltCommand(program, command, writer);
+        hasPosition = false;
+        penDown = command.op == PltOp::PD;
+    }
+
+    void PenUp(const int32_t *args, uint32_t count)
+    {
+        FlushRun();
+        // 连续的抬刀移动只需要最后一个目标点
+        hasPendingPu = true;
+        if (count >= 2)
+        {
+            pendingPu.x = args[count - 2 - (count % 2)];
+            pendingPu.y = args[count - 1 - (count % 2)];
+            pendingPuHasCoords = true;
+        }
+    }
+
+    void PenDown(const int32_t *args, uint32_t count)
+    {
+        FlushPenUp();
+        if (count < 2)
+        {
+            // 无参数的 PD: 在当前位置落刀, 原样保留
+            FlushRun();
+            writer.Raw("PD;");
+            penDown = true;
+            return;
+        }
+        for (uint32_t i = 0; i + 1 < count; i += 2)
+        {
+            run.push_back(Point{args[i], args[i + 1]});
+        }
+    }
+
+    void Barrier(const PltProgram &program, const PltCommand &command)
+    {
+        Flush();
+        WritePltCommand(program, command, writer);
+
+        // IN 会把位置复位到原点; 不认识的命令也可能改变位置
+        if (command.op == PltOp::IN || command.op == PltOp::OTHER)
+        {
+            hasPosition = false;
+        }
+        if (command.op == PltOp::IN)
+        {
+            // IN 抬刀并恢复绝对坐标
+            penDown = false;
+            relative = false;
+        }
+        PltSetsCoordinateMode(program, command, relative);
+    }
+
+    void Flush()
+    {
+        FlushRun();
+        FlushPenUp();
+    }
+
+private:
+    void FlushPenUp()
+    {
+        if (!hasPendingPu)
+        {
+            return;
+        }
+        if (pendingPuHasCoords)
+        {
+            writer.Point("PU", pendingPu.x, pendingPu.y);
+            position = pendingPu;
+            hasPosition = true;
+        }
+        else
+        {
+            writer.Raw("PU;");
+        }
+        penDown = false;
+        hasPendingPu = false;
+        pendingPuHasCoords = false;
+    }
+
+    void FlushRun()
+    {
+        if (run.empty())
+        {
+            return;
+        }
+
+        // 1. 去掉重复点; 抬刀后在原地落刀 (打点/下刀) 不算重复
+        std::vector<Point> &points = run;
+        if (options.removeDuplicates)
+        {
+            size_t kept = 0;
+            for (size_t i = 0; i < points.size(); i++)
+            {
+                Point prev = kept > 0 ? points[kept - 1] : position;
+                bool hasPrev = kept > 0 || (hasPosition && penDown);
+                if (hasPrev && prev.x == points[i].x && prev.y == points[i].y)
+                {
+                    continue;
+                }
+                points[kept++] = points[i];
+            }
+            points.resize(kept);
+        }
+
+        // 2. 去掉共线点: 被跳过的点必须都落在 anchor -> next 线段的容差范围内
+        output.clear();
+        if (!points.empty())
+        {
+            size_t start = 0;
+            Point anchor = position;
+            if (!hasPosition)
+            {
+                anchor = points[0];
+                output.push_back(points[0]);
+                start = 1;
+            }
+
+            skipped.clear();
+            for (size_t i = start; i < points.size(); i++)
+            {
+                if (i + 1 == points.size() || !options.removeCollinear)
+                {
+                    output.push_back(points[i]);
+                    continue;
+                }
+
+                Point next = points[i + 1];
+                bool collinear = NearSegment(anchor, next, points[i], options.tolerance);
+                for (size_t k = 0; collinear && k < skipped.size(); k++)
+                {
+                    collinear = NearSegment(anchor, next, skipped[k], options.tolerance);
+                }
+
+                if (collinear)
+                {
+                    skipped.push_back(points[i]);
+                }
+                else
+                {
+                    output.push_back(points[i]);
+                    anchor = points[i];
+                    skipped.clear();
+                }
+            }
+        }
+
+        // 3. 输出
+        if (!output.empty())
+        {
+            if (options.mergePoints)
+            {
+                writer.Raw("PD", 2);
+                for (size_t i = 0; i < output.size(); i++)
+                {
+                    if (i > 0)
+                    {
+                        writer.Char(',');
+                    }
+                    writer.Int(output[i].x);
+                    writer.Char(',');
+                    writer.Int(output[i].y);
+                }
+                writer.Char(';');
+            }
+            else
+            {
+                for (const Point &p : output)
+                {
+                    writer.Point("PD", p.x, p.y);
+                }
+            }
+
+            position = output.back();
+            hasPosition = true;
+            penDown = true;
+        }
+
+        run.clear();
+    }
+
+    const PltOptimizeOptions &options;
+    PltWriter &writer;
+
+    Point position;
+    bool hasPosition;
+    bool penDown;
+    bool relative;
+    Point pendingPu;
+    bool hasPendingPu;
+    bool pendingPuHasCoords;
+    std::vector<Point> run;
+    std::vector<Point> output;
+    std::vector<Point> skipped;
+};
+
+} // namespace
+
+void ParsePlt(const uint8_t *data, size_t length, PltProgram &program)
+{
+    program.commands.clear();
+    program.args.clear();
+    program.source = data;
+
+    size_t i = 0;
+    while (i < length)
+    {
+        uint8_t c = data[i];
+        if (IsSpace(c) || c == ';')
+        {
+            i++;
+            continue;
+        }
+
+        size_t start = i;
+        PltOp op = (i + 1 < length && IsAlpha(c) && IsAlpha(data[i + 1])) ? LookupOp(c, data[i + 1]) : PltOp::OTHER;
+
+        if (op != PltOp::OTHER)
+        {
+            // 解析以 ',' 或空格分隔的整数参数
+            size_t argStart = program.args.size();
+            bool valid = true;
+            i += 2;
+            for (;;)
+            {
+                while (i < length && (IsSpace(data[i]) || data[i] == ','))
+                {
+                    i++;
+                }
+                if (i >= length)
+                {
+                    break;
+                }
+                if (data[i] == ';')
+                {
+                    i++;
+                    break;
+                }
+                if (IsAlpha(data[i]))
+                {
+                    // 省略了 ';' 的命令
+                    break;
+                }
+
+                bool negative = false;
+                if (data[i] == '-' || data[i] == '+')
+                {
+                    negative = data[i] == '-';
+                    i++;
+                }
+                if (i >= length || !IsDigit(data[i]))
+                {
+                    valid = false;
+                    break;
+                }
+                int64_t value = 0;
+                while (i < length && IsDigit(data[i]))
+                {
+                    value = value * 10 + (data[i] - '0');
+                    if (value > INT32_MAX)
+                    {
+                        // 超出范围: 整条命令原样保留, 不再继续累加
+                        valid = false;
+                        break;
+                    }
+                    i++;
+                }
+                if (i < length && data[i] == '.')
+                {
+                    // 小数坐标不做优化, 按原样保留整条命令
+                    valid = false;
+                }
+                if (!valid)
+                {
+                    break;
+                }
+                program.args.push_back(static_cast<int32_t>(negative ? -value : value));
+            }
+
+            if (valid)
+            {
+                PltCommand command;
+                command.op = op;
+                command.argOffset = static_cast<uint32_t>(argStart);
+                command.argCount = static_cast<uint32_t>(program.args.size() - argStart);
+                program.commands.push_back(command);
+                continue;
+            }
+
+            program.args.resize(argStart);
+        }
+
+        // 其他命令 (或无法解析的数据) 连同结尾的 ';' 原样保留
+        i = SkipToTerminator(data, length, start);
+        PltCommand command;
+        command.op = PltOp::OTHER;
+        command.argOffset = static_cast<uint32_t>(start);
+        command.argCount = static_cast<uint32_t>(i - start);
+        program.commands.push_back(command);
+    }
+}
+
+bool PltSetsCoordinateMode(const PltProgram &program, const PltCommand &command, bool &relative)
+{
+    if (command.op != PltOp::OTHER || command.argCount < 2)
+    {
+        return false;
+    }
+    const uint8_t *text = program.source + command.argOffset;
+    if (Upper(text[0]) != 'P' || (Upper(text[1]) != 'A' && Upper(text[1]) != 'R'))
+    {
+        return false;
+    }
+    relative = Upper(text[1]) == 'R';
+    return true;
+}
+
+void WritePltCommand(const PltProgram &program, const PltCommand &command, PltWriter &writer)
+{
+    if (command.op == PltOp::OTHER)
+    {
+        writer.Raw(reinterpret_cast<const char *>(program.source + command.argOffset), command.argCount);
+        return;
+    }
+
+    const int32_t *args = program.args.data() + command.argOffset;
+    writer.Raw(OpName(command.op), 2);
+    for (uint32_t i = 0; i < command.argCount; i++)
+    {
+        if (i > 0)
+        {
+            writer.Char(',');
+        }
+        writer.Int(args[i]);
+    }
+    writer.Char(';');
+}
+
+void OptimizePlt(const PltProgram &program, const PltOptimizeOptions &options,
+                 std::vector<uint8_t> &out)
+{
+    PltWriter writer(out);
+    Optimizer optimizer(options, writer);
+
+    for (const PltCommand &command : program.commands)
+    {
+        const int32_t *args = program.args.data() + command.argOffset;
+        if (optimizer.Relative() && (command.op == PltOp::PU || command.op == PltOp::PD))
+        {
+            optimizer.Verbatim(program, command);
+            continue;
+        }
+        switch (command.op)
+        {
+        case PltOp::PU:
+            optimizer.PenUp(args, command.argCount);
+            break;
+        case PltOp::PD:
+            optimizer.PenDown(args, command.argCount);
+            break;
+        default:
+            optimizer.Barrier(program, command);
+            break;
+        }
+    }
+    optimizer.Flush();
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class PltWriter;
+
+// HPGL/PLT 命令
+enum class PltOp : uint8_t {
+    IN,     // 初始化
+    PU,     // 抬刀移动
+    PD,     // 落刀移动
+    TB,     // 刀具/介质参数 (如 TB25,w,h)
+    CT,     // 切割模式
+    PG,     // 走纸/结束
+    OTHER   // 其他命令, 原样保留
+};
+
+// 解析后的紧凑表示: 参数统一存放在 args 中, 每条命令记录偏移和个数;
+// OTHER 命令记录其在原始数据中的字节范围
+struct PltCommand {
+    PltOp op;
+    uint32_t argOffset;   // OTHER: 原始数据偏移
+    uint32_t argCount;    // OTHER: 原始数据长度
+};
+
+struct PltProgram {
+    std::vector<PltCommand> commands;
+    std::vector<int32_t> args;
+    const uint8_t *source = nullptr;  // 解析时的原始数据 (OTHER 命令引用它)
+};
+
+struct PltOptimizeOptions {
+    double tolerance = 0.5;       // 共线判定的允许偏差 (设备单位, >= 0)
+    bool removeCollinear = true;  // 删除共线的落刀点
+    bool removeDuplicates = true; // 删除重复的落刀点
+    bool mergePoints = false;     // 把连续的落刀点合并为一条 PDx1,y1,x2,y2...;
+};
+
+// 解析 PLT 数据; 空白字符被忽略. data 在使用 program 期间必须保持有效
+void ParsePlt(const uint8_t *data, size_t length, PltProgram &program);
+
+// 命令是否切换坐标模式: PA (绝对) 返回 true 并置 relative = false, PR (相对) 置 relative = true;
+// 其他命令返回 false. PA/PR 作为 OTHER 命令原样保留
+bool PltSetsCoordinateMode(const PltProgram &program, const PltCommand &command, bool &relative);
+
+// 按规范格式输出单条命令 (OTHER 命令原样输出)
+void WritePltCommand(const PltProgram &program, const PltCommand &command, PltWriter &writer);
+
+// 重新输出 PLT, 去掉重复点、共线点和多余的抬刀移动
+void OptimizePlt(const PltProgram &program, const PltOptimizeOptions &options,
+                 std::vector<uint8_t> &out);
@@ -0,0 +1,416 @@
+#include "plt_reorder.h"
+#include "plt_writer.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+struct Point {
+    int32_t x;
+    int32_t y;
+};
+
+// 一条切割路径: points[first] 是起点 (抬刀移动的目标), 随后 count - 1 个落刀点
+struct Path {
+    uint32_t first;
+    uint32_t count;
+};
+
+// 排序结果中的一项: 路径编号 + 是否反向
+struct Step {
+    uint32_t path;
+    bool reversed;
+};
+
+// 两个非 PU/PD 命令之间的一组路径
+struct Segment {
+    std::vector<uint32_t> paths;
+    Point startPosition;
+    bool hasTrailingPu = false;       // 段末尾没有被落刀使用的抬刀移动 (如回原点)
+    bool trailingPuHasCoords = false;
+    Point trailingPu;
+};
+
+// 按顺序输出的条目: 一段路径, 或一条原样保留的命令
+struct Item {
+    bool isSegment;
+    uint32_t index;   // segments 下标或 program.commands 下标
+};
+
+double Distance(Point a, Point b)
+{
+    double dx = static_cast<double>(a.x) - b.x;
+    double dy = static_cast<double>(a.y) - b.y;
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+class Sequencer {
+public:
+    Sequencer(const std::vector<Point> &points, const std::vector<Path> &paths, const PltReorderOptions &options)
+        : points(points), paths(paths), options(options)
+    {
+    }
+
+    Point Entry(const Step &step) const
+    {
+        const Path &path = paths[step.path];
+        return points[step.reversed ? path.first + path.count - 1 : path.first];
+    }
+
+    Point Exit(const Step &step) const
+    {
+        const Path &path = paths[step.path];
+        return points[step.reversed ? path.first : path.first + path.count - 1];
+    }
+
+    double TravelCost(Point start, const std::vector<Step> &order) const
+    {
+        double cost = 0;
+        Point position = start;
+        for (const Step &step : order)
+        {
+            cost += Distance(position, Entry(step));
+            position = Exit(step);
+        }
+        return cost;
+    }
+
+    // 对一组路径排序: 最近邻构造 + 窗口化的 2-opt 改进
+    std::vector<Step> Solve(const std::vector<uint32_t> &group, Point start) const
+    {
+        std::vector<Step> order = NearestNeighbour(group, start);
+        if (options.allowReverse)
+        {
+            TwoOpt(order, start);
+        }
+        return order;
+    }
+
+private:
+    std::vector<Step> NearestNeighbour(const std::vector<uint32_t> &group, Point start) const
+    {
+        std::vector<Step> order;
+        order.reserve(group.size());
+        std::vector<bool> used(group.size(), false);
+        Point position = start;
+
+        for (size_t n = 0; n < group.size(); n++)
+        {
+            double best = std::numeric_limits<double>::max();
+            size_t bestIndex = 0;
+            bool bestReversed = false;
+
+            for (size_t i = 0; i < group.size(); i++)
+            {
+                if (used[i])
+                {
+                    continue;
+                }
+                Step forward{group[i], false};
+                double d = Distance(position, Entry(forward));
+                if (d < best)
+                {
+                    best = d;
+                    bestIndex = i;
+                    bestReversed = false;
+                }
+                if (options.allowReverse)
+                {
+                    Step backward{group[i], true};
+                    d = Distance(position, Entry(backward));
+                    if (d < best)
+                    {
+                        best = d;
+                        bestIndex = i;
+                        bestReversed = true;
+                    }
+                }
+            }
+
+            used[bestIndex] = true;
+            order.push_back(Step{group[bestIndex], bestReversed});
+            position = Exit(order.back());
+        }
+        return order;
+    }
+
+    // 反转 order[i..j] 并翻转其中每条路径的方向, 只有两端的抬刀移动发生变化
+    void TwoOpt(std::vector<Step> &order, Point start) const
+    {
+        const size_t WINDOW = 64;
+        const double EPSILON = 1e-6;
+        size_t n = order.size();
+
+        for (int pass = 0; pass < options.twoOptPasses; pass++)
+        {
+            bool improved = false;
+            for (size_t i = 0; i < n; i++)
+            {
+                Point before = i == 0 ? start : Exit(order[i - 1]);
+                Point first = Entry(order[i]);
+                for (size_t j = i + 1; j < n && j < i + WINDOW; j++)
+                {
+                    Point last = Exit(order[j]);
+                    double oldCost = Distance(before, first);
+                    double newCost = Distance(before, last);
+                    if (j + 1 < n)
+                    {
+                        Point after = Entry(order[j + 1]);
+                        oldCost += Distance(last, after);
+                        newCost += Distance(first, after);
+                    }
+
+                    if (newCost + EPSILON < oldCost)
+                    {
+                        std::reverse(order.begin() + i, order.begin() + j + 1);
+                        for (size_t k = i; k <= j; k++)
+                        {
+                            order[k].reversed = !order[k].reversed;
+                        }
+                        first = Entry(order[i]);
+                        improved = true;
+                    }
+                }
+            }
+            if (!improved)
+            {
+                break;
+            }
+        }
+    }
+
+    const std::vector<Point> &points;
+    const std::vector<Path> &paths;
+    const PltReorderOptions &options;
+};
+
+// 大作业按路径起点分成 g x g 个空间块, 块内并行排序, 块之间按蛇形顺序连接
+std::vector<Step> SolveSegment(const Sequencer &sequencer, const std::vector<Point> &points,
+                               const std::vector<Path> &paths, const Segment &segment,
+                               const PltReorderOptions &options)
+{
+    size_t n = segment.paths.size();
+    if (n <= options.tileThreshold || options.tileThreshold == 0)
+    {
+        return sequencer.Solve(segment.paths, segment.startPosition);
+    }
+
+    int32_t minX = std::numeric_limits<int32_t>::max();
+    int32_t minY = minX;
+    int32_t maxX = std::numeric_limits<int32_t>::min();
+    int32_t maxY = maxX;
+    for (uint32_t index : segment.paths)
+    {
+        Point p = points[paths[index].first];
+        minX = std::min(minX, p.x);
+        maxX = std::max(maxX, p.x);
+        minY = std::min(minY, p.y);
+        maxY = std::max(maxY, p.y);
+    }
+
+    size_t grid = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(n) / options.tileThreshold)));
+    double cellW = (static_cast<double>(maxX) - minX + 1) / grid;
+    double cellH = (static_cast<double>(maxY) - minY + 1) / grid;
+
+    std::vector<std::vector<uint32_t>> tiles(grid * grid);
+    for (uint32_t index : segment.paths)
+    {
+        Point p = points[paths[index].first];
+        size_t col = std::min(grid - 1, static_cast<size_t>((p.x - static_cast<double>(minX)) / cellW));
+        size_t row = std::min(grid - 1, static_cast<size_t>((p.y - static_cast<double>(minY)) / cellH));
+        // 蛇形顺序: 偶数行从左到右, 奇数行从右到左
+        size_t order = row * grid + ((row % 2 == 0) ? col : grid - 1 - col);
+        tiles[order].push_back(index);
+    }
+
+    // 每个块从靠近上一块的一侧进入
+    std::vector<std::vector<Step>> results(tiles.size());
+    ThreadPool::Shared().ParallelFor(tiles.size(), [&](size_t t) {
+        if (tiles[t].empty())
+        {
+            return;
+        }
+        size_t row = t / grid;
+        size_t col = (row % 2 == 0) ? t % grid : grid - 1 - t % grid;
+        Point entry;
+        entry.x = static_cast<int32_t>(minX + cellW * ((row % 2 == 0) ? col : col + 1));
+        entry.y = static_cast<int32_t>(minY + cellH * row);
+        if (t == 0)
+        {
+            entry = segment.startPosition;
+        }
+        results[t] = sequencer.Solve(tiles[t], entry);
+    });
+
+    std::vector<Step> order;
+    order.reserve(n);
+    for (auto &tile : results)
+    {
+        order.insert(order.end(), tile.begin(), tile.end());
+    }
+    return order;
+}
+
+} // namespace
+
+bool ReorderPlt(const PltProgram &program, const PltReorderOptions &options,
+                std::vector<uint8_t> &out, PltReorderStats *stats)
+{
+    // 相对坐标下每个点都依赖前一个位置, 移动任何一段都会改变后面所有路径
+    for (const PltCommand &command : program.commands)
+    {
+        bool relative = false;
+        if (PltSetsCoordinateMode(program, command, relative) && relative)
+        {
+            return false;
+        }
+    }
+
+    std::vector<Point> points;
+    std::vector<Path> paths;
+    std::vector<Segment> segments;
+    std::vector<Item> items;
+
+    // 1. 把命令流拆成路径段和原样保留的命令
+    Point position{0, 0};
+    bool pathOpen = false;
+    bool hasPendingPu = false;
+    bool pendingPuHasCoords = false;
+    Point pendingPu{0, 0};
+
+    auto currentSegment = [&]() -> Segment & {
+        if (items.empty() || !items.back().isSegment)
+        {
+            Segment segment;
+            segment.startPosition = position;
+            segments.push_back(segment);
+            items.push_back(Item{true, static_cast<uint32_t>(segments.size() - 1)});
+        }
+        return segments.back();
+    };
+
+    auto closeSegment = [&]() {
+        pathOpen = false;
+        if (hasPendingPu)
+        {
+            Segment &segment = currentSegment();
+            segment.hasTrailingPu = true;
+            segment.trailingPuHasCoords = pendingPuHasCoords;
+            segment.trailingPu = pendingPu;
+            hasPendingPu = false;
+            pendingPuHasCoords = false;
+        }
+    };
+
+    for (size_t c = 0; c < program.commands.size(); c++)
+    {
+        const PltCommand &command = program.commands[c];
+        const int32_t *args = program.args.data() + command.argOffset;
+
+        if (command.op == PltOp::PU)
+        {
+            pathOpen = false;
+            hasPendingPu = true;
+            if (command.argCount >= 2)
+            {
+                uint32_t last = (command.argCount & ~1u) - 2;
+                pendingPu = Point{args[last], args[last + 1]};
+                pendingPuHasCoords = true;
+                position = pendingPu;
+            }
+            continue;
+        }
+
+        if (command.op == PltOp::PD && command.argCount >= 2)
+        {
+            Segment &segment = currentSegment();
+            if (!pathOpen)
+            {
+                Path path;
+                path.first = static_cast<uint32_t>(points.size());
+                path.count = 1;
+                points.push_back(position);
+                paths.push_back(path);
+                segment.paths.push_back(static_cast<uint32_t>(paths.size() - 1));
+                pathOpen = true;
+                hasPendingPu = false;
+                pendingPuHasCoords = false;
+            }
+            for (uint32_t i = 0; i + 1 < command.argCount; i += 2)
+            {
+                position = Point{args[i], args[i + 1]};
+                points.push_back(position);
+                paths.back().count++;
+            }
+            continue;
+        }
+
+        // 其他命令 (包括无参数的 PD) 原样保留, 作为重排的边界
+        closeSegment();
+        items.push_back(Item{false, static_cast<uint32_t>(c)});
+        if (command.op == PltOp::IN)
+        {
+            position = Point{0, 0};
+        }
+    }
+    closeSegment();
+
+    // 2. 每段独立排序
+    Sequencer sequencer(points, paths, options);
+    std::vector<std::vector<Step>> orders(segments.size());
+    for (size_t s = 0; s < segments.size(); s++)
+    {
+        orders[s] = SolveSegment(sequencer, points, paths, segments[s], options);
+
+        if (stats)
+        {
+            std::vector<Step> original;
+            for (uint32_t index : segments[s].paths)
+            {
+                original.push_back(Step{index, false});
+            }
+            stats->paths += segments[s].paths.size();
+            stats->penUpBefore += sequencer.TravelCost(segments[s].startPosition, original);
+            stats->penUpAfter += sequencer.TravelCost(segments[s].startPosition, orders[s]);
+        }
+    }
+
+    // 3. 输出
+    PltWriter writer(out);
+    writer.Reserve(program.args.size() * 6 + program.commands.size() * 3);
+    for (const Item &item : items)
+    {
+        if (!item.isSegment)
+        {
+            WritePltCommand(program, program.commands[item.index], writer);
+            continue;
+        }
+
+        const Segment &segment = segments[item.index];
+        for (const Step &step : orders[item.index])
+        {
+            const Path &path = paths[step.path];
+            for (uint32_t k = 0; k < path.count; k++)
+            {
+                uint32_t offset = step.reversed ? path.count - 1 - k : k;
+                Point p = points[path.first + offset];
+                writer.Point(k == 0 ? "PU" : "PD", p.x, p.y);
+            }
+        }
+
+        if (segment.hasTrailingPu)
+        {
+            if (segment.trailingPuHasCoords)
+            {
+                writer.Point("PU", segment.trailingPu.x, segment.trailingPu.y);
+            }
+            else
+            {
+                writer.Raw("PU;");
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "plt_parser.h"
+#include <cstddef>
+#include <vector>
+
+struct PltReorderOptions {
+    bool allowReverse = true;      // 允许反向切割路径 (用终点作为起点)
+    int twoOptPasses = 2;          // 2-opt 改进的遍数, 0 表示只做最近邻
+    size_t tileThreshold = 2000;   // 路径数超过该值时按空间分块, 在线程池中并行排序
+};
+
+struct PltReorderStats {
+    size_t paths = 0;
+    double penUpBefore = 0;   // 排序前抬刀移动的总距离 (设备单位)
+    double penUpAfter = 0;
+};
+
+// 重新排列 PLT 中的切割路径以减少抬刀移动距离.
+// 每条路径 = 抬刀移动到起点 + 一段连续的落刀点. 路径只在相邻的非 PU/PD 命令之间重排,
+// 这些命令 (IN/TB/CT/PG 等) 保持原位置.
+// 作业中出现 PR (相对坐标) 时路径无法独立移动, 不做重排并返回 false (out 不变)
+bool ReorderPlt(const PltProgram &program, const PltReorderOptions &options,
+                std::vector<uint8_t> &out, PltReorderStats *stats = nullptr);
@@ -0,0 +1,177 @@
+#include "plt_streamer.h"
+#include <chrono>
+
+namespace {
+
+// 环形缓冲区容量为块大小的 4 倍, 保证切块时总能看到完整的下一块
+const size_t RING_CHUNKS = 4;
+
+} // namespace
+
+PltStreamer::PltStreamer(size_t chunkSize)
+    : chunkSize(chunkSize > 0 ? chunkSize : DEFAULT_CHUNK_SIZE),
+      ring(this->chunkSize * RING_CHUNKS),
+      cancelled(false),
+      bytesSent(0),
+      totalBytes(0)
+{
+}
+
+void PltStreamer::Cancel()
+{
+    cancelled = true;
+}
+
+size_t PltStreamer::NextChunkLength(bool sourceDone) const
+{
+    size_t available = ring.Size();
+    if (available <= chunkSize)
+    {
+        // 数据已全部进入缓冲区, 剩余部分直接作为最后一块
+        if (sourceDone)
+        {
+            return available;
+        }
+    }
+
+    size_t boundary = ring.FindLastWithin(';', chunkSize);
+    if (boundary > 0)
+    {
+        return boundary;
+    }
+
+    // 单条命令超过块大小时只能在中间切开
+    return available < chunkSize ? available : chunkSize;
+}
+
+size_t PltStreamer::ContiguousChunkLength(const uint8_t *data, uint64_t remaining) const
+{
+    if (remaining <= chunkSize)
+    {
+        return static_cast<size_t>(remaining);
+    }
+
+    for (size_t i = chunkSize; i > 0; i--)
+    {
+        if (data[i - 1] == ';')
+        {
+            return i;
+        }
+    }
+
+    // 单条命令超过块大小时只能在中间切开
+    return chunkSize;
+}
+
+bool PltStreamer::Run(ChunkSource &source, const WriteFn &write, const ProgressFn &progress, int progressIntervalMs,
+                      const RecoverFn &recover)
+{
+    using Clock = std::chrono::steady_clock;
+
+    cancelled = false;
+    bytesSent = 0;
+    totalBytes = source.Size();
+    ring.Clear();
+
+    const uint8_t *contiguous = source.Data();
+    uint64_t position = 0;
+    std::vector<uint8_t> readBuffer(contiguous ? 0 : chunkSize);
+    bool sourceDone = false;
+    Clock::time_point start = Clock::now();
+    Clock::time_point lastReport = start;
+
+    auto report = [&](bool done) {
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        Progress p;
+        p.bytesSent = bytesSent.load();
+        p.totalBytes = totalBytes.load();
+        p.bytesPerSecond = seconds > 0 ? p.bytesSent / seconds : 0.0;
+        p.done = done;
+        progress(p);
+    };
+
+    while (!cancelled)
+    {
+        size_t length;
+        if (contiguous)
+        {
+            // 源数据整体在内存中 (例如固定的 JS Buffer 或映射的文件): 直接切块写入
+            uint64_t remaining = totalBytes.load() - position;
+            if (remaining == 0)
+            {
+                break;
+            }
+            length = ContiguousChunkLength(contiguous + position, remaining);
+            if (!write(contiguous + position, length))
+            {
+                if (recover && !cancelled && recover())
+                {
+                    continue;
+                }
+                return false;
+            }
+            position += length;
+        }
+        else
+        {
+            // 1. 尽量填满环形缓冲区
+            while (!sourceDone && ring.Space() >= chunkSize)
+            {
+                size_t n = source.Read(readBuffer.data(), chunkSize);
+                if (n == 0)
+                {
+                    sourceDone = true;
+                    break;
+                }
+                ring.Write(readBuffer.data(), n);
+            }
+
+            if (ring.Empty())
+            {
+                break;
+            }
+
+            // 2. 在命令边界处切出一块并写入 (跨越缓冲区末尾时分两段写)
+            length = NextChunkLength(sourceDone);
+            size_t offset = 0;
+            while (offset < length)
+            {
+                const uint8_t *span = nullptr;
+                size_t spanLength = ring.Span(offset, &span);
+                if (spanLength > length - offset)
+                {
+                    spanLength = length - offset;
+                }
+                if (!write(span, spanLength))
+                {
+                    // 块的前一段可能已经写出, 恢复后整块重写 (数据在 Consume 之前仍在环形缓冲区中)
+                    if (recover && !cancelled && recover())
+                    {
+                        offset = 0;
+                        continue;
+                    }
+                    return false;
+                }
+                offset += spanLength;
+            }
+            ring.Consume(length);
+        }
+
+        // 3. 更新进度
+        bytesSent += length;
+        Clock::time_point now = Clock::now();
+        if (std::chrono::duration_cast<std::chrono::milliseconds>(now - lastReport).count() >= progressIntervalMs)
+        {
+            lastReport = now;
+            report(false);
+        }
+    }
+
+    if (cancelled)
+    {
+        return false;
+    }
+
+    report(true);
+    return true;
+}
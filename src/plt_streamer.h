@@ -0,0 +1,52 @@
+#pragma once
+#include "chunk_source.h"
+#include "ring_buffer.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+// PLT 分块发送器
+// 从 ChunkSource 拉取数据到有界环形缓冲区, 在命令边界 (';') 处切分成不超过 chunkSize 的块,
+// 逐块交给 write 回调写入设备, 并在每块之后更新进度.
+// 数据源整体在内存中 (ChunkSource::Data) 时直接从源数据切块, 不复制到环形缓冲区.
+class PltStreamer {
+public:
+    struct Progress {
+        uint64_t bytesSent;
+        uint64_t totalBytes;
+        double bytesPerSecond;
+        bool done;
+    };
+
+    // 返回 false 表示写入失败, 作业终止
+    typedef std::function<bool(const uint8_t *data, size_t length)> WriteFn;
+    typedef std::function<void(const Progress &progress)> ProgressFn;
+    // 写入失败后调用: 返回 true 表示设备已恢复, 从失败的块的开头 (命令边界) 重新写入
+    typedef std::function<bool()> RecoverFn;
+
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 4096;
+
+    explicit PltStreamer(size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+    // 阻塞地发送整个作业; progressIntervalMs 控制进度回调的最小间隔 (最后一次总会回调)
+    // recover 为空时写入失败即终止作业
+    bool Run(ChunkSource &source, const WriteFn &write, const ProgressFn &progress, int progressIntervalMs,
+             const RecoverFn &recover = RecoverFn());
+
+    // 可从其他线程调用, 在下一个块边界处停止
+    void Cancel();
+    bool Cancelled() const { return cancelled.load(); }
+
+    uint64_t BytesSent() const { return bytesSent.load(); }
+    uint64_t TotalBytes() const { return totalBytes.load(); }
+
+private:
+    size_t NextChunkLength(bool sourceDone) const;
+    size_t ContiguousChunkLength(const uint8_t *data, uint64_t remaining) const;
+
+    size_t chunkSize;
+    ByteRing ring;
+    std::atomic<bool> cancelled;
+    std::atomic<uint64_t> bytesSent;
+    std::atomic<uint64_t> totalBytes;
+};
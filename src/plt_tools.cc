@@ -0,0 +1,348 @@
+#include "plt_tools.h"
+#include "js_buffer.h"
+#include "plt_builder.h"
+#include "plt_flatten.h"
+#include "plt_parser.h"
+#include "plt_reorder.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 读取可选的非负数参数 (不存在时 value 不变); 不是数字时抛出 TypeError,
+// 负数、NaN 或无穷大时抛出 RangeError. 抛出异常时返回 false
+bool ReadNonNegativeOption(Napi::Object options, const char *name, double &value)
+{
+    if (!options.Has(name))
+    {
+        return true;
+    }
+
+    Napi::Value option = options.Get(name);
+    if (!option.IsNumber())
+    {
+        Napi::TypeError::New(options.Env(), std::string(name) + " must be a number").ThrowAsJavaScriptException();
+        return false;
+    }
+    double number = option.As<Napi::Number>().DoubleValue();
+    if (!(number >= 0) || !std::isfinite(number))
+    {
+        Napi::RangeError::New(options.Env(), std::string(name) + " must be a finite number >= 0").ThrowAsJavaScriptException();
+        return false;
+    }
+    value = number;
+    return true;
+}
+
+Napi::Value OptimizePltFunction(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsBuffer())
+    {
+        Napi::TypeError::New(env, "Expected buffer as argument").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
+
+    // 可选参数: { tolerance, removeCollinear, removeDuplicates, mergePoints }
+    PltOptimizeOptions options;
+    if (info.Length() >= 2 && info[1].IsObject())
+    {
+        Napi::Object jsOptions = info[1].As<Napi::Object>();
+        if (!ReadNonNegativeOption(jsOptions, "tolerance", options.tolerance))
+        {
+            return env.Null();
+        }
+        if (jsOptions.Has("removeCollinear"))
+        {
+            options.removeCollinear = jsOptions.Get("removeCollinear").ToBoolean().Value();
+        }
+        if (jsOptions.Has("removeDuplicates"))
+        {
+            options.removeDuplicates = jsOptions.Get("removeDuplicates").ToBoolean().Value();
+        }
+        if (jsOptions.Has("mergePoints"))
+        {
+            options.mergePoints = jsOptions.Get("mergePoints").ToBoolean().Value();
+        }
+    }
+
+    PltProgram program;
+    ParsePlt(buffer.Data(), buffer.Length(), program);
+
+    std::vector<uint8_t> *output = BufferPool::Shared().Acquire(buffer.Length());
+    OptimizePlt(program, options, *output);
+
+    return ToJsBuffer(env, output);
+}
+
+// 读取 prefix/suffix 选项 (字符串或 Buffer), 追加到 out
+bool AppendBytesOption(Napi::Object options, const char *name, std::vector<uint8_t> &out)
+{
+    if (!options.Has(name))
+    {
+        return true;
+    }
+
+    Napi::Value value = options.Get(name);
+    if (value.IsBuffer())
+    {
+        Napi::Buffer<uint8_t> bytes = value.As<Napi::Buffer<uint8_t>>();
+        out.insert(out.end(), bytes.Data(), bytes.Data() + bytes.Length());
+        return true;
+    }
+    if (value.IsString())
+    {
+        std::string text = value.As<Napi::String>().Utf8Value();
+        out.insert(out.end(), text.begin(), text.end());
+        return true;
+    }
+    return value.IsUndefined();
+}
+
+Napi::Value BuildPltFunction(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsTypedArray() ||
+        info[0].As<Napi::TypedArray>().TypedArrayType() != napi_int32_array)
+    {
+        Napi::TypeError::New(env, "Expected Int32Array of x,y coordinates").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Int32Array coords = info[0].As<Napi::Int32Array>();
+    if (coords.ElementLength() % 2 != 0)
+    {
+        Napi::RangeError::New(env, "Coordinate stream must hold x,y pairs").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    size_t points = coords.ElementLength() / 2;
+
+    // 可选的刀状态数组, 每个点一个字节
+    const uint8_t *pens = nullptr;
+    if (info.Length() >= 2 && !info[1].IsUndefined() && !info[1].IsNull())
+    {
+        if (!info[1].IsTypedArray() || info[1].As<Napi::TypedArray>().TypedArrayType() != napi_uint8_array)
+        {
+            Napi::TypeError::New(env, "Expected Uint8Array of pen states").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        Napi::Uint8Array penStates = info[1].As<Napi::Uint8Array>();
+        if (penStates.ElementLength() != points)
+        {
+            Napi::RangeError::New(env, "Pen state array must have one entry per point").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        pens = penStates.Data();
+    }
+
+    // 可选参数: { mergePoints, prefix, suffix }
+    PltBuildOptions options;
+    Napi::Object jsOptions = (info.Length() >= 3 && info[2].IsObject()) ? info[2].As<Napi::Object>() : Napi::Object::New(env);
+    if (jsOptions.Has("mergePoints"))
+    {
+        options.mergePoints = jsOptions.Get("mergePoints").ToBoolean().Value();
+    }
+
+    std::vector<uint8_t> *output = BufferPool::Shared().Acquire(PltBuildBound(points) + 64);
+    if (!AppendBytesOption(jsOptions, "prefix", *output))
+    {
+        BufferPool::Shared().Release(output);
+        Napi::TypeError::New(env, "prefix must be a string or Buffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    BuildPlt(coords.Data(), pens, points, options, *output);
+
+    if (!AppendBytesOption(jsOptions, "suffix", *output))
+    {
+        BufferPool::Shared().Release(output);
+        Napi::TypeError::New(env, "suffix must be a string or Buffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    return ToJsBuffer(env, output);
+}
+
+Napi::Value FlattenCurvesFunction(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsTypedArray() ||
+        info[0].As<Napi::TypedArray>().TypedArrayType() != napi_uint8_array)
+    {
+        Napi::TypeError::New(env, "Expected Uint8Array of curve verbs").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (!info[1].IsTypedArray() || info[1].As<Napi::TypedArray>().TypedArrayType() != napi_float64_array)
+    {
+        Napi::TypeError::New(env, "Expected Float64Array of curve coordinates").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Uint8Array verbs = info[0].As<Napi::Uint8Array>();
+    Napi::Float64Array coords = info[1].As<Napi::Float64Array>();
+
+    // 可选参数: { tolerance, mergePoints, prefix, suffix }
+    PltFlattenOptions flattenOptions;
+    PltBuildOptions buildOptions;
+    Napi::Object jsOptions = (info.Length() >= 3 && info[2].IsObject()) ? info[2].As<Napi::Object>() : Napi::Object::New(env);
+    if (!ReadNonNegativeOption(jsOptions, "tolerance", flattenOptions.tolerance))
+    {
+        return env.Null();
+    }
+    if (jsOptions.Has("mergePoints"))
+    {
+        buildOptions.mergePoints = jsOptions.Get("mergePoints").ToBoolean().Value();
+    }
+
+    std::vector<int32_t> points;
+    std::vector<uint8_t> pens;
+    std::string error;
+    if (!FlattenCurves(verbs.Data(), verbs.ElementLength(), coords.Data(), coords.ElementLength(),
+                       flattenOptions, points, pens, error))
+    {
+        Napi::RangeError::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::vector<uint8_t> *output = BufferPool::Shared().Acquire(PltBuildBound(pens.size()) + 64);
+    if (!AppendBytesOption(jsOptions, "prefix", *output))
+    {
+        BufferPool::Shared().Release(output);
+        Napi::TypeError::New(env, "prefix must be a string or Buffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    BuildPlt(points.data(), pens.data(), pens.size(), buildOptions, *output);
+
+    if (!AppendBytesOption(jsOptions, "suffix", *output))
+    {
+        BufferPool::Shared().Release(output);
+        Napi::TypeError::New(env, "suffix must be a string or Buffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    return ToJsBuffer(env, output);
+}
+
+// 路径重排计算量较大, 在 libuv 线程池中执行, 不阻塞 JS 线程
+class ReorderWorker : public Napi::AsyncWorker
+{
+public:
+    ReorderWorker(Napi::Env env, Napi::Buffer<uint8_t> buffer, const PltReorderOptions &options)
+        : Napi::AsyncWorker(env, "PltReorder"),
+          deferred(Napi::Promise::Deferred::New(env)),
+          data(buffer.Data()),
+          length(buffer.Length()),
+          options(options),
+          output(BufferPool::Shared().Acquire(0))
+    {
+        // 保持输入 Buffer 存活, 直到后台计算完成
+        bufferRef = Napi::Persistent(static_cast<Napi::Object>(buffer));
+    }
+
+    ~ReorderWorker()
+    {
+        BufferPool::Shared().Release(output);
+    }
+
+    Napi::Promise Promise() const
+    {
+        return deferred.Promise();
+    }
+
+protected:
+    void Execute() override
+    {
+        PltProgram program;
+        ParsePlt(data, length, program);
+        output->reserve(length);
+        if (!ReorderPlt(program, options, *output, &stats))
+        {
+            // 不能重排的作业原样返回
+            output->assign(data, data + length);
+        }
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = Env();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("data", ToJsBuffer(env, output));
+        output = nullptr;
+        result.Set("paths", Napi::Number::New(env, static_cast<double>(stats.paths)));
+        result.Set("penUpBefore", Napi::Number::New(env, stats.penUpBefore));
+        result.Set("penUpAfter", Napi::Number::New(env, stats.penUpAfter));
+        deferred.Resolve(result);
+    }
+
+    void OnError(const Napi::Error &error) override
+    {
+        deferred.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    Napi::ObjectReference bufferRef;
+    const uint8_t *data;
+    size_t length;
+    PltReorderOptions options;
+    std::vector<uint8_t> *output;
+    PltReorderStats stats;
+};
+
+Napi::Value ReorderPltFunction(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsBuffer())
+    {
+        Napi::TypeError::New(env, "Expected buffer as argument").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // 可选参数: { allowReverse, twoOptPasses, tileThreshold }
+    PltReorderOptions options;
+    if (info.Length() >= 2 && info[1].IsObject())
+    {
+        Napi::Object jsOptions = info[1].As<Napi::Object>();
+        if (jsOptions.Has("allowReverse"))
+        {
+            options.allowReverse = jsOptions.Get("allowReverse").ToBoolean().Value();
+        }
+        // 遍数和阈值取整数部分; 过大的值等同于不设上限
+        double passes = options.twoOptPasses;
+        double threshold = static_cast<double>(options.tileThreshold);
+        if (!ReadNonNegativeOption(jsOptions, "twoOptPasses", passes) ||
+            !ReadNonNegativeOption(jsOptions, "tileThreshold", threshold))
+        {
+            return env.Null();
+        }
+        options.twoOptPasses = static_cast<int>(std::min(passes, static_cast<double>(INT_MAX)));
+        options.tileThreshold = static_cast<size_t>(std::min(threshold, static_cast<double>(SIZE_MAX / 2)));
+    }
+
+    ReorderWorker *worker = new ReorderWorker(env, info[0].As<Napi::Buffer<uint8_t>>(), options);
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();
+    return promise;
+}
+
+} // namespace
+
+Napi::Object InitPltTools(Napi::Env env, Napi::Object exports)
+{
+    exports.Set("optimizePlt", Napi::Function::New(env, OptimizePltFunction, "optimizePlt"));
+    exports.Set("buildPlt", Napi::Function::New(env, BuildPltFunction, "buildPlt"));
+    exports.Set("flattenCurves", Napi::Function::New(env, FlattenCurvesFunction, "flattenCurves"));
+    exports.Set("reorderPlt", Napi::Function::New(env, ReorderPltFunction, "reorderPlt"));
+    return exports;
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <napi.h>
+
+// PLT 处理工具函数 (与设备无关), 作为模块级函数导出:
+//   optimizePlt(buffer, options) -> Buffer
+//   buildPlt(coords, pens, options) -> Buffer
+//   flattenCurves(verbs, coords, options) -> Buffer
+//   reorderPlt(buffer, options) -> Promise<{ data, paths, penUpBefore, penUpAfter }>
+Napi::Object InitPltTools(Napi::Env env, Napi::Object exports);
@@ -0,0 +1,118 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// 一个 int32 十进制表示的最大长度 ("-2147483648")
+const size_t MAX_INT_CHARS = 11;
+
+// 两位数查表: 每次除以 100 输出两个数字, 除法次数减半
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+inline unsigned DecimalLength(uint32_t v)
+{
+    if (v < 10) return 1;
+    if (v < 100) return 2;
+    if (v < 1000) return 3;
+    if (v < 10000) return 4;
+    if (v < 100000) return 5;
+    if (v < 1000000) return 6;
+    if (v < 10000000) return 7;
+    if (v < 100000000) return 8;
+    if (v < 1000000000) return 9;
+    return 10;
+}
+
+// 把整数写到 dst (至少 MAX_INT_CHARS 字节), 返回写入后的位置; 不写结尾的 '\0'
+inline char *FormatInt(char *dst, int32_t value)
+{
+    uint32_t magnitude = static_cast<uint32_t>(value);
+    if (value < 0)
+    {
+        *dst++ = '-';
+        magnitude = 0u - magnitude;
+    }
+
+    unsigned length = DecimalLength(magnitude);
+    char *end = dst + length;
+    char *p = end;
+    while (magnitude >= 100)
+    {
+        unsigned pair = (magnitude % 100) * 2;
+        magnitude /= 100;
+        *--p = DIGIT_PAIRS[pair + 1];
+        *--p = DIGIT_PAIRS[pair];
+    }
+    if (magnitude >= 10)
+    {
+        unsigned pair = magnitude * 2;
+        *--p = DIGIT_PAIRS[pair + 1];
+        *--p = DIGIT_PAIRS[pair];
+    }
+    else
+    {
+        *--p = static_cast<char>('0' + magnitude);
+    }
+    return end;
+}
+
+// PLT 输出缓冲区: 直接把命令和整数坐标写成 ASCII 字节
+class PltWriter {
+public:
+    explicit PltWriter(std::vector<uint8_t> &out)
+        : out(out)
+    {
+    }
+
+    void Reserve(size_t bytes)
+    {
+        out.reserve(out.size() + bytes);
+    }
+
+    void Raw(const char *text, size_t length)
+    {
+        out.insert(out.end(), text, text + length);
+    }
+
+    void Raw(const char *text)
+    {
+        Raw(text, strlen(text));
+    }
+
+    void Char(char c)
+    {
+        out.push_back(static_cast<uint8_t>(c));
+    }
+
+    // 写入十进制整数
+    void Int(int32_t value)
+    {
+        char digits[MAX_INT_CHARS];
+        char *end = FormatInt(digits, value);
+        out.insert(out.end(), digits, end);
+    }
+
+    // 写入 "PDx,y;" 形式的单点命令
+    void Point(const char *op, int32_t x, int32_t y)
+    {
+        Raw(op, 2);
+        Int(x);
+        Char(',');
+        Int(y);
+        Char(';');
+    }
+
+private:
+    std::vector<uint8_t> &out;
+};
@@ -0,0 +1,161 @@
+#include "profile_binding.h"
+#include <vector>
+
+bool ReadFlowProfile(Napi::Object options, FlowProfile &profile, std::string &error)
+{
+    if (options.Has("bufferSize"))
+    {
+        profile.bufferSize = options.Get("bufferSize").As<Napi::Number>().Uint32Value();
+    }
+    if (options.Has("highWatermark"))
+    {
+        profile.highWatermark = options.Get("highWatermark").As<Napi::Number>().DoubleValue();
+    }
+    if (options.Has("lowWatermark"))
+    {
+        profile.lowWatermark = options.Get("lowWatermark").As<Napi::Number>().DoubleValue();
+    }
+    if (options.Has("drainRate"))
+    {
+        profile.drainRate = options.Get("drainRate").As<Napi::Number>().DoubleValue();
+    }
+    if (options.Has("statusCommand"))
+    {
+        profile.statusCommand = options.Get("statusCommand").As<Napi::String>().Utf8Value();
+    }
+    if (options.Has("statusInterval"))
+    {
+        profile.statusInterval = options.Get("statusInterval").As<Napi::Number>().Int32Value();
+    }
+
+    if (!(profile.lowWatermark > 0 && profile.lowWatermark <= profile.highWatermark && profile.highWatermark <= 1))
+    {
+        error = "Expected 0 < lowWatermark <= highWatermark <= 1";
+        return false;
+    }
+    if (profile.drainRate < 0 || profile.statusInterval <= 0)
+    {
+        error = "drainRate and statusInterval must be positive";
+        return false;
+    }
+    return true;
+}
+
+Napi::Object DeviceProfileToJs(Napi::Env env, const DeviceProfile &profile)
+{
+    Napi::Object flow = Napi::Object::New(env);
+    flow.Set("bufferSize", Napi::Number::New(env, profile.flow.bufferSize));
+    flow.Set("highWatermark", Napi::Number::New(env, profile.flow.highWatermark));
+    flow.Set("lowWatermark", Napi::Number::New(env, profile.flow.lowWatermark));
+    flow.Set("drainRate", Napi::Number::New(env, profile.flow.drainRate));
+    flow.Set("statusCommand", Napi::String::New(env, profile.flow.statusCommand));
+    flow.Set("statusInterval", Napi::Number::New(env, profile.flow.statusInterval));
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("name", Napi::String::New(env, profile.name));
+    result.Set("vendorId", Napi::Number::New(env, profile.vendorId));
+    result.Set("productId", Napi::Number::New(env, profile.productId));
+    result.Set("chunkSize", Napi::Number::New(env, static_cast<double>(profile.chunkSize)));
+    result.Set("commandTimeout", Napi::Number::New(env, profile.commandTimeout));
+    result.Set("pltTimeout", Napi::Number::New(env, profile.pltTimeout));
+    result.Set("terminator", Napi::String::New(env, profile.terminator ? std::string(1, static_cast<char>(profile.terminator)) : std::string()));
+    result.Set("fileAttributes", Napi::Number::New(env, profile.fileAttributes));
+    result.Set("flowControl", flow);
+    return result;
+}
+
+namespace {
+
+// registerDeviceProfile(options): 增加或替换 (同一 VID/PID) 一个型号配置, 从下一次连接开始生效
+// 省略的字段取默认配置的值
+Napi::Value RegisterDeviceProfile(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject())
+    {
+        Napi::TypeError::New(env, "Expected profile object").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Object options = info[0].As<Napi::Object>();
+    if (!options.Has("vendorId") || !options.Has("productId"))
+    {
+        Napi::TypeError::New(env, "vendorId and productId are required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    DeviceProfile profile = DeviceProfiles::Default();
+    profile.vendorId = static_cast<uint16_t>(options.Get("vendorId").As<Napi::Number>().Uint32Value());
+    profile.productId = static_cast<uint16_t>(options.Get("productId").As<Napi::Number>().Uint32Value());
+    profile.name = options.Has("name") ? options.Get("name").As<Napi::String>().Utf8Value() : std::string("custom");
+
+    if (options.Has("chunkSize"))
+    {
+        profile.chunkSize = options.Get("chunkSize").As<Napi::Number>().Uint32Value();
+    }
+    if (options.Has("commandTimeout"))
+    {
+        profile.commandTimeout = options.Get("commandTimeout").As<Napi::Number>().Int32Value();
+    }
+    if (options.Has("pltTimeout"))
+    {
+        profile.pltTimeout = options.Get("pltTimeout").As<Napi::Number>().Int32Value();
+    }
+    if (profile.chunkSize == 0 || profile.commandTimeout <= 0 || profile.pltTimeout <= 0)
+    {
+        Napi::RangeError::New(env, "chunkSize and timeouts must be positive").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (options.Has("terminator"))
+    {
+        // 单个字符; 空字符串或 null 表示响应没有结束符
+        Napi::Value value = options.Get("terminator");
+        std::string terminator = value.IsString() ? value.As<Napi::String>().Utf8Value() : std::string();
+        if (terminator.size() > 1)
+        {
+            Napi::RangeError::New(env, "terminator must be a single character").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        profile.terminator = terminator.empty() ? 0 : static_cast<uint8_t>(terminator[0]);
+    }
+    if (options.Has("fileAttributes"))
+    {
+        profile.fileAttributes = options.Get("fileAttributes").As<Napi::Number>().Uint32Value();
+    }
+    if (options.Has("flowControl") && options.Get("flowControl").IsObject())
+    {
+        std::string error;
+        if (!ReadFlowProfile(options.Get("flowControl").As<Napi::Object>(), profile.flow, error))
+        {
+            Napi::RangeError::New(env, error).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
+    DeviceProfiles::Shared().Register(profile);
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value ListDeviceProfiles(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    std::vector<DeviceProfile> profiles = DeviceProfiles::Shared().List();
+    Napi::Array result = Napi::Array::New(env, profiles.size());
+    for (size_t i = 0; i < profiles.size(); i++)
+    {
+        result.Set(static_cast<uint32_t>(i), DeviceProfileToJs(env, profiles[i]));
+    }
+    return result;
+}
+
+} // namespace
+
+Napi::Object InitDeviceProfiles(Napi::Env env, Napi::Object exports)
+{
+    exports.Set("registerDeviceProfile", Napi::Function::New(env, RegisterDeviceProfile, "registerDeviceProfile"));
+    exports.Set("listDeviceProfiles", Napi::Function::New(env, ListDeviceProfiles, "listDeviceProfiles"));
+    return exports;
+}
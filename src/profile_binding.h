@@ -0,0 +1,15 @@
+#pragma once
+#include "device_profile.h"
+#include <napi.h>
+#include <string>
+
+// 设备型号配置的 JS 接口, 作为模块级函数导出:
+//   registerDeviceProfile({ vendorId, productId, name, chunkSize, commandTimeout, pltTimeout,
+//                           terminator, fileAttributes, flowControl }) -> true
+//   listDeviceProfiles() -> [profile]
+Napi::Object InitDeviceProfiles(Napi::Env env, Napi::Object exports);
+
+// 从 JS 对象读取流控参数 (setFlowControl 与 flowControl 字段共用), 参数不合法时返回 false 并给出 error
+bool ReadFlowProfile(Napi::Object options, FlowProfile &profile, std::string &error);
+
+Napi::Object DeviceProfileToJs(Napi::Env env, const DeviceProfile &profile);
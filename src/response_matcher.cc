@@ -0,0 +1,251 @@
+#include "response_matcher.h"
+#include "buffer_pool.h"
+#include <algorithm>
+#include <cstring>
+
+ResponseMatcher::ResponseMatcher()
+    : nextId(0),
+      terminator(';')
+{
+}
+
+namespace {
+
+// 回显前缀的最大长度, 命令名都很短
+const size_t MAX_ECHO = 8;
+
+bool IsLetter(uint8_t c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+} // namespace
+
+uint64_t ResponseMatcher::Register(Framing framing, Clock::time_point deadline, Completion completion,
+                                   const std::string &echo)
+{
+    Pending entry;
+    entry.id = nextId++;
+    entry.framing = framing;
+    entry.deadline = deadline;
+    entry.completion = std::move(completion);
+    entry.completed = false;
+    // RAW 响应没有固定格式, 不按前缀匹配
+    if (framing == Framing::TERMINATED)
+    {
+        entry.echo = echo;
+    }
+    pending.push_back(std::move(entry));
+    return pending.back().id;
+}
+
+std::string ResponseMatcher::EchoPrefix(const uint8_t *request, size_t length)
+{
+    size_t i = 0;
+    while (i < length && (request[i] == ' ' || request[i] == '\t' || request[i] == '\r' || request[i] == '\n'))
+    {
+        i++;
+    }
+    size_t start = i;
+    while (i < length && i - start < MAX_ECHO && IsLetter(request[i]))
+    {
+        i++;
+    }
+    // 只有一条命令 (名字之后紧跟 ';' 或 ':' 参数) 才是会回显的查询
+    if (i - start < 2 || i >= length || (request[i] != ';' && request[i] != ':'))
+    {
+        return std::string();
+    }
+    return std::string(reinterpret_cast<const char *>(request + start), i - start);
+}
+
+ResponseMatcher::Completion ResponseMatcher::Cancel(uint64_t id)
+{
+    Completion completion;
+    for (auto it = pending.rbegin(); it != pending.rend(); ++it)
+    {
+        if (it->id == id)
+        {
+            if (!it->completed)
+            {
+                completion = std::move(it->completion);
+            }
+            pending.erase(std::next(it).base());
+            break;
+        }
+    }
+    return completion;
+}
+
+void ResponseMatcher::Feed(const uint8_t *data, size_t length, Callbacks &callbacks)
+{
+    if (length == 0)
+    {
+        return;
+    }
+    rxBuffer.insert(rxBuffer.end(), data, data + length);
+    DispatchFrames(callbacks);
+}
+
+void ResponseMatcher::DispatchFrames(Callbacks &callbacks)
+{
+    while (!rxBuffer.empty())
+    {
+        // 排在最前的未超时请求是 RAW 时, 直接拿走当前收到的全部数据 (RAW 请求不留占位)
+        auto live = std::find_if(pending.begin(), pending.end(), [](const Pending &p) { return !p.completed; });
+        if (live != pending.end() && live->framing == Framing::RAW)
+        {
+            Completion completion = std::move(live->completion);
+            pending.erase(pending.begin(), live + 1);
+            std::vector<uint8_t> *response = BufferPool::Shared().Acquire(rxBuffer.size());
+            response->assign(rxBuffer.begin(), rxBuffer.end());
+            callbacks.push_back([completion, response]() { completion(Result::OK, response, ""); });
+            rxBuffer.clear();
+            break;
+        }
+
+        const void *end = memchr(rxBuffer.data(), terminator, rxBuffer.size());
+        if (!end)
+        {
+            break;
+        }
+
+        size_t frameLength = static_cast<size_t>(static_cast<const uint8_t *>(end) - rxBuffer.data()) + 1;
+        std::vector<uint8_t> *frame = BufferPool::Shared().Acquire(frameLength);
+        frame->assign(rxBuffer.begin(), rxBuffer.begin() + frameLength);
+        rxBuffer.erase(rxBuffer.begin(), rxBuffer.begin() + frameLength);
+
+        auto target = FindTarget(*frame);
+        if (target == pending.end())
+        {
+            UnsolicitedFn handler = unsolicited;
+            callbacks.push_back([handler, frame]() {
+                if (handler)
+                {
+                    handler(frame);
+                }
+                else
+                {
+                    BufferPool::Shared().Release(frame);
+                }
+            });
+            continue;
+        }
+
+        // 响应按顺序到达: 排在目标之前的占位不会再收到响应
+        Pending entry = std::move(*target);
+        auto next = pending.erase(target);
+        pending.erase(std::remove_if(pending.begin(), next, [](const Pending &p) { return p.completed; }), next);
+        if (entry.completed)
+        {
+            // 迟到的响应, 对应的请求已经超时
+            BufferPool::Shared().Release(frame);
+            continue;
+        }
+
+        Completion completion = std::move(entry.completion);
+        callbacks.push_back([completion, frame]() { completion(Result::OK, frame, ""); });
+    }
+}
+
+std::deque<ResponseMatcher::Pending>::iterator ResponseMatcher::FindTarget(const std::vector<uint8_t> &frame)
+{
+    auto firstLive = pending.end();
+    for (auto it = pending.begin(); it != pending.end(); ++it)
+    {
+        if (!it->echo.empty() && frame.size() >= it->echo.size() &&
+            memcmp(frame.data(), it->echo.data(), it->echo.size()) == 0)
+        {
+            return it;
+        }
+        if (!it->completed && firstLive == pending.end())
+        {
+            firstLive = it;
+        }
+    }
+    // 没有回显的设备 (或不回显的命令) 仍按顺序匹配, 只是跳过占位
+    return firstLive;
+}
+
+void ResponseMatcher::Expire(Clock::time_point now, Callbacks &callbacks)
+{
+    bool first = true;
+    for (size_t i = 0; i < pending.size(); i++)
+    {
+        Pending &entry = pending[i];
+        if (entry.completed)
+        {
+            continue;
+        }
+        bool isFirst = first;
+        first = false;
+        if (now < entry.deadline)
+        {
+            continue;
+        }
+
+        // 最前的请求超时但已收到部分数据时, 视为完整响应 (与原先的同步读取逻辑一致)
+        if (isFirst && !rxBuffer.empty())
+        {
+            std::vector<uint8_t> *response = BufferPool::Shared().Acquire(rxBuffer.size());
+            response->assign(rxBuffer.begin(), rxBuffer.end());
+            rxBuffer.clear();
+            Completion completion = std::move(entry.completion);
+            pending.erase(pending.begin() + i);
+            i--;
+            callbacks.push_back([completion, response]() { completion(Result::OK, response, ""); });
+            continue;
+        }
+
+        Completion completion = std::move(entry.completion);
+        callbacks.push_back([completion]() { completion(Result::TIMEOUT, nullptr, "Command timed out"); });
+        if (entry.echo.empty())
+        {
+            // 无法认出它的迟到响应, 留下占位只会吞掉后面请求的响应
+            pending.erase(pending.begin() + i);
+            i--;
+            continue;
+        }
+        entry.completed = true;
+    }
+
+    // 占位超过宽限期仍未收到响应, 认为设备不会再回复
+    auto grace = std::chrono::milliseconds(LATE_RESPONSE_GRACE);
+    pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                 [now, grace](const Pending &entry) {
+                                     return entry.completed && now >= entry.deadline + grace;
+                                 }),
+                  pending.end());
+}
+
+int ResponseMatcher::WaitMs(Clock::time_point now, int idleMs) const
+{
+    int waitMs = idleMs;
+    for (const Pending &entry : pending)
+    {
+        if (entry.completed)
+        {
+            continue;
+        }
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(entry.deadline - now).count();
+        if (waitMs < 0 || remaining < waitMs)
+        {
+            waitMs = std::max(0, static_cast<int>(remaining));
+        }
+    }
+    return waitMs;
+}
+
+void ResponseMatcher::FailAll(Result result, const std::string &error, Callbacks &callbacks)
+{
+    for (Pending &entry : pending)
+    {
+        if (!entry.completed)
+        {
+            Completion completion = std::move(entry.completion);
+            callbacks.push_back([completion, result, error]() { completion(result, nullptr, error); });
+        }
+    }
+    pending.clear();
+    rxBuffer.clear();
+}
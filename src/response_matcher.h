@@ -0,0 +1,91 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+// 响应匹配器: 维护在途命令的 FIFO 等待队列, 把收到的字节切分成响应帧并依次与队首匹配.
+// 不带锁也不带线程, 由调用方 (CommandMux 的读线程, DeviceReactor 的事件循环) 负责串行化.
+//
+// 协议本身不带请求编号, 只能按顺序匹配. 查询命令的响应以命令名开头 (RSVER; -> RSVER:...;),
+// 登记时记下这个回显前缀: 超时的请求作为 "占位" 继续等待 (最多 LATE_RESPONSE_GRACE 毫秒),
+// 但只接收以自己前缀开头的迟到响应, 其他帧越过占位交给后面的请求, 一个不回复的命令不会让后续响应错位.
+// RAW 请求和没有回显前缀的请求超时后直接出队, 不留占位.
+class ResponseMatcher {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum class Framing {
+        TERMINATED,  // 以结束符 (默认 ';') 结尾的响应
+        RAW          // 下一次收到的任意数据 (用于 PLT 作业的回执)
+    };
+
+    enum class Result {
+        OK,
+        TIMEOUT,
+        WRITE_FAILED,
+        CLOSED
+    };
+
+    // response 来自 BufferPool, 所有权交给回调; 失败时为 nullptr
+    typedef std::function<void(Result result, std::vector<uint8_t> *response, const std::string &error)> Completion;
+    // 没有请求等待时收到的响应帧, 所有权交给回调
+    typedef std::function<void(std::vector<uint8_t> *frame)> UnsolicitedFn;
+    // 匹配产生的回调, 由调用方在释放自己的锁之后执行
+    typedef std::vector<std::function<void()>> Callbacks;
+
+    static constexpr int LATE_RESPONSE_GRACE = 1000;
+
+    ResponseMatcher();
+
+    void SetUnsolicited(UnsolicitedFn handler) { unsolicited = std::move(handler); }
+
+    // TERMINATED 响应帧的结束符, 由设备型号配置决定
+    void SetTerminator(uint8_t value) { terminator = value; }
+
+    // 登记一个等待响应的请求, 返回编号; echo 是期望的响应前缀 (见 EchoPrefix), 为空表示不按前缀匹配
+    uint64_t Register(Framing framing, Clock::time_point deadline, Completion completion,
+                      const std::string &echo = std::string());
+
+    // 命令的回显前缀: 开头的命令名 (字母), 例如 "RSVER;" -> "RSVER", "BD:36;" -> "BD"; 不是查询命令时为空
+    static std::string EchoPrefix(const uint8_t *request, size_t length);
+
+    // 撤销登记 (写入失败时). 请求尚未完成时返回它的 completion, 否则返回空
+    Completion Cancel(uint64_t id);
+
+    // 追加收到的数据并匹配完整的响应帧
+    void Feed(const uint8_t *data, size_t length, Callbacks &callbacks);
+
+    // 处理超时的请求并清理过期的占位
+    void Expire(Clock::time_point now, Callbacks &callbacks);
+
+    // 距离最近一个截止时间的毫秒数, 没有请求在等待时返回 idleMs
+    int WaitMs(Clock::time_point now, int idleMs) const;
+
+    bool Empty() const { return pending.empty(); }
+
+    // 丢弃缓冲的数据, 所有未完成的请求以 result 结束
+    void FailAll(Result result, const std::string &error, Callbacks &callbacks);
+
+private:
+    struct Pending {
+        uint64_t id;
+        Framing framing;
+        Clock::time_point deadline;
+        Completion completion;
+        bool completed;  // 已超时, 仅作为占位等待迟到的响应
+        std::string echo;
+    };
+
+    void DispatchFrames(Callbacks &callbacks);
+    // 帧对应的请求: 先找前缀匹配的请求 (包括占位), 否则是第一个未超时的请求; 没有时返回 pending.end()
+    std::deque<Pending>::iterator FindTarget(const std::vector<uint8_t> &frame);
+
+    UnsolicitedFn unsolicited;
+    std::deque<Pending> pending;
+    uint64_t nextId;
+    uint8_t terminator;
+    std::vector<uint8_t> rxBuffer;
+};
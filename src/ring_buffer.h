@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// 固定容量的字节环形缓冲区
+// 只在单个线程 (发送线程) 中使用, 因此不加锁
+class ByteRing {
+public:
+    explicit ByteRing(size_t capacity)
+        : storage(capacity), head(0), count(0)
+    {
+    }
+
+    size_t Capacity() const { return storage.size(); }
+    size_t Size() const { return count; }
+    size_t Space() const { return storage.size() - count; }
+    bool Empty() const { return count == 0; }
+
+    // 追加数据, 返回实际写入的字节数 (受剩余空间限制)
+    size_t Write(const uint8_t *data, size_t length)
+    {
+        size_t n = length < Space() ? length : Space();
+        size_t tail = (head + count) % storage.size();
+        size_t first = n < storage.size() - tail ? n : storage.size() - tail;
+        memcpy(storage.data() + tail, data, first);
+        memcpy(storage.data(), data + first, n - first);
+        count += n;
+        return n;
+    }
+
+    // 返回从 offset 开始的一段连续可读数据; 跨越末尾时只返回前半段
+    size_t Span(size_t offset, const uint8_t **data) const
+    {
+        if (offset >= count)
+        {
+            *data = nullptr;
+            return 0;
+        }
+        size_t start = (head + offset) % storage.size();
+        size_t contiguous = storage.size() - start;
+        size_t available = count - offset;
+        *data = storage.data() + start;
+        return available < contiguous ? available : contiguous;
+    }
+
+    uint8_t At(size_t offset) const
+    {
+        return storage[(head + offset) % storage.size()];
+    }
+
+    // 在前 limit 个字节中查找最后一个 ch, 返回包括 ch 在内的长度; 没找到返回 0
+    size_t FindLastWithin(uint8_t ch, size_t limit) const
+    {
+        if (limit > count)
+        {
+            limit = count;
+        }
+        for (size_t i = limit; i > 0; i--)
+        {
+            if (At(i - 1) == ch)
+            {
+                return i;
+            }
+        }
+        return 0;
+    }
+
+    void Consume(size_t length)
+    {
+        if (length > count)
+        {
+            length = count;
+        }
+        head = (head + length) % storage.size();
+        count -= length;
+    }
+
+    void Clear()
+    {
+        head = 0;
+        count = 0;
+    }
+
+private:
+    std::vector<uint8_t> storage;
+    size_t head;
+    size_t count;
+};
@@ -0,0 +1,131 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// 固定大小的线程池, 用于把 CPU 密集的作业处理 (如路径排序) 分摊到多个核心
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads)
+        : stopping(false)
+    {
+        threads = std::max<size_t>(1, threads);
+        for (size_t i = 0; i < threads; i++)
+        {
+            workers.emplace_back(&ThreadPool::WorkerLoop, this);
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    size_t Size() const
+    {
+        return workers.size();
+    }
+
+    // 并行执行 fn(0) ... fn(count - 1), 阻塞直到全部完成.
+    // 调用线程也参与执行, 所以在池内线程中嵌套调用不会死锁.
+    void ParallelFor(size_t count, const std::function<void(size_t)> &fn)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        struct Batch {
+            std::mutex mutex;
+            std::condition_variable done;
+            size_t next = 0;
+            size_t finished = 0;
+        };
+        auto batch = std::make_shared<Batch>();
+
+        auto runOne = [batch, count, &fn]() {
+            for (;;)
+            {
+                size_t index;
+                {
+                    std::lock_guard<std::mutex> lock(batch->mutex);
+                    if (batch->next >= count)
+                    {
+                        return;
+                    }
+                    index = batch->next++;
+                }
+                fn(index);
+                {
+                    std::lock_guard<std::mutex> lock(batch->mutex);
+                    if (++batch->finished == count)
+                    {
+                        batch->done.notify_all();
+                    }
+                }
+            }
+        };
+
+        size_t helpers = std::min(count, workers.size());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < helpers; i++)
+            {
+                tasks.push(runOne);
+            }
+        }
+        cv.notify_all();
+
+        runOne();
+
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->done.wait(lock, [&] { return batch->finished == count; });
+    }
+
+    // 进程内共享的线程池, 大小为 CPU 核心数
+    static ThreadPool &Shared()
+    {
+        static ThreadPool shared(std::max(1u, std::thread::hardware_concurrency()));
+        return shared;
+    }
+
+private:
+    void WorkerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty())
+                {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping;
+};
@@ -0,0 +1,239 @@
+#include "trace_file.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char TRACE_MAGIC[8] = {'U', 'S', 'B', 'T', 'R', 'A', 'C', 'E'};
+
+uint64_t RecordSize(uint64_t length)
+{
+    return sizeof(TraceRecordHeader) + ((length + 7) & ~static_cast<uint64_t>(7));
+}
+
+} // namespace
+
+TraceWriter::TraceWriter()
+    : capacity(0)
+{
+}
+
+TraceWriter::~TraceWriter()
+{
+    Close();
+}
+
+bool TraceWriter::Open(const std::string &path, size_t requested, std::string &error)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // 数据区按 8 字节对齐, 至少能放下几条最大的记录
+    capacity = std::max<uint64_t>(requested, MIN_CAPACITY) & ~static_cast<uint64_t>(7);
+    if (!file.OpenWrite(path, sizeof(TraceFileHeader) + capacity, error))
+    {
+        return false;
+    }
+
+    start = std::chrono::steady_clock::now();
+    TraceFileHeader *header = Header();
+    memset(header, 0, sizeof(TraceFileHeader));
+    memcpy(header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header->version = VERSION;
+    header->headerSize = sizeof(TraceFileHeader);
+    header->capacity = capacity;
+    header->startTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count();
+    return true;
+}
+
+void TraceWriter::Close()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file.IsOpen())
+    {
+        file.Flush();
+        file.Close();
+    }
+}
+
+uint64_t TraceWriter::Records()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return file.IsOpen() ? Header()->records : 0;
+}
+
+int64_t TraceWriter::Now() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void TraceWriter::Append(TraceDirection direction, const uint8_t *data, size_t length, int64_t timeUs)
+{
+    if (timeUs < 0)
+    {
+        timeUs = Now();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file.IsOpen())
+    {
+        return;
+    }
+
+    do
+    {
+        size_t part = std::min(length, MAX_RECORD_DATA);
+        AppendRecord(direction, timeUs, data, part);
+        data += part;
+        length -= part;
+    } while (length > 0);
+}
+
+void TraceWriter::AppendRecord(TraceDirection direction, int64_t timeUs, const uint8_t *data, size_t length)
+{
+    TraceFileHeader *header = Header();
+    uint64_t size = RecordSize(length);
+
+    // 放不下时在末尾写一个填充记录, 从数据区开头继续
+    uint64_t offset = header->head % capacity;
+    if (capacity - offset < size)
+    {
+        uint64_t skip = capacity - offset;
+        Reserve(skip);
+        if (skip >= sizeof(TraceRecordHeader))
+        {
+            TraceRecordHeader wrap = {};
+            wrap.direction = TraceDirection::WRAP;
+            memcpy(Ring() + offset, &wrap, sizeof(wrap));
+        }
+        header->head += skip;
+        offset = 0;
+    }
+
+    Reserve(size);
+    TraceRecordHeader record = {};
+    record.length = static_cast<uint32_t>(length);
+    record.direction = direction;
+    record.timeUs = timeUs;
+    memcpy(Ring() + offset, &record, sizeof(record));
+    if (length > 0)
+    {
+        memcpy(Ring() + offset + sizeof(record), data, length);
+    }
+
+    // 数据写完后才推进 head, 中途崩溃时最后一条不完整的记录不可见
+    header->head += size;
+    header->records++;
+}
+
+void TraceWriter::Reserve(uint64_t bytes)
+{
+    // 覆盖最旧的记录, 直到空出 bytes 字节
+    TraceFileHeader *header = Header();
+    while (header->head + bytes - header->tail > capacity)
+    {
+        uint64_t offset = header->tail % capacity;
+        uint64_t remaining = capacity - offset;
+        if (remaining < sizeof(TraceRecordHeader))
+        {
+            header->tail += remaining;
+            continue;
+        }
+
+        TraceRecordHeader record;
+        memcpy(&record, Ring() + offset, sizeof(record));
+        if (record.direction == TraceDirection::WRAP)
+        {
+            header->tail += remaining;
+            continue;
+        }
+        header->tail += RecordSize(record.length);
+        header->records--;
+    }
+}
+
+TraceReader::TraceReader()
+    : ring(nullptr),
+      capacity(0),
+      head(0),
+      tail(0),
+      position(0),
+      startTimeUs(0)
+{
+}
+
+bool TraceReader::Open(const std::string &path, std::string &error)
+{
+    if (!file.OpenRead(path, error))
+    {
+        return false;
+    }
+
+    TraceFileHeader header;
+    if (file.Size() < sizeof(header))
+    {
+        error = "Not a trace file: " + path;
+        return false;
+    }
+    memcpy(&header, file.Data(), sizeof(header));
+    if (memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || header.version != TraceWriter::VERSION ||
+        header.headerSize != sizeof(TraceFileHeader) || file.Size() < header.headerSize + header.capacity ||
+        header.capacity == 0 || header.head < header.tail || header.head - header.tail > header.capacity)
+    {
+        error = "Not a trace file or unsupported version: " + path;
+        return false;
+    }
+
+    ring = file.Data() + header.headerSize;
+    capacity = header.capacity;
+    head = header.head;
+    tail = header.tail;
+    position = tail;
+    startTimeUs = header.startTimeUs;
+    file.AdviseSequential();
+    return true;
+}
+
+bool TraceReader::Next(TraceRecord &record)
+{
+    while (position < head)
+    {
+        uint64_t offset = position % capacity;
+        uint64_t remaining = capacity - offset;
+        if (remaining < sizeof(TraceRecordHeader))
+        {
+            position += remaining;
+            continue;
+        }
+
+        TraceRecordHeader header;
+        memcpy(&header, ring + offset, sizeof(header));
+        if (header.direction == TraceDirection::WRAP)
+        {
+            position += remaining;
+            continue;
+        }
+
+        // 损坏的记录: 停止读取
+        uint64_t size = RecordSize(header.length);
+        if (size > remaining || position + size > head)
+        {
+            position = head;
+            return false;
+        }
+
+        record.direction = header.direction;
+        record.timeUs = header.timeUs;
+        record.data = ring + offset + sizeof(header);
+        record.length = header.length;
+        position += size;
+        return true;
+    }
+    return false;
+}
+
+void TraceReader::Rewind()
+{
+    position = tail;
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "mapped_file.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// 设备通信跟踪文件
+// 文件 = 64 字节文件头 + 固定大小的环形数据区. 每条记录为 16 字节记录头 + 数据 (按 8 字节对齐),
+// 记录不会跨越数据区末尾; 写满后覆盖最旧的记录. 文件通过内存映射写入, 记录一条只是一次内存复制.
+enum class TraceDirection : uint8_t {
+    OUT = 0,     // 主机写到设备
+    IN = 1,      // 从设备读到
+    OPEN = 2,    // 打开设备, 数据为设备路径
+    CLOSE = 3,   // 关闭设备
+    WRAP = 0xFF  // 数据区末尾的填充, 读取时跳到数据区开头
+};
+
+struct TraceFileHeader {
+    char magic[8];          // "USBTRACE"
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t capacity;      // 数据区字节数
+    uint64_t head;          // 已写入的总字节数 (单调增加, 对 capacity 取模得到偏移)
+    uint64_t tail;          // 最旧一条记录的位置
+    uint64_t records;       // 当前保存的记录数
+    int64_t startTimeUs;    // 开始记录时的墙上时钟 (微秒)
+    uint64_t reserved;
+};
+
+struct TraceRecordHeader {
+    uint32_t length;        // 数据字节数
+    TraceDirection direction;
+    uint8_t reserved[3];
+    int64_t timeUs;         // 相对开始记录时刻的单调时钟 (微秒)
+};
+
+// 读出的一条记录, data 指向映射内存, 在 TraceReader 关闭前有效
+struct TraceRecord {
+    TraceDirection direction;
+    int64_t timeUs;
+    const uint8_t *data;
+    size_t length;
+};
+
+class TraceWriter {
+public:
+    static constexpr uint32_t VERSION = 1;
+    // 单条记录的最大数据长度, 更大的写入拆成多条
+    static constexpr size_t MAX_RECORD_DATA = 64 * 1024;
+    static constexpr size_t MIN_CAPACITY = 4 * MAX_RECORD_DATA;
+
+    TraceWriter();
+    ~TraceWriter();
+
+    // 创建 (或覆盖) 跟踪文件, capacity 为环形数据区的字节数
+    bool Open(const std::string &path, size_t capacity, std::string &error);
+    void Close();
+
+    // 线程安全; timeUs 为 Now() 的返回值, 小于 0 时取当前时间
+    void Append(TraceDirection direction, const uint8_t *data, size_t length, int64_t timeUs = -1);
+
+    // 相对开始记录时刻的微秒数
+    int64_t Now() const;
+
+    uint64_t Records();
+
+private:
+    void AppendRecord(TraceDirection direction, int64_t timeUs, const uint8_t *data, size_t length);
+    void Reserve(uint64_t bytes);
+    TraceFileHeader *Header() const { return reinterpret_cast<TraceFileHeader *>(file.Data()); }
+    uint8_t *Ring() const { return file.Data() + sizeof(TraceFileHeader); }
+
+    std::mutex mutex;
+    MappedFile file;
+    uint64_t capacity;
+    std::chrono::steady_clock::time_point start;
+};
+
+class TraceReader {
+public:
+    TraceReader();
+
+    bool Open(const std::string &path, std::string &error);
+
+    // 按写入顺序读取下一条记录, 没有更多记录时返回 false
+    bool Next(TraceRecord &record);
+
+    // 回到最旧的一条记录
+    void Rewind();
+
+    int64_t StartTimeUs() const { return startTimeUs; }
+
+private:
+    MappedFile file;
+    const uint8_t *ring;
+    uint64_t capacity;
+    uint64_t head;
+    uint64_t tail;
+    uint64_t position;
+    int64_t startTimeUs;
+};
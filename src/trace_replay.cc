@@ -0,0 +1,92 @@
+#include "trace_replay.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+// 回放期间读线程单次等待的时间 (也决定结束时的响应速度)
+const int READ_WAIT_MS = 20;
+const size_t READ_SIZE = 4096;
+
+} // namespace
+
+bool ReplayTrace(TraceReader &reader, Transport &transport, const TraceReplayOptions &options,
+                 TraceReplayResult &result, std::string &error)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    result = TraceReplayResult();
+    std::atomic<bool> reading(true);
+    std::atomic<uint64_t> bytesIn(0);
+    std::thread readerThread([&] {
+        uint8_t buffer[READ_SIZE];
+        while (reading)
+        {
+            size_t bytesRead = 0;
+            IoStatus status = transport.Read(buffer, sizeof(buffer), bytesRead, READ_WAIT_MS);
+            bytesIn += bytesRead;
+            if (status == IoStatus::CLOSED || status == IoStatus::ERR)
+            {
+                break;
+            }
+        }
+    });
+
+    bool ok = true;
+    bool first = true;
+    int64_t firstTimeUs = 0;
+    int64_t lastTimeUs = 0;
+    Clock::time_point start = Clock::now();
+
+    reader.Rewind();
+    TraceRecord record;
+    while (reader.Next(record))
+    {
+        if (record.direction == TraceDirection::IN)
+        {
+            result.recordedBytesIn += record.length;
+            continue;
+        }
+        if (record.direction != TraceDirection::OUT)
+        {
+            continue;
+        }
+
+        if (first)
+        {
+            firstTimeUs = record.timeUs;
+            first = false;
+        }
+        lastTimeUs = record.timeUs;
+
+        if (options.speed > 0)
+        {
+            auto offset = std::chrono::microseconds(static_cast<int64_t>((record.timeUs - firstTimeUs) / options.speed));
+            std::this_thread::sleep_until(start + offset);
+        }
+
+        size_t bytesWritten = 0;
+        IoStatus status = transport.Write(record.data, record.length, bytesWritten, WRITE_STALL_TIMEOUT);
+        result.bytesOut += bytesWritten;
+        if (status != IoStatus::OK)
+        {
+            error = "Failed to write data: " + std::to_string(transport.LastError());
+            ok = false;
+            break;
+        }
+        result.writes++;
+    }
+
+    result.durationMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    if (ok && options.drainMs > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.drainMs));
+    }
+    reading = false;
+    readerThread.join();
+
+    result.bytesIn = bytesIn.load();
+    result.originalDurationMs = static_cast<double>(lastTimeUs - firstTimeUs) / 1000.0;
+    return ok;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "trace_file.h"
+#include "transport.h"
+#include <cstdint>
+#include <string>
+
+struct TraceReplayOptions {
+    double speed = 1.0;   // 1 为原速, 2 为两倍速; 0 表示不等待, 尽快写出
+    int drainMs = 200;    // 最后一次写入后继续接收设备应答的时间
+};
+
+struct TraceReplayResult {
+    uint64_t writes = 0;
+    uint64_t bytesOut = 0;
+    uint64_t bytesIn = 0;            // 回放期间从设备读到的字节数
+    uint64_t recordedBytesIn = 0;    // 跟踪文件中记录的读取字节数, 用于对比
+    double durationMs = 0;           // 写出全部数据所用的时间 (不含 drainMs)
+    double originalDurationMs = 0;   // 跟踪文件中第一次到最后一次写入的时间
+};
+
+// 把跟踪文件中的写入 (OUT 记录) 按原来的时间间隔 (除以 speed) 重新写到 transport,
+// 同时在另一个线程上持续读取设备的应答. transport 必须已经打开.
+bool ReplayTrace(TraceReader &reader, Transport &transport, const TraceReplayOptions &options,
+                 TraceReplayResult &result, std::string &error);
@@ -0,0 +1,191 @@
+#include "trace_tools.h"
+#include "trace_file.h"
+#include "trace_replay.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char *DirectionName(TraceDirection direction)
+{
+    switch (direction)
+    {
+    case TraceDirection::OUT:
+        return "out";
+    case TraceDirection::IN:
+        return "in";
+    case TraceDirection::OPEN:
+        return "open";
+    case TraceDirection::CLOSE:
+        return "close";
+    case TraceDirection::WRAP:
+        break;
+    }
+    return "unknown";
+}
+
+// readTrace(path): 读出全部记录, time 为相对开始记录时刻的毫秒数, startTime 为开始记录时的时间戳 (毫秒)
+Napi::Value ReadTrace(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        Napi::TypeError::New(env, "Expected trace file path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    TraceReader reader;
+    std::string error;
+    if (!reader.Open(info[0].As<Napi::String>().Utf8Value(), error))
+    {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // 读写来自不同线程, 文件中的顺序与时间顺序可能略有出入, 按时间排序后返回
+    std::vector<TraceRecord> sorted;
+    TraceRecord record;
+    while (reader.Next(record))
+    {
+        sorted.push_back(record);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const TraceRecord &a, const TraceRecord &b) {
+        return a.timeUs < b.timeUs;
+    });
+
+    Napi::Array records = Napi::Array::New(env, sorted.size());
+    uint32_t count = 0;
+    for (const TraceRecord &record : sorted)
+    {
+        Napi::Object item = Napi::Object::New(env);
+        item.Set("time", Napi::Number::New(env, static_cast<double>(record.timeUs) / 1000.0));
+        item.Set("direction", Napi::String::New(env, DirectionName(record.direction)));
+        item.Set("data", Napi::Buffer<uint8_t>::Copy(env, record.data, record.length));
+        records.Set(count++, item);
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("startTime", Napi::Number::New(env, static_cast<double>(reader.StartTimeUs()) / 1000.0));
+    result.Set("records", records);
+    return result;
+}
+
+// 回放在 libuv 线程池中执行, 期间按原来的时间间隔等待, 不阻塞 JS 线程
+class ReplayWorker : public Napi::AsyncWorker
+{
+public:
+    ReplayWorker(Napi::Env env, const std::string &tracePath, const std::string &devicePath,
+                 const TraceReplayOptions &options)
+        : Napi::AsyncWorker(env, "TraceReplay"),
+          deferred(Napi::Promise::Deferred::New(env)),
+          tracePath(tracePath),
+          devicePath(devicePath),
+          options(options)
+    {
+    }
+
+    Napi::Promise Promise() const
+    {
+        return deferred.Promise();
+    }
+
+protected:
+    void Execute() override
+    {
+        TraceReader reader;
+        std::string error;
+        if (!reader.Open(tracePath, error))
+        {
+            SetError(error);
+            return;
+        }
+
+        std::unique_ptr<Transport> transport = CreateTransport();
+        if (!transport->Open(devicePath))
+        {
+            SetError("Failed to open device " + devicePath + ": " + std::to_string(transport->LastError()));
+            return;
+        }
+
+        bool ok = ReplayTrace(reader, *transport, options, result, error);
+        transport->Close();
+        if (!ok)
+        {
+            SetError(error);
+        }
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = Env();
+        Napi::Object value = Napi::Object::New(env);
+        value.Set("writes", Napi::Number::New(env, static_cast<double>(result.writes)));
+        value.Set("bytesOut", Napi::Number::New(env, static_cast<double>(result.bytesOut)));
+        value.Set("bytesIn", Napi::Number::New(env, static_cast<double>(result.bytesIn)));
+        value.Set("recordedBytesIn", Napi::Number::New(env, static_cast<double>(result.recordedBytesIn)));
+        value.Set("durationMs", Napi::Number::New(env, result.durationMs));
+        value.Set("originalDurationMs", Napi::Number::New(env, result.originalDurationMs));
+        deferred.Resolve(value);
+    }
+
+    void OnError(const Napi::Error &error) override
+    {
+        deferred.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    std::string tracePath;
+    std::string devicePath;
+    TraceReplayOptions options;
+    TraceReplayResult result;
+};
+
+Napi::Value ReplayTraceFunction(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString())
+    {
+        Napi::TypeError::New(env, "Expected trace file path and device path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // 可选参数: { speed, drain }
+    TraceReplayOptions options;
+    if (info.Length() >= 3 && info[2].IsObject())
+    {
+        Napi::Object object = info[2].As<Napi::Object>();
+        if (object.Has("speed"))
+        {
+            options.speed = object.Get("speed").ToNumber().DoubleValue();
+        }
+        if (object.Has("drain"))
+        {
+            options.drainMs = object.Get("drain").ToNumber().Int32Value();
+        }
+    }
+    if (options.speed < 0)
+    {
+        Napi::RangeError::New(env, "speed must not be negative").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    auto worker = new ReplayWorker(env, info[0].As<Napi::String>().Utf8Value(),
+                                   info[1].As<Napi::String>().Utf8Value(), options);
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();
+    return promise;
+}
+
+} // namespace
+
+Napi::Object InitTraceTools(Napi::Env env, Napi::Object exports)
+{
+    exports.Set("readTrace", Napi::Function::New(env, ReadTrace, "readTrace"));
+    exports.Set("replayTrace", Napi::Function::New(env, ReplayTraceFunction, "replayTrace"));
+    return exports;
+}
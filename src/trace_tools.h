@@ -0,0 +1,7 @@
+#pragma once
+#include <napi.h>
+
+// 跟踪文件工具函数, 作为模块级函数导出:
+//   readTrace(path) -> { startTime, records: [{ time, direction, data }] }
+//   replayTrace(tracePath, devicePath, { speed, drain }) -> Promise<{ writes, bytesOut, bytesIn, ... }>
+Napi::Object InitTraceTools(Napi::Env env, Napi::Object exports);
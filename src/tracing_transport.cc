@@ -0,0 +1,121 @@
+#include "tracing_transport.h"
+#include <algorithm>
+
+TracingTransport::TracingTransport(std::unique_ptr<Transport> inner)
+    : inner(std::move(inner)),
+      capturing(false),
+      retriesOffset(0)
+{
+}
+
+void TracingTransport::StartCapture(std::shared_ptr<TraceWriter> newWriter)
+{
+    std::lock_guard<std::mutex> lock(writerMutex);
+    writer = std::move(newWriter);
+    capturing = static_cast<bool>(writer);
+}
+
+std::shared_ptr<TraceWriter> TracingTransport::StopCapture()
+{
+    std::lock_guard<std::mutex> lock(writerMutex);
+    capturing = false;
+    std::shared_ptr<TraceWriter> previous;
+    previous.swap(writer);
+    return previous;
+}
+
+void TracingTransport::Record(TraceDirection direction, const uint8_t *data, size_t length,
+                              std::chrono::steady_clock::time_point when)
+{
+    if (!capturing.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    std::shared_ptr<TraceWriter> current;
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        current = writer;
+    }
+    if (current)
+    {
+        int64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - when)
+                                .count();
+        current->Append(direction, data, length, std::max<int64_t>(0, current->Now() - elapsedUs));
+    }
+}
+
+bool TracingTransport::Open(const std::string &path)
+{
+    bool opened = inner->Open(path);
+    if (opened)
+    {
+        Record(TraceDirection::OPEN, reinterpret_cast<const uint8_t *>(path.data()), path.size(),
+               std::chrono::steady_clock::now());
+    }
+    return opened;
+}
+
+void TracingTransport::Close()
+{
+    if (inner->IsOpen())
+    {
+        Record(TraceDirection::CLOSE, nullptr, 0, std::chrono::steady_clock::now());
+    }
+    inner->Close();
+}
+
+bool TracingTransport::IsOpen() const
+{
+    return inner->IsOpen();
+}
+
+IoStatus TracingTransport::Write(const uint8_t *data, size_t length, size_t &bytesWritten, int timeoutMs)
+{
+    auto started = std::chrono::steady_clock::now();
+    IoStatus status = inner->Write(data, length, bytesWritten, timeoutMs);
+    if (bytesWritten > 0)
+    {
+        Record(TraceDirection::OUT, data, bytesWritten, started);
+    }
+    return status;
+}
+
+IoStatus TracingTransport::Read(uint8_t *buffer, size_t capacity, size_t &bytesRead, int timeoutMs)
+{
+    IoStatus status = inner->Read(buffer, capacity, bytesRead, timeoutMs);
+    if (bytesRead > 0)
+    {
+        Record(TraceDirection::IN, buffer, bytesRead, std::chrono::steady_clock::now());
+    }
+    return status;
+}
+
+std::unique_ptr<Transport> TracingTransport::SwapInner(std::unique_ptr<Transport> replacement)
+{
+    // 替换后 offset + 新计数 == 替换前 offset + 旧计数
+    retriesOffset += inner->WriteRetries() - replacement->WriteRetries();
+    inner.swap(replacement);
+    return replacement;
+}
+
+void TracingTransport::SetOpenAttributes(uint32_t attributes)
+{
+    inner->SetOpenAttributes(attributes);
+}
+
+void TracingTransport::CancelPending()
+{
+    inner->CancelPending();
+}
+
+int TracingTransport::LastError() const
+{
+    return inner->LastError();
+}
+
+uint64_t TracingTransport::WriteRetries() const
+{
+    return retriesOffset.load(std::memory_order_relaxed) + inner->WriteRetries();
+}
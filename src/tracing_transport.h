@@ -0,0 +1,45 @@
+#pragma once
+#include "trace_file.h"
+#include "transport.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+// 传输层装饰器: 把每次成功的写入和读取 (时间、方向、数据) 记录到跟踪文件.
+// 没有在记录时只多一次原子读; 记录时数据复制到内存映射的环形文件, 不做系统调用.
+class TracingTransport : public Transport {
+public:
+    explicit TracingTransport(std::unique_ptr<Transport> inner);
+
+    // 开始/停止记录; 可以在 I/O 进行中调用
+    void StartCapture(std::shared_ptr<TraceWriter> writer);
+    std::shared_ptr<TraceWriter> StopCapture();
+    bool IsCapturing() const { return capturing.load(std::memory_order_relaxed); }
+
+    // 换下被装饰的传输层 (例如把打开的设备移交给另一个 worker), 返回原来的; 调用方保证此时没有 I/O 在进行.
+    // WriteRetries 在替换前后保持连续, 不会因为新传输层的计数不同而跳变
+    std::unique_ptr<Transport> SwapInner(std::unique_ptr<Transport> replacement);
+
+    bool Open(const std::string &path) override;
+    void SetOpenAttributes(uint32_t attributes) override;
+    void Close() override;
+    bool IsOpen() const override;
+    IoStatus Write(const uint8_t *data, size_t length, size_t &bytesWritten, int timeoutMs) override;
+    IoStatus Read(uint8_t *buffer, size_t capacity, size_t &bytesRead, int timeoutMs) override;
+    void CancelPending() override;
+    int LastError() const override;
+    uint64_t WriteRetries() const override;
+
+private:
+    // 记录中的写入时间取写入开始的时刻, 回放时按这个时间重新写出
+    void Record(TraceDirection direction, const uint8_t *data, size_t length,
+                std::chrono::steady_clock::time_point when);
+
+    std::unique_ptr<Transport> inner;
+    std::atomic<bool> capturing;
+    // 加到 inner->WriteRetries() 上的偏移 (按 2^64 取模), 换下的传输层的计数折算在这里
+    std::atomic<uint64_t> retriesOffset;
+    std::mutex writerMutex;
+    std::shared_ptr<TraceWriter> writer;
+};
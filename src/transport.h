@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// 传输层 I/O 结果 (与平台无关)
+enum class IoStatus {
+    OK,         // 成功传输了数据
+    TIMEOUT,    // 在超时时间内没有数据/无法写入
+    CLOSED,     // 对端已关闭 (设备被拔出等)
+    ERR         // 其他错误, 详见 LastError()
+};
+
+// 写操作允许"没有任何进展"的默认最长时间 (毫秒)
+const int WRITE_STALL_TIMEOUT = 5000;
+
+// 设备传输层接口
+// UsbDevice 只通过这个接口访问设备, 每个平台提供一个实现:
+//   Windows: WinTransport   (CreateFileA / WriteFile / ReadFile)
+//   Linux:   PosixTransport (/dev/usb/lp*, pty, socketpair, 非阻塞 + poll)
+class Transport {
+public:
+    Transport()
+        : writeRetries(0)
+    {
+    }
+    virtual ~Transport() = default;
+
+    // 打开设备路径, 已打开时先关闭
+    virtual bool Open(const std::string &path) = 0;
+
+    // 下次 Open 使用的平台相关属性 (Windows: CreateFile 的文件属性, 0 为 FILE_ATTRIBUTE_NORMAL); 默认忽略
+    virtual void SetOpenAttributes(uint32_t attributes)
+    {
+        (void)attributes;
+    }
+    virtual void Close() = 0;
+    virtual bool IsOpen() const = 0;
+
+    // 写入全部数据; timeoutMs 是允许"没有任何进展"的最长时间, <0 表示无限等待
+    virtual IoStatus Write(const uint8_t *data, size_t length, size_t &bytesWritten, int timeoutMs) = 0;
+
+    // 最多等待 timeoutMs 直到有数据可读, 然后读取当前可用的数据 (不保证填满 buffer)
+    virtual IoStatus Read(uint8_t *buffer, size_t capacity, size_t &bytesRead, int timeoutMs) = 0;
+
+    // 取消挂起的 I/O, 并丢弃设备上残留的未读数据
+    virtual void CancelPending() = 0;
+
+    // 最近一次失败的系统错误码 (GetLastError / errno)
+    virtual int LastError() const = 0;
+
+    // 写入时因设备缓冲区已满而等待后重试的累计次数
+    virtual uint64_t WriteRetries() const { return writeRetries.load(std::memory_order_relaxed); }
+
+protected:
+    std::atomic<uint64_t> writeRetries;
+};
+
+// 创建当前平台的默认传输层实现
+std::unique_ptr<Transport> CreateTransport();
@@ -0,0 +1,278 @@
+#include "transport_posix.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// 截止时间: timeoutMs < 0 表示无限等待
+Clock::time_point Deadline(int timeoutMs)
+{
+    return timeoutMs < 0 ? Clock::time_point::max() : Clock::now() + std::chrono::milliseconds(timeoutMs);
+}
+
+// 距离截止时间的毫秒数, 向上取整
+int RemainingMs(Clock::time_point deadline)
+{
+    if (deadline == Clock::time_point::max())
+    {
+        return -1;
+    }
+    auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - Clock::now()).count();
+    return remaining <= 0 ? 0 : static_cast<int>((remaining + 999) / 1000);
+}
+
+} // namespace
+
+PosixTransport::PosixTransport()
+    : fd(-1), lastError(0), charDevice(false)
+{
+}
+
+PosixTransport::~PosixTransport()
+{
+    Close();
+}
+
+bool PosixTransport::Open(const std::string &path)
+{
+    Close();
+
+    int newFd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+    if (newFd < 0)
+    {
+        lastError = errno;
+        return false;
+    }
+
+    // pty 之类的终端设备需要切换到原始模式, 否则 ';' 等字符会被行规程处理/回显
+    if (isatty(newFd))
+    {
+        struct termios tio;
+        if (tcgetattr(newFd, &tio) == 0)
+        {
+            cfmakeraw(&tio);
+            tcsetattr(newFd, TCSANOW, &tio);
+        }
+    }
+
+    fd = newFd;
+    lastError = 0;
+    DetectKind();
+    return true;
+}
+
+bool PosixTransport::Adopt(int newFd)
+{
+    Close();
+
+    int flags = fcntl(newFd, F_GETFL, 0);
+    if (flags < 0 || fcntl(newFd, F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        lastError = errno;
+        return false;
+    }
+
+    fd = newFd;
+    lastError = 0;
+    DetectKind();
+    return true;
+}
+
+void PosixTransport::DetectKind()
+{
+    struct stat info;
+    charDevice = fstat(fd, &info) == 0 && S_ISCHR(info.st_mode);
+}
+
+void PosixTransport::Close()
+{
+    if (fd >= 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+}
+
+bool PosixTransport::IsOpen() const
+{
+    return fd >= 0;
+}
+
+bool PosixTransport::WaitFor(short events, int timeoutMs)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = events;
+    pfd.revents = 0;
+
+    int rc;
+    do
+    {
+        rc = poll(&pfd, 1, timeoutMs);
+    } while (rc < 0 && errno == EINTR);
+
+    if (rc < 0)
+    {
+        lastError = errno;
+        return false;
+    }
+    // POLLHUP/POLLERR 也视为"就绪", 由随后的 read/write 报告具体错误
+    return rc > 0;
+}
+
+// 设备是否已挂断 (拔出)
+bool PosixTransport::HungUp()
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = 0;
+    pfd.revents = 0;
+    return poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLHUP | POLLNVAL)) != 0;
+}
+
+IoStatus PosixTransport::Write(const uint8_t *data, size_t length, size_t &bytesWritten, int timeoutMs)
+{
+    bytesWritten = 0;
+    if (fd < 0)
+    {
+        lastError = EBADF;
+        return IoStatus::ERR;
+    }
+
+    while (bytesWritten < length)
+    {
+        ssize_t n = write(fd, data + bytesWritten, length - bytesWritten);
+        if (n > 0)
+        {
+            bytesWritten += static_cast<size_t>(n);
+            continue;
+        }
+
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            lastError = errno;
+            return (errno == EPIPE || errno == ENODEV || errno == EIO) ? IoStatus::CLOSED : IoStatus::ERR;
+        }
+
+        // 设备缓冲区已满, 等待可写
+        writeRetries.fetch_add(1, std::memory_order_relaxed);
+        if (!WaitFor(POLLOUT, timeoutMs))
+        {
+            return IoStatus::TIMEOUT;
+        }
+    }
+
+    return IoStatus::OK;
+}
+
+IoStatus PosixTransport::Read(uint8_t *buffer, size_t capacity, size_t &bytesRead, int timeoutMs)
+{
+    bytesRead = 0;
+    if (fd < 0)
+    {
+        lastError = EBADF;
+        return IoStatus::ERR;
+    }
+
+    Clock::time_point deadline = Deadline(timeoutMs);
+    int backoffMs = 1;
+    bool waited = false;
+
+    for (;;)
+    {
+        ssize_t n = read(fd, buffer, capacity);
+        if (n > 0)
+        {
+            bytesRead = static_cast<size_t>(n);
+            return IoStatus::OK;
+        }
+
+        if (n == 0)
+        {
+            // 管道、socket 的 0 表示对端已关闭
+            if (!charDevice)
+            {
+                return IoStatus::CLOSED;
+            }
+            // usblp 等字符设备: 0 是设备发来的零长度包, 不是 EOF; 拔出由 ENODEV/EIO 或 POLLHUP 报告
+            if (HungUp())
+            {
+                lastError = ENODEV;
+                return IoStatus::CLOSED;
+            }
+            // 驱动可能在没有数据时立即完成空读取, poll 也随即报告可读, 只能短暂退避后再读
+            int remaining = RemainingMs(deadline);
+            if (remaining == 0)
+            {
+                return IoStatus::TIMEOUT;
+            }
+            std::this_thread::sleep_for(
+                std::chrono::milliseconds(remaining < 0 ? backoffMs : std::min(backoffMs, remaining)));
+            backoffMs = std::min(backoffMs * 2, 8);
+            continue;
+        }
+
+        if (errno == EINTR)
+        {
+            continue;
+        }
+
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            lastError = errno;
+            // pty 的另一端关闭时 read 返回 EIO
+            return (errno == EIO || errno == ENODEV) ? IoStatus::CLOSED : IoStatus::ERR;
+        }
+
+        // 只等待一次: 就绪后的下一次 read 仍无数据时返回 TIMEOUT
+        if (!WaitFor(POLLIN, waited ? 0 : RemainingMs(deadline)))
+        {
+            return IoStatus::TIMEOUT;
+        }
+        waited = true;
+    }
+}
+
+void PosixTransport::CancelPending()
+{
+    if (fd < 0)
+    {
+        return;
+    }
+
+    if (isatty(fd))
+    {
+        tcflush(fd, TCIOFLUSH);
+        return;
+    }
+
+    // 非终端设备: 把残留的输入读空
+    uint8_t scratch[256];
+    while (read(fd, scratch, sizeof(scratch)) > 0)
+    {
+    }
+}
+
+int PosixTransport::LastError() const
+{
+    return lastError;
+}
+
+std::unique_ptr<Transport> CreateTransport()
+{
+    return std::unique_ptr<Transport>(new PosixTransport());
+}
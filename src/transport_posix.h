@@ -0,0 +1,35 @@
+#pragma once
+#include "transport.h"
+
+// Linux/POSIX 传输层实现
+// 以非阻塞方式打开 /dev/usb/lp* (或任意字符设备、pty), 用 poll 等待就绪,
+// 不再使用 sleep + 重试. 也可以通过 Adopt 接管一个已有的 fd (例如 socketpair),
+// 方便在没有硬件的情况下测试.
+class PosixTransport : public Transport {
+public:
+    PosixTransport();
+    ~PosixTransport() override;
+
+    bool Open(const std::string &path) override;
+    void Close() override;
+    bool IsOpen() const override;
+
+    IoStatus Write(const uint8_t *data, size_t length, size_t &bytesWritten, int timeoutMs) override;
+    IoStatus Read(uint8_t *buffer, size_t capacity, size_t &bytesRead, int timeoutMs) override;
+    void CancelPending() override;
+    int LastError() const override;
+
+    // 接管一个已打开的 fd (会被设置为非阻塞, Close 时关闭)
+    bool Adopt(int fd);
+    int Fd() const { return fd; }
+
+private:
+    bool WaitFor(short events, int timeoutMs);
+    bool HungUp();
+    void DetectKind();
+
+    int fd;
+    int lastError;
+    // 字符设备 (usblp、pty) 上 read 返回 0 是零长度包而不是 EOF
+    bool charDevice;
+};
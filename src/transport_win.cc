@@ -0,0 +1,295 @@
+#include "transport.h"
+#include <windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// 单次 ReadFile 的缓冲区大小
+const DWORD READ_CHUNK = 4096;
+
+// 截止时间: timeoutMs < 0 表示无限等待
+Clock::time_point Deadline(int timeoutMs)
+{
+    return timeoutMs < 0 ? Clock::time_point::max() : Clock::now() + std::chrono::milliseconds(timeoutMs);
+}
+
+// 距离截止时间的毫秒数, 向上取整, 供 WaitForSingleObject 使用
+DWORD RemainingMs(Clock::time_point deadline)
+{
+    if (deadline == Clock::time_point::max())
+    {
+        return INFINITE;
+    }
+    auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - Clock::now()).count();
+    if (remaining <= 0)
+    {
+        return 0;
+    }
+    return static_cast<DWORD>((remaining + 999) / 1000);
+}
+
+} // namespace
+
+// Windows 传输层实现
+// 以 FILE_FLAG_OVERLAPPED 打开设备, 读写都在事件上等待就绪并以单调时钟的截止时间计时,
+// 数据一到就返回, 不再 Sleep 后重试. 读请求超时后保持挂起, 下一次 Read 继续等待同一个请求, 不会丢数据.
+class WinTransport : public Transport {
+public:
+    WinTransport()
+        : handle(INVALID_HANDLE_VALUE),
+          lastError(0),
+          openAttributes(FILE_ATTRIBUTE_NORMAL),
+          readPending(false),
+          readOffset(0),
+          readLength(0)
+    {
+        memset(&readOverlapped, 0, sizeof(readOverlapped));
+        memset(&writeOverlapped, 0, sizeof(writeOverlapped));
+        // 手动复位事件: 读写各一个, 可以由不同线程同时使用
+        readOverlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+        writeOverlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+        readBuffer.resize(READ_CHUNK);
+    }
+
+    ~WinTransport() override
+    {
+        Close();
+        CloseHandle(readOverlapped.hEvent);
+        CloseHandle(writeOverlapped.hEvent);
+    }
+
+    void SetOpenAttributes(uint32_t attributes) override
+    {
+        openAttributes = attributes != 0 ? attributes : FILE_ATTRIBUTE_NORMAL;
+    }
+
+    bool Open(const std::string &path) override
+    {
+        Close();
+
+        handle = CreateFileA(path.c_str(),
+                             GENERIC_READ | GENERIC_WRITE,
+                             0,  // 不共享
+                             NULL,
+                             OPEN_EXISTING,
+                             openAttributes | FILE_FLAG_OVERLAPPED,      // 由设备型号配置决定, 海沃佳的只能是Normal
+                             NULL);
+
+        if (handle == INVALID_HANDLE_VALUE)
+        {
+            lastError = static_cast<int>(GetLastError());
+            return false;
+        }
+
+        lastError = 0;
+        readPending = false;
+        readOffset = 0;
+        readLength = 0;
+        return true;
+    }
+
+    void Close() override
+    {
+        if (handle != INVALID_HANDLE_VALUE)
+        {
+            CancelAndWait();
+            CloseHandle(handle);
+            handle = INVALID_HANDLE_VALUE;
+        }
+    }
+
+    bool IsOpen() const override
+    {
+        return handle != INVALID_HANDLE_VALUE;
+    }
+
+    IoStatus Write(const uint8_t *data, size_t length, size_t &bytesWritten, int timeoutMs) override
+    {
+        bytesWritten = 0;
+
+        while (bytesWritten < length)
+        {
+            // timeoutMs 是"没有任何进展"的最长时间, 每次写出一部分数据后重新计时
+            Clock::time_point deadline = Deadline(timeoutMs);
+            DWORD toWrite = static_cast<DWORD>(std::min<size_t>(length - bytesWritten, MAXDWORD));
+
+            ResetEvent(writeOverlapped.hEvent);
+            DWORD written = 0;
+            if (!WriteFile(handle, data + bytesWritten, toWrite, &written, &writeOverlapped))
+            {
+                DWORD error = GetLastError();
+                if (error != ERROR_IO_PENDING)
+                {
+                    return Fail(error);
+                }
+
+                DWORD wait = WaitForSingleObject(writeOverlapped.hEvent, RemainingMs(deadline));
+                if (wait != WAIT_OBJECT_0)
+                {
+                    // 超时: 取消这次写入并取得已经写出的字节数
+                    CancelIoEx(handle, &writeOverlapped);
+                    GetOverlappedResult(handle, &writeOverlapped, &written, TRUE);
+                    bytesWritten += written;
+                    if (written == 0)
+                    {
+                        writeRetries.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    return IoStatus::TIMEOUT;
+                }
+
+                if (!GetOverlappedResult(handle, &writeOverlapped, &written, FALSE))
+                {
+                    return Fail(GetLastError());
+                }
+            }
+
+            if (written == 0)
+            {
+                writeRetries.fetch_add(1, std::memory_order_relaxed);
+            }
+            bytesWritten += written;
+        }
+        return IoStatus::OK;
+    }
+
+    IoStatus Read(uint8_t *buffer, size_t capacity, size_t &bytesRead, int timeoutMs) override
+    {
+        bytesRead = 0;
+        Clock::time_point deadline = Deadline(timeoutMs);
+        DWORD backoffMs = 1;
+
+        for (;;)
+        {
+            // 上一次读到但没有取走的数据
+            if (readOffset < readLength)
+            {
+                bytesRead = std::min<size_t>(capacity, readLength - readOffset);
+                memcpy(buffer, readBuffer.data() + readOffset, bytesRead);
+                readOffset += bytesRead;
+                return IoStatus::OK;
+            }
+
+            DWORD got = 0;
+            if (!readPending)
+            {
+                ResetEvent(readOverlapped.hEvent);
+                if (ReadFile(handle, readBuffer.data(), READ_CHUNK, &got, &readOverlapped))
+                {
+                    readOffset = 0;
+                    readLength = got;
+                }
+                else
+                {
+                    DWORD error = GetLastError();
+                    if (error == ERROR_IO_PENDING)
+                    {
+                        readPending = true;
+                    }
+                    else if (error != ERROR_NO_DATA)
+                    {
+                        return Fail(error);
+                    }
+                }
+            }
+
+            if (readPending)
+            {
+                DWORD wait = WaitForSingleObject(readOverlapped.hEvent, RemainingMs(deadline));
+                if (wait != WAIT_OBJECT_0)
+                {
+                    // 请求保持挂起, 下一次 Read 继续等待
+                    return IoStatus::TIMEOUT;
+                }
+
+                readPending = false;
+                if (!GetOverlappedResult(handle, &readOverlapped, &got, FALSE))
+                {
+                    DWORD error = GetLastError();
+                    if (error != ERROR_OPERATION_ABORTED && error != ERROR_NO_DATA)
+                    {
+                        return Fail(error);
+                    }
+                    got = 0;
+                }
+                readOffset = 0;
+                readLength = got;
+            }
+
+            if (readLength > 0)
+            {
+                backoffMs = 1;
+                continue;
+            }
+
+            // 打印机类驱动在没有数据时会立即完成一个空读取, 只能短暂退避后再读;
+            // 退避从 1 毫秒开始并受截止时间约束
+            DWORD remaining = RemainingMs(deadline);
+            if (remaining == 0)
+            {
+                return IoStatus::TIMEOUT;
+            }
+            Sleep(std::min(backoffMs, remaining));
+            backoffMs = std::min<DWORD>(backoffMs * 2, 8);
+        }
+    }
+
+    void CancelPending() override
+    {
+        if (handle != INVALID_HANDLE_VALUE)
+        {
+            CancelAndWait();
+        }
+    }
+
+    int LastError() const override
+    {
+        return lastError;
+    }
+
+private:
+    static bool IsRemovalError(int error)
+    {
+        return error == ERROR_DEVICE_NOT_CONNECTED || error == ERROR_BAD_COMMAND || error == ERROR_GEN_FAILURE;
+    }
+
+    IoStatus Fail(DWORD error)
+    {
+        lastError = static_cast<int>(error);
+        return IsRemovalError(lastError) ? IoStatus::CLOSED : IoStatus::ERR;
+    }
+
+    // 取消挂起的读请求并等待它真正结束, 丢弃已读到但未取走的数据
+    void CancelAndWait()
+    {
+        CancelIoEx(handle, NULL);
+        if (readPending)
+        {
+            DWORD got = 0;
+            GetOverlappedResult(handle, &readOverlapped, &got, TRUE);
+            readPending = false;
+        }
+        readOffset = 0;
+        readLength = 0;
+    }
+
+    HANDLE handle;
+    int lastError;
+    DWORD openAttributes;
+
+    OVERLAPPED readOverlapped;
+    OVERLAPPED writeOverlapped;
+    bool readPending;
+    std::vector<uint8_t> readBuffer;
+    size_t readOffset;
+    size_t readLength;
+};
+
+std::unique_ptr<Transport> CreateTransport()
+{
+    return std::unique_ptr<Transport>(new WinTransport());
+}
@@ -0,0 +1,541 @@
+#include "uevent_monitor.h"
+#include "device_index.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <fstream>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// 接收缓冲区: USB Hub 上电时会在很短时间内产生大量事件
+const int RECEIVE_BUFFER_SIZE = 4 * 1024 * 1024;
+
+bool Equals(const char *text, size_t length, const char *literal)
+{
+    size_t literalLength = strlen(literal);
+    return length == literalLength && memcmp(text, literal, length) == 0;
+}
+
+bool StartsWith(const char *text, size_t length, const char *prefix)
+{
+    size_t prefixLength = strlen(prefix);
+    return length >= prefixLength && memcmp(text, prefix, prefixLength) == 0;
+}
+
+// 解析不定长的十六进制数, 遇到 end 或非十六进制字符停止; 返回下一个字符的位置
+const char *ParseHex(const char *p, const char *end, unsigned &value, bool &ok)
+{
+    value = 0;
+    ok = false;
+    for (; p < end; p++)
+    {
+        int d = HexDigitValue(*p);
+        if (d < 0)
+        {
+            break;
+        }
+        value = value * 16 + static_cast<unsigned>(d);
+        ok = value <= 0xFFFF;
+    }
+    return p;
+}
+
+UeventView::Action ParseAction(const char *text, size_t length)
+{
+    if (Equals(text, length, "add")) return UeventView::Action::ADD;
+    if (Equals(text, length, "remove")) return UeventView::Action::REMOVE;
+    if (Equals(text, length, "change")) return UeventView::Action::CHANGE;
+    if (Equals(text, length, "bind")) return UeventView::Action::BIND;
+    if (Equals(text, length, "unbind")) return UeventView::Action::UNBIND;
+    return UeventView::Action::OTHER;
+}
+
+} // namespace
+
+bool UeventMayBePrinter(const char *data, size_t length)
+{
+    const char *end = static_cast<const char *>(memchr(data, '\0', length));
+    if (!end)
+    {
+        end = data + length;
+    }
+
+    const char *at = static_cast<const char *>(memchr(data, '@', static_cast<size_t>(end - data)));
+    if (!at)
+    {
+        return false;
+    }
+
+    // lpN 节点: .../usbmisc/lpN
+    const char *lastSlash = at;
+    for (const char *p = at; p < end; p++)
+    {
+        if (*p == '/')
+        {
+            lastSlash = p;
+        }
+    }
+    static const char USBMISC[] = "/usbmisc/";
+    const size_t usbmiscLength = sizeof(USBMISC) - 1;
+    if (lastSlash - at >= static_cast<ptrdiff_t>(usbmiscLength) &&
+        memcmp(lastSlash - usbmiscLength + 1, USBMISC, usbmiscLength) == 0)
+    {
+        return true;
+    }
+
+    // USB 接口: 最后一段形如 1-1.2:1.0
+    return memchr(lastSlash, ':', static_cast<size_t>(end - lastSlash)) != nullptr;
+}
+
+bool ParseUevent(const char *data, size_t length, UeventView &view)
+{
+    view = UeventView();
+
+    const char *end = data + length;
+    const char *header = data;
+    const char *headerEnd = static_cast<const char *>(memchr(header, '\0', length));
+    if (!headerEnd || !memchr(header, '@', static_cast<size_t>(headerEnd - header)))
+    {
+        // libudev 转发的消息以 "libudev" 开头, 不处理
+        return false;
+    }
+
+    for (const char *p = headerEnd + 1; p < end;)
+    {
+        const char *fieldEnd = static_cast<const char *>(memchr(p, '\0', static_cast<size_t>(end - p)));
+        if (!fieldEnd)
+        {
+            fieldEnd = end;
+        }
+
+        const char *eq = static_cast<const char *>(memchr(p, '=', static_cast<size_t>(fieldEnd - p)));
+        if (eq)
+        {
+            size_t keyLength = static_cast<size_t>(eq - p);
+            const char *value = eq + 1;
+            size_t valueLength = static_cast<size_t>(fieldEnd - value);
+
+            if (Equals(p, keyLength, "ACTION"))
+            {
+                view.action = ParseAction(value, valueLength);
+            }
+            else if (Equals(p, keyLength, "DEVPATH"))
+            {
+                view.devpath = value;
+                view.devpathLength = valueLength;
+            }
+            else if (Equals(p, keyLength, "SUBSYSTEM"))
+            {
+                view.subsystem = value;
+                view.subsystemLength = valueLength;
+            }
+            else if (Equals(p, keyLength, "DEVTYPE"))
+            {
+                view.devtype = value;
+                view.devtypeLength = valueLength;
+            }
+            else if (Equals(p, keyLength, "DEVNAME"))
+            {
+                view.devname = value;
+                view.devnameLength = valueLength;
+            }
+            else if (Equals(p, keyLength, "PRODUCT"))
+            {
+                // 例如 "483/5740/200": 十六进制, 不补零
+                unsigned vid = 0;
+                unsigned pid = 0;
+                bool vidOk = false;
+                bool pidOk = false;
+                const char *q = ParseHex(value, fieldEnd, vid, vidOk);
+                if (vidOk && q < fieldEnd && *q == '/')
+                {
+                    ParseHex(q + 1, fieldEnd, pid, pidOk);
+                }
+                if (vidOk && pidOk)
+                {
+                    view.hasProduct = true;
+                    view.vendorId = static_cast<uint16_t>(vid);
+                    view.productId = static_cast<uint16_t>(pid);
+                }
+            }
+            else if (Equals(p, keyLength, "INTERFACE"))
+            {
+                int interfaceClass = 0;
+                const char *q = value;
+                for (; q < fieldEnd && *q >= '0' && *q <= '9'; q++)
+                {
+                    interfaceClass = interfaceClass * 10 + (*q - '0');
+                }
+                view.interfaceClass = q > value ? interfaceClass : -1;
+            }
+        }
+
+        p = fieldEnd + 1;
+    }
+
+    return view.devpath != nullptr && view.subsystem != nullptr;
+}
+
+UeventMonitor::UeventMonitor()
+    : fd(-1),
+      wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      fromKernel(false),
+      running(false),
+      nextRecent(0)
+{
+    memset(recent, 0, sizeof(recent));
+}
+
+UeventMonitor::~UeventMonitor()
+{
+    Stop();
+    Close();
+    if (wakeFd >= 0)
+    {
+        close(wakeFd);
+    }
+}
+
+void UeventMonitor::Close()
+{
+    if (replayThread.joinable())
+    {
+        replayThread.join();
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+}
+
+bool UeventMonitor::OpenNetlink(std::string &error)
+{
+    Close();
+
+    int sock = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+    if (sock < 0)
+    {
+        error = "Failed to create uevent socket: " + std::to_string(errno);
+        return false;
+    }
+
+    // SO_RCVBUFFORCE 需要 CAP_NET_ADMIN, 失败时退回到普通上限
+    int size = RECEIVE_BUFFER_SIZE;
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) < 0)
+    {
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1;  // 内核事件组 (不是 udev 转发的事件)
+    if (bind(sock, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0)
+    {
+        error = "Failed to bind uevent socket: " + std::to_string(errno);
+        close(sock);
+        return false;
+    }
+
+    fd = sock;
+    fromKernel = true;
+    return true;
+}
+
+bool UeventMonitor::Adopt(int newFd)
+{
+    Close();
+    fd = newFd;
+    fromKernel = false;
+    return true;
+}
+
+bool UeventMonitor::OpenReplay(const std::string &path, std::string &error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        error = "Failed to open uevent replay file: " + path;
+        return false;
+    }
+
+    // 每个事件: 行 -> '\0' 分隔的字段, 与内核消息格式相同
+    std::vector<std::string> records;
+    std::string line;
+    std::string record;
+    while (std::getline(file, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (line.empty())
+        {
+            if (!record.empty())
+            {
+                records.push_back(record);
+                record.clear();
+            }
+            continue;
+        }
+        record += line;
+        record.push_back('\0');
+    }
+    if (!record.empty())
+    {
+        records.push_back(record);
+    }
+
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, pair) < 0)
+    {
+        error = "Failed to create replay socket: " + std::to_string(errno);
+        return false;
+    }
+
+    Adopt(pair[0]);
+
+    // 写入端在单独的线程中, 录制的事件多于套接字缓冲区时也不会阻塞; 写完后关闭, 读取端随之结束
+    int writer = pair[1];
+    replayThread = std::thread([writer, records]() {
+        for (const std::string &r : records)
+        {
+            if (send(writer, r.data(), r.size(), MSG_NOSIGNAL) < 0)
+            {
+                break;
+            }
+        }
+        close(writer);
+    });
+    return true;
+}
+
+void UeventMonitor::Stop()
+{
+    running = false;
+    if (wakeFd >= 0)
+    {
+        uint64_t one = 1;
+        ssize_t rc = write(wakeFd, &one, sizeof(one));
+        (void)rc;
+    }
+}
+
+void UeventMonitor::Run(ChangeFn onChange)
+{
+    if (fd < 0)
+    {
+        return;
+    }
+
+    running = true;
+    struct pollfd fds[2];
+    fds[0].fd = fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = wakeFd;
+    fds[1].events = POLLIN;
+
+    while (running)
+    {
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents || !running)
+        {
+            break;
+        }
+
+        // 一次取完套接字中排队的全部消息
+        for (;;)
+        {
+            struct sockaddr_nl sender;
+            struct iovec iov;
+            iov.iov_base = message;
+            iov.iov_len = sizeof(message);
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            if (fromKernel)
+            {
+                msg.msg_name = &sender;
+                msg.msg_namelen = sizeof(sender);
+            }
+
+            ssize_t n = recvmsg(fd, &msg, MSG_DONTWAIT);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (errno == ENOBUFS)
+                {
+                    // 事件太多, 内核丢弃了一部分: 索引可能已过期, 下次查找时重新扫描
+                    DeviceIndex::Shared().Invalidate();
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    break;
+                }
+                running = false;
+                break;
+            }
+            if (n == 0)
+            {
+                // 回放结束
+                running = false;
+                break;
+            }
+
+            // 只接受内核发出的消息 (nl_pid == 0), 忽略其他进程伪造的事件
+            if (fromKernel && (msg.msg_namelen != sizeof(sender) || sender.nl_pid != 0))
+            {
+                continue;
+            }
+
+            size_t length = static_cast<size_t>(n);
+            if (!UeventMayBePrinter(message, length))
+            {
+                continue;
+            }
+
+            UeventView view;
+            if (ParseUevent(message, length, view))
+            {
+                Handle(view, onChange);
+            }
+        }
+    }
+    running = false;
+}
+
+void UeventMonitor::Handle(const UeventView &view, const ChangeFn &onChange)
+{
+    // 打印机接口 (接口类 7): 记录 VID/PID, 供随后的 lpN 节点事件使用
+    if (Equals(view.subsystem, view.subsystemLength, "usb"))
+    {
+        if (view.devtype && Equals(view.devtype, view.devtypeLength, "usb_interface") && view.interfaceClass == 7)
+        {
+            if (view.action == UeventView::Action::ADD || view.action == UeventView::Action::BIND)
+            {
+                Remember(view);
+            }
+            else if (view.action == UeventView::Action::REMOVE)
+            {
+                Forget(view);
+            }
+        }
+        return;
+    }
+
+    if (!Equals(view.subsystem, view.subsystemLength, "usbmisc") || !view.devname ||
+        !StartsWith(view.devname, view.devnameLength, "usb/lp"))
+    {
+        return;
+    }
+    if (view.action != UeventView::Action::ADD && view.action != UeventView::Action::REMOVE)
+    {
+        return;
+    }
+
+    HotplugChange change;
+    change.arrival = view.action == UeventView::Action::ADD;
+    char path[sizeof(change.path)];
+    size_t nameLength = std::min(view.devnameLength, sizeof(path) - 6);
+    memcpy(path, "/dev/", 5);
+    memcpy(path + 5, view.devname, nameLength);
+    CopyPath(change.path, path, 5 + nameLength);
+
+    change.hasIds = LookupParent(view, change.vendorId, change.productId);
+
+    DeviceIndex &index = DeviceIndex::Shared();
+    if (change.arrival)
+    {
+        index.Invalidate();
+        if (!change.hasIds)
+        {
+            DeviceInfo info;
+            if (index.FindPath(change.path, info))
+            {
+                change.vendorId = info.vendorId;
+                change.productId = info.productId;
+                change.hasIds = true;
+            }
+        }
+    }
+    else
+    {
+        if (!change.hasIds)
+        {
+            DeviceInfo info;
+            if (index.FindPath(change.path, info))
+            {
+                change.vendorId = info.vendorId;
+                change.productId = info.productId;
+                change.hasIds = true;
+            }
+        }
+        index.Remove(change.path);
+    }
+
+    onChange(change);
+}
+
+void UeventMonitor::Remember(const UeventView &view)
+{
+    if (!view.hasProduct || view.devpathLength >= sizeof(recent[0].devpath))
+    {
+        return;
+    }
+
+    RecentInterface &entry = recent[nextRecent];
+    nextRecent = (nextRecent + 1) % RECENT_INTERFACES;
+    memcpy(entry.devpath, view.devpath, view.devpathLength);
+    entry.length = view.devpathLength;
+    entry.vendorId = view.vendorId;
+    entry.productId = view.productId;
+    entry.used = true;
+}
+
+void UeventMonitor::Forget(const UeventView &view)
+{
+    for (RecentInterface &entry : recent)
+    {
+        if (entry.used && entry.length == view.devpathLength && memcmp(entry.devpath, view.devpath, entry.length) == 0)
+        {
+            entry.used = false;
+        }
+    }
+}
+
+bool UeventMonitor::LookupParent(const UeventView &view, uint16_t &vendorId, uint16_t &productId) const
+{
+    // lpN 的 DEVPATH 是 <接口 DEVPATH>/usbmisc/lpN
+    for (const RecentInterface &entry : recent)
+    {
+        if (entry.used && view.devpathLength > entry.length &&
+            memcmp(view.devpath, entry.devpath, entry.length) == 0 && view.devpath[entry.length] == '/')
+        {
+            vendorId = entry.vendorId;
+            productId = entry.productId;
+            return true;
+        }
+    }
+    return false;
+}
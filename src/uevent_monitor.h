@@ -0,0 +1,85 @@
+#pragma once
+#include "hotplug.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+// 内核 uevent 消息的解析结果; 字符串字段直接指向消息缓冲区, 不复制、不分配内存
+struct UeventView {
+    enum class Action { ADD, REMOVE, CHANGE, BIND, UNBIND, OTHER };
+
+    Action action = Action::OTHER;
+    const char *devpath = nullptr;
+    size_t devpathLength = 0;
+    const char *subsystem = nullptr;
+    size_t subsystemLength = 0;
+    const char *devtype = nullptr;
+    size_t devtypeLength = 0;
+    const char *devname = nullptr;
+    size_t devnameLength = 0;
+    bool hasProduct = false;       // PRODUCT=vid/pid/bcd (十六进制)
+    uint16_t vendorId = 0;
+    uint16_t productId = 0;
+    int interfaceClass = -1;       // INTERFACE=class/subclass/protocol (十进制), 打印机类为 7
+};
+
+// 解析 "action@devpath\0KEY=VALUE\0..." 格式的消息; 不是内核 uevent 时返回 false
+bool ParseUevent(const char *data, size_t length, UeventView &view);
+
+// 只看消息头 (action@devpath) 的快速预筛: 只有 USB 接口和 usbmisc (lpN) 节点可能与打印机有关,
+// 其他子系统 (block, net, tty, input...) 的消息在完整解析之前就被丢弃
+bool UeventMayBePrinter(const char *data, size_t length);
+
+// Linux 热插拔监听: 从 NETLINK_KOBJECT_UEVENT 套接字读取内核事件, 只上报打印机 (usblp) 设备.
+// 也可以从录制的事件文件回放 (通过 socketpair 送入同一条读取路径), 便于在没有硬件时测试.
+class UeventMonitor {
+public:
+    typedef std::function<void(const HotplugChange &change)> ChangeFn;
+
+    UeventMonitor();
+    ~UeventMonitor();
+
+    bool OpenNetlink(std::string &error);
+
+    // 回放文件格式: 每个事件为 "action@devpath" 一行加若干 "KEY=VALUE" 行, 事件之间用空行分隔
+    bool OpenReplay(const std::string &path, std::string &error);
+
+    // 接管一个已有的数据报套接字 (例如 socketpair 的一端)
+    bool Adopt(int fd);
+
+    // 在当前线程上运行, 直到 Stop() 或事件源关闭
+    void Run(ChangeFn onChange);
+    void Stop();
+
+private:
+    // 最近出现的打印机接口: 内核为 lpN 节点发送的事件不带 VID/PID, 需要从父接口的事件中取得
+    struct RecentInterface {
+        char devpath[256];
+        size_t length;
+        uint16_t vendorId;
+        uint16_t productId;
+        bool used;
+    };
+
+    static const size_t RECENT_INTERFACES = 32;
+    static const size_t MESSAGE_SIZE = 8192;
+
+    void Handle(const UeventView &view, const ChangeFn &onChange);
+    void Remember(const UeventView &view);
+    void Forget(const UeventView &view);
+    bool LookupParent(const UeventView &view, uint16_t &vendorId, uint16_t &productId) const;
+    void Close();
+
+    int fd;
+    int wakeFd;
+    bool fromKernel;
+    std::atomic<bool> running;
+    std::thread replayThread;
+
+    RecentInterface recent[RECENT_INTERFACES];
+    size_t nextRecent;
+    char message[MESSAGE_SIZE];
+};
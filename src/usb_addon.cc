@@ -1,12 +1,118 @@
 ﻿#include "usb_addon.h"
+#include "addon_data.h"
+#include "buffer_pool.h"
+#include "device_handoff.h"
+#include "device_index.h"
+#include "file_source.h"
+#include "job_cache.h"
+#include "job_cache_binding.h"
+#include "js_buffer.h"
+#include "log_binding.h"
+#include "logger.h"
+#include "plt_tools.h"
+#include "profile_binding.h"
+#include "trace_tools.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#ifdef _WIN32
 #include <dbt.h>
-#include <iostream>
 #include <setupapi.h>
 #include <initguid.h>
 #include <usbprint.h>
-#include <regex>
+#endif
+#ifdef __linux__
+#include "device_pool.h"
+#endif
+#ifndef _WIN32
+#include "emulator_wrap.h"
+#endif
+
+namespace {
+
+// 单调时钟毫秒数, 用于读超时计算
+int64_t NowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// 单次读取的最大字节数
+const size_t READ_BUFFER_SIZE = 1024;
+
+// 读取 info[index] 中可选的 { timeout } (毫秒), 没有时保留 timeoutMs 原值
+// 参数不合法时抛出 JS 异常并返回 false
+bool ReadTimeoutOption(const Napi::CallbackInfo &info, size_t index, int &timeoutMs)
+{
+    if (info.Length() <= index || !info[index].IsObject())
+    {
+        return true;
+    }
+
+    Napi::Object options = info[index].As<Napi::Object>();
+    if (!options.Has("timeout"))
+    {
+        return true;
+    }
+
+    Napi::Value value = options.Get("timeout");
+    if (!value.IsNumber() || value.As<Napi::Number>().Int32Value() <= 0)
+    {
+        Napi::RangeError::New(info.Env(), "timeout must be a positive number").ThrowAsJavaScriptException();
+        return false;
+    }
+    timeoutMs = value.As<Napi::Number>().Int32Value();
+    return true;
+}
+
+// 可选参数: { chunkSize, progressInterval }, chunkSize 默认取型号配置; 参数不合法时抛出 JS 异常并返回 false
+bool ReadPltJobOptions(const Napi::CallbackInfo &info, size_t index, size_t defaultChunkSize, PltJob &job)
+{
+    job.chunkSize = defaultChunkSize;
+    job.progressInterval = 100;
+    if (info.Length() <= index || !info[index].IsObject())
+    {
+        return true;
+    }
+
+    // 两项都要求是数字, 超出范围时不截断 (例如 -1 转成 uint32 会变成极大的块)
+    Napi::Object options = info[index].As<Napi::Object>();
+    const char *names[] = {"chunkSize", "progressInterval"};
+    const double minimums[] = {1, 0};
+    for (int i = 0; i < 2; i++)
+    {
+        if (!options.Has(names[i]))
+        {
+            continue;
+        }
+        Napi::Value value = options.Get(names[i]);
+        if (!value.IsNumber())
+        {
+            Napi::TypeError::New(info.Env(), std::string(names[i]) + " must be a number").ThrowAsJavaScriptException();
+            return false;
+        }
+        double number = value.As<Napi::Number>().DoubleValue();
+        if (!(number >= minimums[i] && number <= INT32_MAX))
+        {
+            Napi::RangeError::New(info.Env(), std::string(names[i]) + (i == 0 ? " must be positive" : " must not be negative"))
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        if (i == 0)
+        {
+            job.chunkSize = static_cast<size_t>(number);
+        }
+        else
+        {
+            job.progressInterval = static_cast<int>(number);
+        }
+    }
+    return true;
+}
 
-Napi::FunctionReference UsbDevice::constructor;
+} // namespace
 
 Napi::Object UsbDevice::Init(Napi::Env env, Napi::Object exports)
 {
@@ -14,16 +120,36 @@ Napi::Object UsbDevice::Init(Napi::Env env, Napi::Object exports)
 
     Napi::Function func = DefineClass(env, "UsbDevice", {
         InstanceMethod("connect", &UsbDevice::Connect),
+        InstanceMethod("connectPath", &UsbDevice::ConnectPath),
         InstanceMethod("disconnect", &UsbDevice::Disconnect),
+        InstanceMethod("isConnected", &UsbDevice::IsConnected),
+        InstanceMethod("detach", &UsbDevice::Detach),
+        InstanceMethod("attach", &UsbDevice::Attach),
+        InstanceMethod("setAutoReconnect", &UsbDevice::SetAutoReconnect),
         InstanceMethod("sendPlt", &UsbDevice::SendPlt),
         InstanceMethod("sendCmd", &UsbDevice::SendCmd),
+        InstanceMethod("sendPltAsync", &UsbDevice::SendPltAsync),
+        InstanceMethod("sendCmdAsync", &UsbDevice::SendCmdAsync),
+        InstanceMethod("startPlt", &UsbDevice::StartPlt),
+        InstanceMethod("sendPltFile", &UsbDevice::SendPltFile),
+        InstanceMethod("sendCached", &UsbDevice::SendCached),
+        InstanceMethod("pausePlt", &UsbDevice::PausePlt),
+        InstanceMethod("resumePlt", &UsbDevice::ResumePlt),
+        InstanceMethod("cancelPlt", &UsbDevice::CancelPlt),
         InstanceMethod("getSendProgress", &UsbDevice::GetSendProgress),
+        InstanceMethod("getEventStats", &UsbDevice::GetEventStats),
+        InstanceMethod("getStats", &UsbDevice::GetStats),
+        InstanceMethod("resetStats", &UsbDevice::ResetStats),
+        InstanceMethod("startCapture", &UsbDevice::StartCapture),
+        InstanceMethod("stopCapture", &UsbDevice::StopCapture),
+        InstanceMethod("setTimeouts", &UsbDevice::SetTimeouts),
+        InstanceMethod("getProfile", &UsbDevice::GetProfile),
+        InstanceMethod("setFlowControl", &UsbDevice::SetFlowControl),
         InstanceMethod("startHotplugMonitor", &UsbDevice::StartHotplugMonitor),
         InstanceMethod("stopHotplugMonitor", &UsbDevice::StopHotplugMonitor)
     });
 
-    constructor = Napi::Persistent(func);
-    constructor.SuppressDestruct();
+    AddonData::Get(env).usbDevice = Napi::Persistent(func);
 
     exports.Set("UsbDevice", func);
     return exports;
@@ -32,487 +158,1466 @@ Napi::Object UsbDevice::Init(Napi::Env env, Napi::Object exports)
 UsbDevice::UsbDevice(const Napi::CallbackInfo &info)
     : Napi::ObjectWrap<UsbDevice>(info)
 {
-    deviceHandle = INVALID_HANDLE_VALUE;
+    transport.reset(new TracingTransport(CreateTransport()));
+    events = std::make_shared<EventChannel>();
+    mux.reset(new CommandMux(transport.get(), scheduler, &stats));
+    retriesAtReset = 0;
+    preemptionsAtReset = 0;
+    cmdTimeoutMs = CMD_TIMEOUT;
+    pltTimeoutMs = PLT_TIMEOUT;
+    terminatedReplies = true;
+    activeProfile = DeviceProfiles::Default();
     isConnected = false;
+    connectionId = 0;
+    autoReconnect = false;
+    resumeJobs = true;
+    reconnectTimeoutMs = DEFAULT_RECONNECT_TIMEOUT;
+    reconnectIntervalMs = DEFAULT_RECONNECT_INTERVAL;
+    linkLost = false;
+    linkBusy = false;
+    linkArrival = false;
+    shouldStopLink = false;
     shouldStopNotification = false;
+#ifdef _WIN32
     deviceNotificationHandle = NULL;
+#endif
     sendProgress = 0.0;
+    loopHolds = 0;
     isOperationInProgress = false;
+    shouldStopSend = false;
+    sendPaused = false;
+    activeStreamer = nullptr;
+    currentVendorId = 0;
+    currentProductId = 0;
+
+    // 内部任务队列: 让后台线程可以在 JS 线程上完成 Promise、释放引用等;
+    // 平时 Unref 以免阻止进程退出, 有等待响应的命令或后台 PLT 作业时由 HoldLoop 重新 Ref
+    // 每次调用都执行队列中的全部任务; 环境销毁时没执行的任务由 finalizer 释放
+    Napi::Env env = info.Env();
+    std::shared_ptr<JsTaskQueue> taskQueue = std::make_shared<JsTaskQueue>();
+    jsTaskQueue = taskQueue;
+    jsTasks = Napi::ThreadSafeFunction::New(
+        env,
+        Napi::Function::New(env, [taskQueue](const Napi::CallbackInfo &call) { taskQueue->Run(call.Env()); }),
+        "UsbDeviceTasks",
+        0,
+        1,
+        [taskQueue](Napi::Env) {
+            std::lock_guard<std::mutex> lock(taskQueue->mutex);
+            taskQueue->tasks.clear();
+        });
+    jsTasks.Unref(env);
+
+    // 环境销毁时 (例如 worker 退出) 对象不一定会被回收, 由清理钩子停止后台线程
+    cleanupHook = env.AddCleanupHook(&UsbDevice::OnEnvCleanup, this);
 }
 
 UsbDevice::~UsbDevice()
 {
+    if (!cleanupHook.IsEmpty())
+    {
+        cleanupHook.Remove(Env());
+    }
+
     // 安全清理资源
-    if (isConnected)
+    Shutdown();
+    if (jsTasks)
     {
-        if (deviceHandle != INVALID_HANDLE_VALUE)
-        {
-            CloseHandle(deviceHandle);
-            deviceHandle = INVALID_HANDLE_VALUE;
-        }
-        isConnected = false;
+        jsTasks.Release();
     }
+}
+
+void UsbDevice::OnEnvCleanup(UsbDevice *device)
+{
+    // 钩子调用后即被删除, 析构时不能再移除
+    device->cleanupHook = CleanupHook();
+    device->Shutdown();
+    device->jsTasks.Release();
+    device->jsTasks = Napi::ThreadSafeFunction();
+}
+
+// 停止所有后台线程并关闭设备, 可以重复调用
+void UsbDevice::Shutdown()
+{
+    StopLinkThread();
+    StopSendThread();
+    CloseDevice();
 
     if (notificationThread.joinable())
     {
         shouldStopNotification = true;
+#ifdef __linux__
+        ueventMonitor->Stop();
+#endif
         notificationThread.join();
     }
 }
 
-bool UsbDevice::InitializeDevice(HANDLE handle)
+bool UsbDevice::OpenDevice(const std::string &devicePath)
 {
-    if (handle == INVALID_HANDLE_VALUE)
+    WriteScheduler::Guard lock(scheduler, WriteScheduler::Priority::INTERACTIVE);
+
+    // 如果已经连接，先断开连接并清理资源
+    if (isConnected)
     {
-        std::cerr << "Invalid device handle" << std::endl;
-        return false;
+        // 取消所有待处理的 I/O 操作
+        mux->Stop();
+        transport->CancelPending();
+        transport->Close();
+        isConnected = false;
     }
 
     // 对于USB打印机，我们不需要配置串口参数
-    // 只需检查设备句柄是否有效
+    // 只需检查设备是否能打开
+    if (!transport->Open(devicePath))
+    {
+        LOG_WARN("Failed to open device %s: %d", devicePath.c_str(), transport->LastError());
+        return false;
+    }
+
+    StartReader(devicePath);
     return true;
 }
 
-std::string UsbDevice::GetDevicePath(WORD vendorId, WORD productId)
+// 设备已经打开 (OpenDevice 或 attach): 开始读取并标记为已连接; 调用方持有写权限
+void UsbDevice::StartReader(const std::string &devicePath)
 {
-    // 使用打印机类 GUID
-    HDEVINFO deviceInfo = SetupDiGetClassDevsA(&GUID_DEVINTERFACE_USBPRINT, NULL, NULL, DIGCF_PRESENT | DIGCF_DEVICEINTERFACE);
-    if (deviceInfo == INVALID_HANDLE_VALUE)
-    {
-        std::cerr << "SetupDiGetClassDevsA failed: " << GetLastError() << std::endl;
-        return "";
-    }
+    // 重置其他状态
+    sendProgress = 0.0;
+    isOperationInProgress = false;
 
-    SP_DEVICE_INTERFACE_DATA interfaceData;
-    interfaceData.cbSize = sizeof(SP_DEVICE_INTERFACE_DATA);
+    // 读线程持续读取设备数据, 没有请求等待的响应帧作为 CMD_RESPONSE 事件发出;
+    // 读取失败说明设备被移除或复位, 交给 linkThread 关闭句柄 (读线程自己不能停止 mux)
+    uint64_t connection = ++connectionId;
+    mux->Start([this](std::vector<uint8_t> *frame) {
+        EmitCmdResponse(frame);
+    }, [this, connection]() {
+        OnDeviceLost(connection);
+    });
 
-    for (DWORD i = 0; SetupDiEnumDeviceInterfaces(deviceInfo, NULL, &GUID_DEVINTERFACE_USBPRINT, i, &interfaceData); i++)
     {
-        DWORD requiredSize = 0;
-        SetupDiGetDeviceInterfaceDetailA(deviceInfo, &interfaceData, NULL, 0, &requiredSize, NULL);
+        std::lock_guard<std::mutex> lock(linkMutex);
+        connectedPath = devicePath;
+    }
+    isConnected = true;
+    LOG_INFO("Device connected: %s", devicePath.c_str());
+}
 
-        PSP_DEVICE_INTERFACE_DETAIL_DATA_A detailData = (PSP_DEVICE_INTERFACE_DETAIL_DATA_A)malloc(requiredSize);
-        detailData->cbSize = sizeof(SP_DEVICE_INTERFACE_DETAIL_DATA_A);
+void UsbDevice::CloseDevice()
+{
+    // 等待正在进行的 I/O (可能在工作线程中) 完成后再关闭
+    WriteScheduler::Guard lock(scheduler, WriteScheduler::Priority::INTERACTIVE);
+    if (isConnected)
+    {
+        mux->Stop();
+        transport->Close();
+        isConnected = false;
+    }
+}
 
-        SP_DEVINFO_DATA devInfoData;
-        devInfoData.cbSize = sizeof(SP_DEVINFO_DATA);
+Napi::Value UsbDevice::Connect(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
 
-        if (!SetupDiGetDeviceInterfaceDetailA(deviceInfo, &interfaceData, detailData, requiredSize, NULL, &devInfoData))
-        {
-            std::cerr << "SetupDiGetDeviceInterfaceDetailA failed: " << GetLastError() << std::endl;
-            free(detailData);
-            continue;
-        }
+    if (info.Length() < 2)
+    {
+        Napi::TypeError::New(env, "Wrong number of arguments").ThrowAsJavaScriptException();
+        return env.Null();
+    }
 
-        std::string devicePath = detailData->DevicePath;
-        free(detailData);
+    uint16_t vendorId = (uint16_t)info[0].As<Napi::Number>().Uint32Value();
+    uint16_t productId = (uint16_t)info[1].As<Napi::Number>().Uint32Value();
 
-        // 获取设备硬件ID，包含VID/PID信息
-        char hardwareId[256] = {0};
-        if (!SetupDiGetDeviceRegistryPropertyA(deviceInfo, &devInfoData, SPDRP_HARDWAREID, NULL,
-                                               (PBYTE)hardwareId, sizeof(hardwareId), NULL))
-        {
-            std::cerr << "SetupDiGetDeviceRegistryPropertyA failed: " << GetLastError() << std::endl;
-            continue;
-        }
+    // 可选的序列号, 用于区分同型号的多台设备
+    std::string serial;
+    if (info.Length() >= 3 && info[2].IsString())
+    {
+        serial = info[2].As<Napi::String>().Utf8Value();
+    }
 
-        // 打印硬件ID以便调试
-        std::cout << "Device " << i << " Hardware ID: " << hardwareId << std::endl;
-        std::cout << "Device Path: " << devicePath << std::endl;
+    // 新的连接取代正在进行的自动重连
+    StopReconnect();
 
-        // 如果VID/PID为0，则匹配任何设备
-        if (vendorId == 0 && productId == 0)
-        {
-            SetupDiDestroyDeviceInfoList(deviceInfo);
-            return devicePath;
-        }
+    // 从设备索引中查找, 不再每次扫描总线
+    DeviceIndex &index = DeviceIndex::Shared();
+    DeviceInfo device;
+    if (!index.Find(vendorId, productId, serial, device))
+    {
+        return Napi::Boolean::New(env, false);
+    }
 
-        // 检查VID/PID
-        char vidPattern[10];
-        char pidPattern[10];
-        sprintf_s(vidPattern, "VID_%04X", vendorId);
-        sprintf_s(pidPattern, "PID_%04X", productId);
+    // 按实际找到的设备选择型号配置 (vendorId/productId 为 0 时匹配的是任意设备)
+    ApplyProfile(DeviceProfiles::Shared().Find(device.vendorId, device.productId));
 
-        // 检查硬件ID是否包含匹配的VID和PID
-        if (strstr(hardwareId, vidPattern) && strstr(hardwareId, pidPattern))
+    // 打开失败可能是索引已过期 (设备被拔出后换了节点), 重新扫描后再试一次
+    if (!OpenDevice(device.path))
+    {
+        index.Invalidate();
+        if (!index.Find(vendorId, productId, serial, device) || !OpenDevice(device.path))
         {
-            std::cout << "Found matching device with VID: 0x" << std::hex << vendorId
-                      << " PID: 0x" << productId << std::dec << std::endl;
-            SetupDiDestroyDeviceInfoList(deviceInfo);
-            return devicePath;
+            return Napi::Boolean::New(env, false);
         }
     }
 
-    SetupDiDestroyDeviceInfoList(deviceInfo);
-    return "";
+    {
+        std::lock_guard<std::mutex> lock(linkMutex);
+        currentVendorId = vendorId;
+        currentProductId = productId;
+        deviceSerial = serial;
+    }
+    return Napi::Boolean::New(env, true);
 }
 
-Napi::Value UsbDevice::Connect(const Napi::CallbackInfo &info)
+Napi::Value UsbDevice::ConnectPath(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 2)
+    if (info.Length() < 1 || !info[0].IsString())
     {
-        Napi::TypeError::New(env, "Wrong number of arguments").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Expected device path as argument").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    // 如果已经连接，先断开连接并清理资源
-    if (isConnected)
+    // 直接打开指定路径, 例如 /dev/usb/lp0, 或用于测试的 pty
+    std::string devicePath = info[0].As<Napi::String>().Utf8Value();
+    LOG_DEBUG("Trying to connect to device at %s", devicePath.c_str());
+
+    // 型号配置: 可选参数 { vendorId, productId } 指定 (例如模拟器), 否则按设备索引中该路径的 VID/PID
+    DeviceInfo device;
+    if (info.Length() >= 2 && info[1].IsObject())
     {
-        // 取消所有待处理的 I/O 操作
-        CancelIo(deviceHandle);
-        isConnected = false;
+        Napi::Object options = info[1].As<Napi::Object>();
+        device.vendorId = static_cast<uint16_t>(options.Get("vendorId").ToNumber().Uint32Value());
+        device.productId = static_cast<uint16_t>(options.Get("productId").ToNumber().Uint32Value());
     }
+    else if (!DeviceIndex::Shared().FindPath(devicePath, device))
+    {
+        device = DeviceInfo();
+    }
+    StopReconnect();
+    ApplyProfile(DeviceProfiles::Shared().Find(device.vendorId, device.productId));
 
-    WORD vendorId = (WORD)info[0].As<Napi::Number>().Uint32Value();
-    WORD productId = (WORD)info[1].As<Napi::Number>().Uint32Value();
-
-    std::cout << "Trying to connect to device with VID: 0x" << std::hex << vendorId
-              << " PID: 0x" << productId << std::dec << std::endl;
-
-    std::string devicePath = GetDevicePath(vendorId, productId);
-    if (devicePath.empty())
+    if (!OpenDevice(devicePath))
     {
         return Napi::Boolean::New(env, false);
     }
 
-    // 打开设备
-    deviceHandle = CreateFileA(devicePath.c_str(),
-                             GENERIC_READ | GENERIC_WRITE,
-                             0,  // 不共享
-                             NULL,
-                             OPEN_EXISTING,
-                             FILE_ATTRIBUTE_NORMAL,      //海沃佳的只能是Normal
-                             NULL);
-
-    if (deviceHandle == INVALID_HANDLE_VALUE)
     {
-        std::cout << "Failed to open device: " << GetLastError() << std::endl;
-        return Napi::Boolean::New(env, false);
+        std::lock_guard<std::mutex> lock(linkMutex);
+        currentVendorId = device.vendorId;
+        currentProductId = device.productId;
+        deviceSerial = device.serial;
     }
+    return Napi::Boolean::New(env, true);
+}
 
-    // 重置其他状态
-    sendProgress = 0.0;
-    isOperationInProgress = false;
+// 连接前应用型号配置: 之后 setTimeouts() / setFlowControl() 可以再单独修改
+void UsbDevice::ApplyProfile(const DeviceProfile &profile)
+{
+    activeProfile = profile;
+    cmdTimeoutMs = profile.commandTimeout;
+    pltTimeoutMs = profile.pltTimeout;
+    // 没有结束符的型号按 RAW 匹配命令响应, 其余数据仍按 ';' 切分
+    terminatedReplies = profile.terminator != 0;
+    mux->SetTerminator(profile.terminator != 0 ? profile.terminator : ';');
+    transport->SetOpenAttributes(profile.fileAttributes);
+    {
+        std::lock_guard<std::mutex> lock(sendQueueMutex);
+        flowProfile = profile.flow;
+    }
+    LOG_DEBUG("Using device profile %s", profile.name.c_str());
+}
 
-    isConnected = true;
-    std::cout << "Device connected successfully" << std::endl;
-    return Napi::Boolean::New(env, true);
+// getProfile() -> 当前连接使用的型号配置
+Napi::Value UsbDevice::GetProfile(const Napi::CallbackInfo &info)
+{
+    return DeviceProfileToJs(info.Env(), activeProfile);
 }
 
 Napi::Value UsbDevice::Disconnect(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
 
-    if (isConnected)
-    {
-        if (deviceHandle != INVALID_HANDLE_VALUE)
-        {
-            CloseHandle(deviceHandle);
-            deviceHandle = INVALID_HANDLE_VALUE;
-        }
-        isConnected = false;
-    }
+    StopReconnect();
+    CancelPltJobs();
+    CloseDevice();
 
     return Napi::Boolean::New(env, true);
 }
 
-Napi::Value UsbDevice::SendPlt(const Napi::CallbackInfo &info)
+// isConnected() -> 设备句柄是否打开; 设备被移除后变为 false, 自动重连成功后恢复为 true
+Napi::Value UsbDevice::IsConnected(const Napi::CallbackInfo &info)
+{
+    return Napi::Boolean::New(info.Env(), isConnected.load());
+}
+
+// detach() -> 令牌; 把打开的设备交给 DeviceHandoff, 令牌可以 postMessage 给其他 worker 用 attach() 取出.
+// 之后本对象处于未连接状态. 有后台 PLT 作业时抛出异常; 在途的命令以 "Device not connected" 结束
+Napi::Value UsbDevice::Detach(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
 
-    if (!isConnected || deviceHandle == INVALID_HANDLE_VALUE)
+    StopReconnect();
+    if (!isConnected || !transport->IsOpen())
     {
         Napi::Error::New(env, "Device not connected").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    if (info.Length() < 1 || !info[0].IsBuffer())
+    std::unique_ptr<DetachedDevice> detached(new DetachedDevice());
     {
-        Napi::TypeError::New(env, "Expected buffer as argument").ThrowAsJavaScriptException();
-        return env.Null();
+        std::lock_guard<std::mutex> lock(sendQueueMutex);
+        if (activeStreamer || !sendQueue.empty())
+        {
+            Napi::Error::New(env, "PLT job in progress").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        detached->flow = flowProfile;
+    }
+    {
+        std::lock_guard<std::mutex> lock(linkMutex);
+        detached->path = connectedPath;
+        detached->serial = deviceSerial;
     }
+    detached->vendorId = currentVendorId;
+    detached->productId = currentProductId;
+    detached->profile = activeProfile;
+    detached->commandTimeout = cmdTimeoutMs;
+    detached->pltTimeout = pltTimeoutMs;
 
-    Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
-    if (buffer.Length() == 0)
+    // 停止读线程后换下打开的传输层, 本对象换上一个新的 (未打开的)
     {
-        Napi::Error::New(env, "Empty buffer").ThrowAsJavaScriptException();
-        return env.Null();
+        WriteScheduler::Guard lock(scheduler, WriteScheduler::Priority::INTERACTIVE);
+        mux->Stop();
+        isConnected = false;
+        detached->transport = transport->SwapInner(CreateTransport());
+        transport->SetOpenAttributes(activeProfile.fileAttributes);
     }
 
-    // 1. 取消所有待处理的 I/O 操作
-    CancelIo(deviceHandle);
-    Sleep(10);  // 给设备一些时间处理取消操作
+    LOG_INFO("Device detached: %s", detached->path.c_str());
+    uint32_t token = DeviceHandoff::Shared().Put(std::move(detached));
+    return Napi::Number::New(env, token);
+}
+
+// attach(token) -> true; 取出 detach() 移交的设备 (可以来自其他 worker), 连同型号配置、超时和流控设置
+Napi::Value UsbDevice::Attach(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
 
-    // 2. 写入数据
-    DWORD bytesWritten = 0;
-    BOOL writeResult = WriteFile(
-        deviceHandle,
-        buffer.Data(),
-        static_cast<DWORD>(buffer.Length()),
-        &bytesWritten,
-        NULL  // 不使用 OVERLAPPED
-    );
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        Napi::TypeError::New(env, "Expected device token").ThrowAsJavaScriptException();
+        return env.Null();
+    }
 
-    if (!writeResult)
+    std::unique_ptr<DetachedDevice> detached = DeviceHandoff::Shared().Take(info[0].As<Napi::Number>().Uint32Value());
+    if (!detached)
     {
-        DWORD error = GetLastError();
-        std::cout << "Write operation failed with error: " << error << std::endl;
-        Napi::Error::New(env, "Failed to write data: " + std::to_string(error)).ThrowAsJavaScriptException();
+        Napi::Error::New(env, "Unknown device token").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    std::cout << "Successfully wrote " << bytesWritten << " bytes" << std::endl;
+    // 取代当前的连接
+    StopReconnect();
+    CancelPltJobs();
+    CloseDevice();
+
+    ApplyProfile(detached->profile);
+    cmdTimeoutMs = detached->commandTimeout;
+    pltTimeoutMs = detached->pltTimeout;
+    {
+        std::lock_guard<std::mutex> lock(sendQueueMutex);
+        flowProfile = detached->flow;
+    }
+    {
+        std::lock_guard<std::mutex> lock(linkMutex);
+        currentVendorId = detached->vendorId;
+        currentProductId = detached->productId;
+        deviceSerial = detached->serial;
+    }
 
-    // 3. 等待设备处理命令
-    Sleep(50);  // 给设备一些处理时间
+    {
+        WriteScheduler::Guard lock(scheduler, WriteScheduler::Priority::INTERACTIVE);
+        transport->SwapInner(std::move(detached->transport));
+        StartReader(detached->path);
+    }
+    return Napi::Boolean::New(env, true);
+}
 
-    // 4. 读取响应
-    const DWORD READ_BUFFER_SIZE = 1024;
-    std::vector<uint8_t> readBuffer(READ_BUFFER_SIZE);
-    DWORD bytesRead = 0;
-    bool responseReceived = false;
-    int readAttempts = 0;
-    const int MAX_READ_ATTEMPTS = 5;
-    DWORD startTime = GetTickCount();
-    const DWORD TIMEOUT = 500;
+// setAutoReconnect({ enabled, resume, timeout, interval }) -> true; setAutoReconnect(false) 关闭
+// 设备被移除时总会关闭句柄并发出 DISCONNECTED 事件; 开启后在 timeout 毫秒内按原来的 VID/PID/序列号
+// (或原来的路径) 重新打开设备, resume 为 true 时后台 PLT 作业从中断的块继续发送
+Napi::Value UsbDevice::SetAutoReconnect(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
 
-    while (!responseReceived && readAttempts < MAX_READ_ATTEMPTS && (GetTickCount() - startTime) < TIMEOUT)
+    bool enabled = info.Length() >= 1 && info[0].ToBoolean().Value();
+    bool resume = true;
+    int timeoutMs = DEFAULT_RECONNECT_TIMEOUT;
+    int intervalMs = DEFAULT_RECONNECT_INTERVAL;
+    if (info.Length() >= 1 && info[0].IsObject())
     {
-        readAttempts++;
-        
-        // 使用同步读取
-        BOOL readResult = ReadFile(
-            deviceHandle,
-            readBuffer.data(),
-            READ_BUFFER_SIZE,
-            &bytesRead,
-            NULL  // 不使用 OVERLAPPED
-        );
-
-        if (!readResult)
-        {
-            DWORD error = GetLastError();
-            if (error == ERROR_NO_DATA)
-            {
-                std::cout << "No data available, retrying..." << std::endl;
-                Sleep(10);
-            }
-            else
-            {
-                std::cout << "Error while reading response: " << error << std::endl;
-            }
+        Napi::Object options = info[0].As<Napi::Object>();
+        if (options.Has("enabled"))
+        {
+            enabled = options.Get("enabled").ToBoolean().Value();
         }
-        else if (bytesRead > 0)
+        if (options.Has("resume"))
         {
-            responseReceived = true;
-            std::cout << "Received response of " << bytesRead << " bytes" << std::endl;
-            break;
+            resume = options.Get("resume").ToBoolean().Value();
         }
-
-        if (!responseReceived)
+        const char *names[] = {"timeout", "interval"};
+        int *values[] = {&timeoutMs, &intervalMs};
+        for (int i = 0; i < 2; i++)
         {
-            Sleep(10);
+            if (!options.Has(names[i]))
+            {
+                continue;
+            }
+            Napi::Value value = options.Get(names[i]);
+            if (!value.IsNumber() || value.As<Napi::Number>().Int32Value() <= 0)
+            {
+                Napi::RangeError::New(env, std::string(names[i]) + " must be a positive number").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+            *values[i] = value.As<Napi::Number>().Int32Value();
         }
     }
 
-    // 5. 返回结果
-    if (responseReceived && bytesRead > 0)
+    std::lock_guard<std::mutex> lock(linkMutex);
+    autoReconnect = enabled;
+    resumeJobs = resume;
+    reconnectTimeoutMs = timeoutMs;
+    reconnectIntervalMs = intervalMs;
+    linkCv.notify_all();
+    return Napi::Boolean::New(env, true);
+}
+
+// 设备被移除 (读写失败或热插拔事件): 交给 linkThread 处理; connection 不是当前连接时忽略
+void UsbDevice::OnDeviceLost(uint64_t connection)
+{
+    std::lock_guard<std::mutex> lock(linkMutex);
+    if (connection != connectionId || !isConnected || linkLost || shouldStopLink)
     {
-        CancelIo(deviceHandle);
-        Sleep(10);
-        // 创建一个新的缓冲区，只包含实际接收到的数据
-        std::vector<uint8_t> actualResponse(readBuffer.begin(), readBuffer.begin() + bytesRead);
-        return Napi::Buffer<uint8_t>::Copy(env, actualResponse.data(), actualResponse.size());
+        return;
     }
 
-    std::cout << "No valid response received after " << MAX_READ_ATTEMPTS << " attempts" << std::endl;
-    return env.Null();
+    LOG_WARN("Device removed: %s", connectedPath.c_str());
+    linkLost = true;
+    linkArrival = false;
+    if (!linkThread.joinable())
+    {
+        linkThread = std::thread(&UsbDevice::LinkThreadProc, this);
+    }
+    linkCv.notify_all();
 }
 
-Napi::Value UsbDevice::SendCmd(const Napi::CallbackInfo &info)
+namespace {
+
+// 热插拔事件中的路径可能被截断 (见 HotplugChange), 按前缀比较; Windows 的设备接口路径不区分大小写
+bool SameDevicePath(const std::string &path, const char *eventPath)
 {
-    Napi::Env env = info.Env();
+    size_t length = strlen(eventPath);
+    if (length == 0 || path.size() < length || (path.size() > length && length < sizeof(HotplugChange::path) - 1))
+    {
+        return false;
+    }
+#ifdef _WIN32
+    return _strnicmp(path.c_str(), eventPath, length) == 0;
+#else
+    return strncmp(path.c_str(), eventPath, length) == 0;
+#endif
+}
 
-    try {
-        if (!isConnected || deviceHandle == INVALID_HANDLE_VALUE)
+} // namespace
+
+// 所有热插拔事件先经过这里: 当前设备的移除事件关闭句柄, 重连期间的到达事件让 linkThread 立即重试
+void UsbDevice::OnHotplug(const HotplugChange &change)
+{
+    if (change.arrival)
+    {
+        std::lock_guard<std::mutex> lock(linkMutex);
+        if (linkLost)
         {
-            Napi::Error::New(env, "Device not connected").ThrowAsJavaScriptException();
-            return env.Null();
+            linkArrival = true;
+            linkCv.notify_all();
         }
-
-        if (info.Length() < 1 || !info[0].IsBuffer())
+    }
+    else
+    {
+        bool current;
         {
-            Napi::TypeError::New(env, "Expected buffer as argument").ThrowAsJavaScriptException();
-            return env.Null();
+            std::lock_guard<std::mutex> lock(linkMutex);
+            current = SameDevicePath(connectedPath, change.path);
         }
-
-        Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
-        if (buffer.Length() == 0)
+        if (current)
         {
-            Napi::Error::New(env, "Empty buffer").ThrowAsJavaScriptException();
-            return env.Null();
+            OnDeviceLost(connectionId);
         }
+    }
+
+    EmitHotplug(change);
+}
+
+// 按原来的 VID/PID/序列号在设备索引中查找 (有热插拔监听时只是查表, 不重新枚举总线),
+// 设备重新枚举后节点可能变化; 找不到时 (例如 connectPath 打开的不在索引中的设备) 再试原来的路径
+bool UsbDevice::ReopenDevice(const std::string &lastPath, uint16_t vendorId, uint16_t productId, const std::string &serial)
+{
+    DeviceInfo device;
+    if ((vendorId != 0 || productId != 0) &&
+        DeviceIndex::Shared().Find(vendorId, productId, serial, device) &&
+        OpenDevice(device.path))
+    {
+        return true;
+    }
+    return OpenDevice(lastPath);
+}
 
-        // 2. 写入数据
-        DWORD bytesWritten = 0;
-        BOOL writeResult = WriteFile(
-            deviceHandle,
-            buffer.Data(),
-            static_cast<DWORD>(buffer.Length()),
-            &bytesWritten,
-            NULL  // 不使用 OVERLAPPED
-        );
+void UsbDevice::LinkThreadProc()
+{
+    typedef std::chrono::steady_clock Clock;
 
-        if (!writeResult)
+    std::unique_lock<std::mutex> lock(linkMutex);
+    for (;;)
+    {
+        linkCv.wait(lock, [this] { return shouldStopLink || linkLost; });
+        if (shouldStopLink)
         {
-            DWORD error = GetLastError();
-            std::cout << "Write operation failed with error: " << error << std::endl;
-            
-            // 通过回调发送错误事件
-            auto errorEvent = new std::pair<EventType, std::string>(
-                EventType::ERR,
-                "Failed to write data: " + std::to_string(error)
-            );
-            
-            tsfn.BlockingCall(errorEvent, [](Napi::Env env, Napi::Function jsCallback, std::pair<EventType, std::string>* event) {
-                Napi::String eventType = Napi::String::New(env, "ERROR");
-                Napi::String message = Napi::String::New(env, event->second);
-                jsCallback.Call({eventType, message});
-                delete event;
-            });
-            
-            Napi::Error::New(env, "Failed to write data: " + std::to_string(error)).ThrowAsJavaScriptException();
-            return env.Null();
+            return;
         }
 
-        std::cout << "Successfully wrote " << bytesWritten << " bytes" << std::endl;
-
-        // 3. 等待设备处理命令
-        Sleep(10);  // 给设备一些处理时间
-
-        // 4. 读取响应
-        const DWORD READ_BUFFER_SIZE = 1024;
-        std::vector<uint8_t> readBuffer(READ_BUFFER_SIZE);
-        std::vector<uint8_t> completeResponse;  // 存储完整的响应数据
-        DWORD bytesRead = 0;
-        bool responseReceived = false;
-        int readAttempts = 0;
-        const int MAX_READ_ATTEMPTS = 3;  // 减少最大尝试次数
-        DWORD startTime = GetTickCount();
-        const DWORD TIMEOUT = 50;  // 减少超时时间到100ms
-
-        while (!responseReceived && readAttempts < MAX_READ_ATTEMPTS && (GetTickCount() - startTime) < TIMEOUT)
-        {
-            readAttempts++;
-            
-            // 使用同步读取
-            BOOL readResult = ReadFile(
-                deviceHandle,
-                readBuffer.data(),
-                READ_BUFFER_SIZE,
-                &bytesRead,
-                NULL  // 不使用 OVERLAPPED
-            );
-
-            if (readResult && bytesRead > 0)
-            {
-                // 将读取到的数据添加到完整响应中
-                completeResponse.insert(completeResponse.end(), readBuffer.begin(), readBuffer.begin() + bytesRead);
-                std::cout << "Received " << bytesRead << " bytes, total: " << completeResponse.size() << " bytes" << std::endl;
-
-                // 检查最后一个字符是否为分号
-                if (!completeResponse.empty() && completeResponse.back() == ';')
-                {
-                    responseReceived = true;
-                    break;
-                }
-            }
-            else
+        // 关闭失效的句柄; 在锁外进行, 读线程可能正在 OnDeviceLost 中等待 linkMutex
+        // 连接信息在 linkMutex 下取快照, JS 线程上的 connect / attach 可能同时修改
+        std::string path = connectedPath;
+        std::string serial = deviceSerial;
+        uint16_t vendorId = currentVendorId;
+        uint16_t productId = currentProductId;
+        linkBusy = true;
+        lock.unlock();
+        CloseDevice();
+        EmitConnection(EventType::DISCONNECTED, path);
+        lock.lock();
+        linkBusy = false;
+        linkCv.notify_all();
+
+        Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(reconnectTimeoutMs);
+        while (linkLost && autoReconnect && !shouldStopLink)
+        {
+            linkArrival = false;
+            linkBusy = true;
+            lock.unlock();
+            bool opened = ReopenDevice(path, vendorId, productId, serial);
+            lock.lock();
+            linkBusy = false;
+
+            if (opened)
             {
-                DWORD error = GetLastError();
-                if (error == ERROR_NO_DATA)
-                {
-                    if (!completeResponse.empty())
-                    {
-                        responseReceived = true;
-                        break;
-                    }
-                }
-                else
-                {
-                    std::cout << "Error while reading response: " << error << std::endl;
-                }
+                LOG_INFO("Device reconnected: %s", connectedPath.c_str());
+                linkLost = false;
+                EmitConnection(EventType::RECONNECTED, connectedPath);
+                break;
             }
 
-            if (!responseReceived)
+            Clock::time_point now = Clock::now();
+            if (now >= deadline)
             {
-                std::cout << "No response received, retrying..." << std::endl;
-                Sleep(5);  // 短暂等待后重试
+                break;
             }
+            linkCv.notify_all();
+            linkCv.wait_until(lock, std::min(deadline, now + std::chrono::milliseconds(reconnectIntervalMs)),
+                              [this] { return shouldStopLink || !linkLost || linkArrival; });
         }
 
-        // 5. 通过回调返回结果
-        if (responseReceived && !completeResponse.empty())
-        {
-            std::cout << "Total response size: " << completeResponse.size() << " bytes" << std::endl;
-            
-            // 创建一个新的缓冲区来存储响应数据
-            auto responseBuffer = new std::vector<uint8_t>(completeResponse);
-            
-            // 通过回调发送数据
-            tsfn.BlockingCall(responseBuffer, [](Napi::Env env, Napi::Function jsCallback, std::vector<uint8_t>* response) {
-                // 创建事件类型字符串
-                Napi::String eventType = Napi::String::New(env, "CMD_RESPONSE");
-                
-                // 创建 Buffer 对象
-                Napi::Buffer<uint8_t> buffer = Napi::Buffer<uint8_t>::Copy(env, response->data(), response->size());
-                
-                // 调用 JavaScript 回调
-                jsCallback.Call({eventType, buffer});
-                
-                // 清理
-                delete response;
-            });
-        }
-        else
+        // 没有开启自动重连, 或在 timeout 内设备没有重新出现
+        if (linkLost && !shouldStopLink)
         {
-            std::cout << "No valid response received after " << MAX_READ_ATTEMPTS << " attempts" << std::endl;
-            // 通过回调发送错误事件
-            auto errorEvent = new std::pair<EventType, std::string>(
-                EventType::ERR,
-                "No valid response received after " + std::to_string(MAX_READ_ATTEMPTS) + " attempts"
-            );
-            
-            tsfn.BlockingCall(errorEvent, [](Napi::Env env, Napi::Function jsCallback, std::pair<EventType, std::string>* event) {
-                Napi::String eventType = Napi::String::New(env, "ERROR");
-                Napi::String message = Napi::String::New(env, event->second);
-                jsCallback.Call({eventType, message});
-                delete event;
-            });
+            linkLost = false;
+            if (autoReconnect)
+            {
+                EmitError("Device not reconnected within " + std::to_string(reconnectTimeoutMs) + " ms");
+            }
         }
+        linkCv.notify_all();
+    }
+}
 
-        return env.Null();
+// 放弃正在进行的自动重连, 等待 linkThread 结束正在进行的打开或关闭 (connect / disconnect 之前调用)
+void UsbDevice::StopReconnect()
+{
+    std::unique_lock<std::mutex> lock(linkMutex);
+    linkLost = false;
+    linkCv.notify_all();
+    linkCv.wait(lock, [this] { return !linkBusy; });
+}
+
+void UsbDevice::StopLinkThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(linkMutex);
+        shouldStopLink = true;
+        linkLost = false;
     }
-    catch (const std::exception& e) {
-        std::cout << "Exception: " << e.what() << std::endl;
-        
-        // 通过回调发送错误事件
-        auto errorEvent = new std::pair<EventType, std::string>(
-            EventType::ERR,
-            std::string("Exception: ") + e.what()
-        );
-        
-        tsfn.BlockingCall(errorEvent, [](Napi::Env env, Napi::Function jsCallback, std::pair<EventType, std::string>* event) {
-            Napi::String eventType = Napi::String::New(env, "ERROR");
-            Napi::String message = Napi::String::New(env, event->second);
-            jsCallback.Call({eventType, message});
-            delete event;
+    linkCv.notify_all();
+
+    if (linkThread.joinable())
+    {
+        linkThread.join();
+    }
+}
+
+// PLT 分块写入失败后: 设备正在重连时等待结果. 只有 since 之后重新打开了设备才返回 true,
+// 其他写入失败 (或没有开启续传) 直接返回 false, 作业照常终止
+bool UsbDevice::WaitForReconnect(PltStreamer &streamer, uint64_t since)
+{
+    std::unique_lock<std::mutex> lock(linkMutex);
+    if (!autoReconnect || !resumeJobs)
+    {
+        return false;
+    }
+    linkCv.wait(lock, [this, &streamer] { return !linkLost || shouldStopLink || streamer.Cancelled(); });
+    return isConnected && connectionId != since && !shouldStopLink && !streamer.Cancelled();
+}
+
+// 作业被取消时唤醒在 WaitForReconnect 中等待的发送线程
+void UsbDevice::WakeReconnectWaiters()
+{
+    std::lock_guard<std::mutex> lock(linkMutex);
+    linkCv.notify_all();
+}
+
+bool UsbDevice::DoSendPlt(const uint8_t *data, size_t length, size_t chunkSize, int timeoutMs, std::vector<uint8_t> &response,
+                          std::string &error)
+{
+    if (!isConnected || !mux->IsRunning())
+    {
+        error = "Device not connected";
+        return false;
+    }
+
+    isOperationInProgress = true;
+
+    // 在命令边界处切块写入, 块与块之间可以插入命令; 最后一块经由 mux 写出并等待设备回执:
+    // 回执没有固定格式, 取写完后收到的第一段数据. 读线程一直在消费设备数据, 不需要先丢弃残留数据.
+    CommandMux::Result result = CommandMux::Result::WRITE_FAILED;
+    BorrowedSource source(data, length, nullptr);
+    PltStreamer streamer(chunkSize);
+    size_t written = 0;
+    streamer.Run(
+        source,
+        [&](const uint8_t *chunk, size_t chunkLength) {
+            written += chunkLength;
+            if (written < length)
+            {
+                return WriteChunk(chunk, chunkLength, error);
+            }
+            result = mux->SubmitAndWait(chunk, chunkLength, timeoutMs, CommandMux::Framing::RAW, response, error,
+                                        WriteScheduler::Priority::BULK);
+            return true;
+        },
+        [](const PltStreamer::Progress &) {},
+        0);
+    isOperationInProgress = false;
+
+    if (result == CommandMux::Result::WRITE_FAILED || result == CommandMux::Result::CLOSED)
+    {
+        LOG_ERROR("%s", error.c_str());
+        return false;
+    }
+
+    LOG_TRACE("Wrote %zu bytes", length);
+    if (result == CommandMux::Result::OK)
+    {
+        LOG_TRACE("Received response of %zu bytes", response.size());
+    }
+    else
+    {
+        LOG_DEBUG("No valid response received within %d ms", timeoutMs);
+        response.clear();
+    }
+    return true;
+}
+
+bool UsbDevice::DoSendCmd(const uint8_t *data, size_t length, int timeoutMs, std::vector<uint8_t> &response, std::string &error)
+{
+    if (!isConnected || !mux->IsRunning())
+    {
+        error = "Device not connected";
+        return false;
+    }
+
+    isOperationInProgress = true;
+
+    // 写入命令并等待以分号结尾的响应
+    CommandMux::Result result = mux->SubmitAndWait(data, length, timeoutMs, CommandFraming(), response, error);
+    isOperationInProgress = false;
+
+    if (result == CommandMux::Result::WRITE_FAILED || result == CommandMux::Result::CLOSED)
+    {
+        LOG_ERROR("%s", error.c_str());
+        return false;
+    }
+
+    LOG_TRACE("Wrote %zu bytes", length);
+    if (result == CommandMux::Result::OK)
+    {
+        LOG_TRACE("Received response of %zu bytes", response.size());
+    }
+    else
+    {
+        LOG_WARN("No valid response received within %d ms", timeoutMs);
+        response.clear();
+    }
+    return true;
+}
+
+template <typename Fill>
+bool UsbDevice::PushEvent(Fill fill)
+{
+    if (!events->queue.Push(fill))
+    {
+        events->dropped++;
+        return false;
+    }
+    ScheduleDrain();
+    return true;
+}
+
+void UsbDevice::ScheduleDrain()
+{
+    // 已有投递在等待时不再重复发起, 新事件会在那一次中一起送出
+    if (!tsfn || events->scheduled.exchange(true))
+    {
+        return;
+    }
+
+    std::shared_ptr<EventChannel> channel = events;
+    napi_status status = tsfn.NonBlockingCall([channel](Napi::Env env, Napi::Function jsCallback) {
+        DrainEvents(env, jsCallback, *channel);
+    });
+    if (status != napi_ok)
+    {
+        channel->scheduled = false;
+    }
+}
+
+void UsbDevice::EmitError(const std::string &message)
+{
+    if (!tsfn)
+    {
+        return;
+    }
+
+    PushEvent([&](UsbEvent &event) {
+        event.type = EventType::ERR;
+        event.message.assign(message);
+    });
+}
+
+void UsbDevice::EmitCmdResponse(std::vector<uint8_t> *response)
+{
+    // 响应缓冲区的所有权随事件转交给 JS; 无法投递时归还到池中
+    if (!tsfn || !PushEvent([&](UsbEvent &event) {
+            event.type = EventType::CMD_RESPONSE;
+            event.data = response;
+        }))
+    {
+        BufferPool::Shared().Release(response);
+    }
+}
+
+void UsbDevice::RunOnJsThread(std::function<void(Napi::Env)> task)
+{
+    if (!jsTasks)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jsTaskQueue->mutex);
+        jsTaskQueue->tasks.push_back(std::move(task));
+    }
+
+    // 不带调用数据的 BlockingCall 直接调用 jsTasks 的回调, 由它取出任务执行.
+    // 失败 (tsfn 正在关闭) 时任务留在队列里: 仍在排队的调用会顺带执行它, 否则由 finalizer 释放.
+    jsTasks.BlockingCall();
+}
+
+void UsbDevice::HoldLoop(Napi::Env env)
+{
+    if (loopHolds++ == 0 && jsTasks)
+    {
+        jsTasks.Ref(env);
+        Ref();
+    }
+}
+
+void UsbDevice::ReleaseLoop(Napi::Env env)
+{
+    if (loopHolds > 0 && --loopHolds == 0 && jsTasks)
+    {
+        jsTasks.Unref(env);
+        Unref();
+    }
+}
+
+void UsbDevice::EmitProgress(const PltStreamer::Progress &progress)
+{
+    if (!tsfn)
+    {
+        return;
+    }
+
+    // 作业结束的进度一定送达; 进行中的进度只保留最新一次
+    if (progress.done)
+    {
+        events->progressPending = false;
+        PushEvent([&](UsbEvent &event) {
+            event.type = EventType::PROGRESS;
+            event.progress = progress;
         });
+        return;
+    }
+
+    events->progress.Store(progress);
+    if (events->progressPending.exchange(true))
+    {
+        events->coalesced++;
+        return;
+    }
+    ScheduleDrain();
+}
+
+namespace {
+
+Napi::Object ProgressToJs(Napi::Env env, const PltStreamer::Progress &progress)
+{
+    Napi::Object data = Napi::Object::New(env);
+    data.Set("bytesSent", Napi::Number::New(env, static_cast<double>(progress.bytesSent)));
+    data.Set("totalBytes", Napi::Number::New(env, static_cast<double>(progress.totalBytes)));
+    data.Set("progress", Napi::Number::New(env, progress.totalBytes > 0
+        ? static_cast<double>(progress.bytesSent) / progress.totalBytes : 1.0));
+    data.Set("bytesPerSecond", Napi::Number::New(env, progress.bytesPerSecond));
+    data.Set("done", Napi::Boolean::New(env, progress.done));
+    return data;
+}
+
+Napi::Object HotplugToJs(Napi::Env env, const HotplugChange &change)
+{
+    char vid[5] = "";
+    char pid[5] = "";
+    if (change.hasIds)
+    {
+        FormatHex4(change.vendorId, vid);
+        FormatHex4(change.productId, pid);
+    }
+
+    Napi::Object data = Napi::Object::New(env);
+    data.Set("vid", Napi::String::New(env, change.hasIds ? vid : "Unknown"));
+    data.Set("pid", Napi::String::New(env, change.hasIds ? pid : "Unknown"));
+    data.Set("action", Napi::String::New(env, change.arrival ? "Arrival" : "Remove"));
+    data.Set("path", Napi::String::New(env, change.path));
+    return data;
+}
+
+const char *EventTypeName(EventType type)
+{
+    switch (type)
+    {
+    case EventType::HOTPLUG:
+        return "HOTPLUG";
+    case EventType::CMD_RESPONSE:
+        return "CMD_RESPONSE";
+    case EventType::ERR:
+        return "ERROR";
+    case EventType::PROGRESS:
+        return "PROGRESS";
+    case EventType::DISCONNECTED:
+        return "DISCONNECTED";
+    case EventType::RECONNECTED:
+        return "RECONNECTED";
+    }
+    return "UNKNOWN";
+}
+
+} // namespace
+
+void UsbDevice::DrainEvents(Napi::Env env, Napi::Function jsCallback, EventChannel &channel)
+{
+    // 先清除标记再取事件: 取的过程中新到的事件会安排下一次投递, 不会丢失
+    channel.scheduled = false;
+
+    bool batch = channel.batch;
+    Napi::Array batchEvents;
+    uint32_t count = 0;
+    if (batch)
+    {
+        batchEvents = Napi::Array::New(env);
+    }
+
+    auto deliver = [&](const char *type, Napi::Value data) {
+        Napi::String eventType = Napi::String::New(env, type);
+        if (batch)
+        {
+            Napi::Object event = Napi::Object::New(env);
+            event.Set("type", eventType);
+            event.Set("data", data);
+            batchEvents.Set(count, event);
+        }
+        else
+        {
+            jsCallback.Call({eventType, data});
+        }
+        count++;
+    };
+
+    if (channel.progressPending.exchange(false))
+    {
+        deliver("PROGRESS", ProgressToJs(env, channel.progress.Load()));
+    }
+
+    // 最多取一轮容量, 回调中再产生的事件留到下一次投递
+    channel.queue.Drain([&](UsbEvent &event) {
+        const char *type = EventTypeName(event.type);
+        switch (event.type)
+        {
+        case EventType::HOTPLUG:
+            deliver(type, HotplugToJs(env, event.hotplug));
+            break;
+        case EventType::CMD_RESPONSE:
+            deliver(type, ToJsBuffer(env, event.data));
+            event.data = nullptr;
+            break;
+        case EventType::ERR:
+            deliver(type, Napi::String::New(env, event.message));
+            break;
+        case EventType::PROGRESS:
+            deliver(type, ProgressToJs(env, event.progress));
+            break;
+        case EventType::DISCONNECTED:
+        case EventType::RECONNECTED:
+        {
+            Napi::Object data = Napi::Object::New(env);
+            data.Set("path", Napi::String::New(env, event.message));
+            deliver(type, data);
+            break;
+        }
+        }
+    }, channel.queue.Capacity());
+
+    if (batch && count > 0)
+    {
+        jsCallback.Call({batchEvents});
+    }
+
+    channel.delivered += count;
+    channel.batches++;
+}
+
+Napi::Value UsbDevice::GetEventStats(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("delivered", Napi::Number::New(env, static_cast<double>(events->delivered.load())));
+    stats.Set("dropped", Napi::Number::New(env, static_cast<double>(events->dropped.load())));
+    stats.Set("coalesced", Napi::Number::New(env, static_cast<double>(events->coalesced.load())));
+    stats.Set("batches", Napi::Number::New(env, static_cast<double>(events->batches.load())));
+    stats.Set("capacity", Napi::Number::New(env, static_cast<double>(events->queue.Capacity())));
+    return stats;
+}
+
+namespace {
+
+Napi::Object HistogramToJs(Napi::Env env, const LatencyHistogram &histogram)
+{
+    LatencyHistogram::Snapshot snapshot = histogram.Read();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("count", Napi::Number::New(env, static_cast<double>(snapshot.count)));
+    result.Set("min", Napi::Number::New(env, static_cast<double>(snapshot.min)));
+    result.Set("mean", Napi::Number::New(env, snapshot.mean));
+    result.Set("p50", Napi::Number::New(env, static_cast<double>(snapshot.p50)));
+    result.Set("p90", Napi::Number::New(env, static_cast<double>(snapshot.p90)));
+    result.Set("p99", Napi::Number::New(env, static_cast<double>(snapshot.p99)));
+    result.Set("p999", Napi::Number::New(env, static_cast<double>(snapshot.p999)));
+    result.Set("max", Napi::Number::New(env, static_cast<double>(snapshot.max)));
+    return result;
+}
+
+} // namespace
+
+// getStats() -> { write, firstByte, roundTrip, bytesOut, bytesIn, retries, timeouts, errors,
+//               pauses, pausedMs, stalls, drainRate, preemptions, elapsedMs }
+// 延迟单位为微秒
+Napi::Value UsbDevice::GetStats(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    double elapsedMs = static_cast<double>(IoStats::NowUs() - stats.resetAtUs.load()) / 1000.0;
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("write", HistogramToJs(env, stats.write));
+    result.Set("firstByte", HistogramToJs(env, stats.firstByte));
+    result.Set("roundTrip", HistogramToJs(env, stats.roundTrip));
+    result.Set("bytesOut", Napi::Number::New(env, static_cast<double>(stats.bytesOut.load())));
+    result.Set("bytesIn", Napi::Number::New(env, static_cast<double>(stats.bytesIn.load())));
+    result.Set("retries", Napi::Number::New(env, static_cast<double>(transport->WriteRetries() - retriesAtReset)));
+    result.Set("timeouts", Napi::Number::New(env, static_cast<double>(stats.timeouts.load())));
+    result.Set("errors", Napi::Number::New(env, static_cast<double>(stats.errors.load())));
+    result.Set("pauses", Napi::Number::New(env, static_cast<double>(stats.pauses.load())));
+    result.Set("pausedMs", Napi::Number::New(env, static_cast<double>(stats.pausedUs.load()) / 1000.0));
+    result.Set("stalls", Napi::Number::New(env, static_cast<double>(stats.stalls.load())));
+    result.Set("drainRate", Napi::Number::New(env, stats.drainRate.load()));
+    result.Set("preemptions", Napi::Number::New(env, static_cast<double>(scheduler.Preemptions() - preemptionsAtReset)));
+    result.Set("elapsedMs", Napi::Number::New(env, elapsedMs));
+    return result;
+}
+
+Napi::Value UsbDevice::ResetStats(const Napi::CallbackInfo &info)
+{
+    stats.Reset();
+    retriesAtReset = transport->WriteRetries();
+    preemptionsAtReset = scheduler.Preemptions();
+    return info.Env().Undefined();
+}
+
+// startCapture(path, { size }): 把之后的每次读写记录到跟踪文件 (环形, 默认 64MB, 写满后覆盖最旧的记录)
+Napi::Value UsbDevice::StartCapture(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        Napi::TypeError::New(env, "Expected trace file path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    size_t capacity = DEFAULT_TRACE_SIZE;
+    if (info.Length() >= 2 && info[1].IsObject())
+    {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (options.Has("size"))
+        {
+            double size = options.Get("size").ToNumber().DoubleValue();
+            if (size <= 0)
+            {
+                Napi::RangeError::New(env, "size must be positive").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+            capacity = static_cast<size_t>(size);
+        }
+    }
+
+    auto writer = std::make_shared<TraceWriter>();
+    std::string error;
+    if (!writer->Open(info[0].As<Napi::String>().Utf8Value(), capacity, error))
+    {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // 替换正在进行的记录; 旧文件在最后一个使用者释放后关闭
+    transport->StartCapture(writer);
+    return Napi::Boolean::New(env, true);
+}
+
+// stopCapture() -> 记录的条数 (没有在记录时为 0)
+Napi::Value UsbDevice::StopCapture(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    std::shared_ptr<TraceWriter> writer = transport->StopCapture();
+    uint64_t records = 0;
+    if (writer)
+    {
+        records = writer->Records();
+        writer->Close();
+    }
+    return Napi::Number::New(env, static_cast<double>(records));
+}
+
+// setTimeouts({ command, plt }) -> 修改后的 { command, plt }
+// 本设备的默认超时 (毫秒), 只修改传入的字段; 不带参数时只返回当前值
+Napi::Value UsbDevice::SetTimeouts(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() >= 1 && info[0].IsObject())
+    {
+        Napi::Object options = info[0].As<Napi::Object>();
+        int command = cmdTimeoutMs;
+        int plt = pltTimeoutMs;
+        const char *names[] = {"command", "plt"};
+        int *values[] = {&command, &plt};
+        for (int i = 0; i < 2; i++)
+        {
+            if (!options.Has(names[i]))
+            {
+                continue;
+            }
+            Napi::Value value = options.Get(names[i]);
+            if (!value.IsNumber() || value.As<Napi::Number>().Int32Value() <= 0)
+            {
+                Napi::RangeError::New(env, std::string(names[i]) + " must be a positive number").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+            *values[i] = value.As<Napi::Number>().Int32Value();
+        }
+        cmdTimeoutMs = command;
+        pltTimeoutMs = plt;
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("command", Napi::Number::New(env, cmdTimeoutMs.load()));
+    result.Set("plt", Napi::Number::New(env, pltTimeoutMs.load()));
+    return result;
+}
+
+// setFlowControl({ bufferSize, highWatermark, lowWatermark, drainRate, statusCommand, statusInterval }) -> true
+// setFlowControl(null) 关闭流控; 从下一个 PLT 作业开始生效
+Napi::Value UsbDevice::SetFlowControl(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    FlowProfile profile;
+    if (info.Length() >= 1 && info[0].IsObject())
+    {
+        std::string error;
+        if (!ReadFlowProfile(info[0].As<Napi::Object>(), profile, error))
+        {
+            Napi::RangeError::New(env, error).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+    else if (info.Length() >= 1 && !info[0].IsNull() && !info[0].IsUndefined())
+    {
+        Napi::TypeError::New(env, "Expected options object or null").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::lock_guard<std::mutex> lock(sendQueueMutex);
+    flowProfile = profile;
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value UsbDevice::SendPlt(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (!isConnected || !transport->IsOpen())
+    {
+        Napi::Error::New(env, "Device not connected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (info.Length() < 1 || !info[0].IsBuffer())
+    {
+        Napi::TypeError::New(env, "Expected buffer as argument").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
+    if (buffer.Length() == 0)
+    {
+        Napi::Error::New(env, "Empty buffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // 可选参数: { timeout, chunkSize } 本次等待回执的超时 (毫秒) 和分块大小 (默认取型号配置)
+    int timeoutMs = pltTimeoutMs;
+    PltJob job;
+    if (!ReadTimeoutOption(info, 1, timeoutMs) || !ReadPltJobOptions(info, 1, activeProfile.chunkSize, job))
+    {
+        return env.Null();
+    }
+
+    std::vector<uint8_t> *response = BufferPool::Shared().Acquire(READ_BUFFER_SIZE);
+    std::string error;
+    if (!DoSendPlt(buffer.Data(), buffer.Length(), job.chunkSize, timeoutMs, *response, error))
+    {
+        BufferPool::Shared().Release(response);
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (response->empty())
+    {
+        BufferPool::Shared().Release(response);
+        return env.Null();
+    }
+    return ToJsBuffer(env, response);
+}
+
+Napi::Value UsbDevice::SendCmd(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    try {
+        if (!isConnected || !transport->IsOpen())
+        {
+            Napi::Error::New(env, "Device not connected").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        if (info.Length() < 1 || !info[0].IsBuffer())
+        {
+            Napi::TypeError::New(env, "Expected buffer as argument").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
+        if (buffer.Length() == 0)
+        {
+            Napi::Error::New(env, "Empty buffer").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        // 可选参数: { timeout } 本次等待响应的超时 (毫秒)
+        int timeoutMs = cmdTimeoutMs;
+        if (!ReadTimeoutOption(info, 1, timeoutMs))
+        {
+            return env.Null();
+        }
+
+        std::vector<uint8_t> *response = BufferPool::Shared().Acquire(READ_BUFFER_SIZE);
+        std::string error;
+        if (!DoSendCmd(buffer.Data(), buffer.Length(), timeoutMs, *response, error))
+        {
+            BufferPool::Shared().Release(response);
+            // 通过回调发送错误事件
+            EmitError(error);
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        // 通过回调返回结果
+        if (!response->empty())
+        {
+            EmitCmdResponse(response);
+        }
+        else
+        {
+            BufferPool::Shared().Release(response);
+            EmitError("No valid response received within " + std::to_string(timeoutMs) + " ms");
+        }
+
+        return env.Null();
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR("Exception: %s", e.what());
         
+        // 通过回调发送错误事件
+        EmitError(std::string("Exception: ") + e.what());
+        return env.Null();
+    }
+}
+
+// 在 libuv 线程池中执行 sendPlt 的阻塞 I/O, 完成后在 JS 线程 resolve Promise
+// 输入 Buffer 通过引用固定, 不复制; 响应缓冲区来自 BufferPool, 直接交给 JS
+class SendWorker : public Napi::AsyncWorker
+{
+public:
+    SendWorker(Napi::Env env, UsbDevice *device, Napi::Object owner, Napi::Buffer<uint8_t> buffer, size_t chunkSize,
+               int timeoutMs)
+        : Napi::AsyncWorker(env, "UsbDeviceSend"),
+          deferred(Napi::Promise::Deferred::New(env)),
+          device(device),
+          data(buffer.Data()),
+          length(buffer.Length()),
+          chunkSize(chunkSize),
+          timeoutMs(timeoutMs),
+          response(BufferPool::Shared().Acquire(READ_BUFFER_SIZE))
+    {
+        // 保持 JS 对象存活, 防止 I/O 进行中 UsbDevice 或输入 Buffer 被回收
+        deviceRef = Napi::Persistent(owner);
+        bufferRef = Napi::Persistent(static_cast<Napi::Object>(buffer));
+    }
+
+    ~SendWorker()
+    {
+        BufferPool::Shared().Release(response);
+    }
+
+    Napi::Promise Promise() const
+    {
+        return deferred.Promise();
+    }
+
+protected:
+    void Execute() override
+    {
+        std::string error;
+        if (!device->DoSendPlt(data, length, chunkSize, timeoutMs, *response, error))
+        {
+            SetError(error);
+        }
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = Env();
+        if (response->empty())
+        {
+            deferred.Resolve(env.Null());
+            return;
+        }
+
+        // 所有权转交给 JS Buffer
+        std::vector<uint8_t> *storage = response;
+        response = nullptr;
+        deferred.Resolve(ToJsBuffer(env, storage));
+    }
+
+    void OnError(const Napi::Error &e) override
+    {
+        deferred.Reject(e.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    Napi::ObjectReference deviceRef;
+    Napi::ObjectReference bufferRef;
+    UsbDevice *device;
+    const uint8_t *data;
+    size_t length;
+    size_t chunkSize;
+    int timeoutMs;
+    std::vector<uint8_t> *response;
+};
+
+// 在 libuv 线程池中把命令写入 CommandMux 后立即结束, 不等待响应;
+// Promise 由多路复用器匹配到响应 (或超时) 时在 JS 线程上完成, 因此多条命令可以同时在途.
+// 调用方在创建前 HoldLoop, 完成时 ReleaseLoop
+class CommandWorker : public Napi::AsyncWorker
+{
+public:
+    CommandWorker(Napi::Env env, UsbDevice *device, Napi::Object owner, Napi::Buffer<uint8_t> buffer, int timeoutMs)
+        : Napi::AsyncWorker(env, "UsbDeviceCommand"),
+          deferred(Napi::Promise::Deferred::New(env)),
+          device(device),
+          data(buffer.Data()),
+          length(buffer.Length()),
+          timeoutMs(timeoutMs)
+    {
+        deviceRef = Napi::Persistent(owner);
+        bufferRef = Napi::Persistent(static_cast<Napi::Object>(buffer));
+    }
+
+    Napi::Promise Promise() const
+    {
+        return deferred.Promise();
+    }
+
+protected:
+    void Execute() override
+    {
+        UsbDevice *target = device;
+        Napi::Promise::Deferred pending = deferred;
+
+        device->mux->Submit(data, length, timeoutMs, device->CommandFraming(),
+            [target, pending](CommandMux::Result result, std::vector<uint8_t> *response, const std::string &error) {
+                target->RunOnJsThread([target, pending, result, response, error](Napi::Env env) {
+                    if (result == CommandMux::Result::OK)
+                    {
+                        pending.Resolve(ToJsBuffer(env, response));
+                    }
+                    else
+                    {
+                        pending.Reject(Napi::Error::New(env, error).Value());
+                    }
+                    target->ReleaseLoop(env);
+                });
+            });
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    Napi::ObjectReference deviceRef;
+    Napi::ObjectReference bufferRef;
+    UsbDevice *device;
+    const uint8_t *data;
+    size_t length;
+    int timeoutMs;
+};
+
+Napi::Value UsbDevice::SendAsync(const Napi::CallbackInfo &info, bool isPlt)
+{
+    Napi::Env env = info.Env();
+
+    if (!isConnected || !transport->IsOpen())
+    {
+        Napi::Error::New(env, "Device not connected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (info.Length() < 1 || !info[0].IsBuffer())
+    {
+        Napi::TypeError::New(env, "Expected buffer as argument").ThrowAsJavaScriptException();
         return env.Null();
     }
+
+    Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
+    if (buffer.Length() == 0)
+    {
+        Napi::Error::New(env, "Empty buffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // 可选参数: { timeout } 每次调用自己的超时 (毫秒), 默认取 setTimeouts() 设置的值;
+    // sendPltAsync 还接受 { chunkSize }, 默认取型号配置
+    int timeoutMs = isPlt ? pltTimeoutMs.load() : cmdTimeoutMs.load();
+    PltJob job;
+    if (!ReadTimeoutOption(info, 1, timeoutMs) || (isPlt && !ReadPltJobOptions(info, 1, activeProfile.chunkSize, job)))
+    {
+        return env.Null();
+    }
+
+    Napi::Object owner = info.This().As<Napi::Object>();
+    if (isPlt)
+    {
+        auto worker = new SendWorker(env, this, owner, buffer, job.chunkSize, timeoutMs);
+        Napi::Promise promise = worker->Promise();
+        worker->Queue();
+        return promise;
+    }
+
+    // worker 写完就结束, 之后到 Promise 完成之间由 HoldLoop 保持事件循环和对象存活
+    HoldLoop(env);
+    auto worker = new CommandWorker(env, this, owner, buffer, timeoutMs);
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();
+    return promise;
+}
+
+Napi::Value UsbDevice::SendPltAsync(const Napi::CallbackInfo &info)
+{
+    return SendAsync(info, true);
+}
+
+Napi::Value UsbDevice::SendCmdAsync(const Napi::CallbackInfo &info)
+{
+    return SendAsync(info, false);
+}
+
+// pausePlt(): 后台 PLT 作业在下一个块边界处暂停, 命令仍可照常发送; 暂停期间排队的作业也不会开始
+Napi::Value UsbDevice::PausePlt(const Napi::CallbackInfo &info)
+{
+    std::lock_guard<std::mutex> lock(sendQueueMutex);
+    sendPaused = true;
+    return Napi::Boolean::New(info.Env(), activeStreamer != nullptr);
+}
+
+Napi::Value UsbDevice::ResumePlt(const Napi::CallbackInfo &info)
+{
+    {
+        std::lock_guard<std::mutex> lock(sendQueueMutex);
+        sendPaused = false;
+    }
+    sendQueueCv.notify_one();
+    return info.Env().Undefined();
+}
+
+// cancelPlt() -> 被取消的作业数 (正在发送的与排队中的)
+Napi::Value UsbDevice::CancelPlt(const Napi::CallbackInfo &info)
+{
+    return Napi::Number::New(info.Env(), static_cast<double>(CancelPltJobs()));
 }
 
 Napi::Value UsbDevice::GetSendProgress(const Napi::CallbackInfo &info)
@@ -521,70 +1626,42 @@ Napi::Value UsbDevice::GetSendProgress(const Napi::CallbackInfo &info)
     return Napi::Number::New(env, sendProgress);
 }
 
+#ifdef _WIN32
 LRESULT CALLBACK UsbDevice::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
     if (uMsg == WM_DEVICECHANGE)
     {
-        auto device = reinterpret_cast<UsbDevice *>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
-        if (device && device->tsfn)
+        // 保持设备索引为最新: 到达时下次查找重新扫描, 移除时直接删除
+        if (wParam == DBT_DEVICEARRIVAL || wParam == DBT_DEVICEREMOVECOMPLETE)
         {
-            const char *eventType = nullptr;
-            if (wParam == DBT_DEVICEARRIVAL)
+            auto header = reinterpret_cast<DEV_BROADCAST_HDR *>(lParam);
+            if (header && header->dbch_devicetype == DBT_DEVTYP_DEVICEINTERFACE)
             {
-                eventType = "HOTPLUG";
-            }
-            else if (wParam == DBT_DEVICEREMOVECOMPLETE)
-            {
-                eventType = "HOTPLUG";
+                auto devInterface = reinterpret_cast<DEV_BROADCAST_DEVICEINTERFACE_A *>(lParam);
+                if (wParam == DBT_DEVICEARRIVAL)
+                {
+                    DeviceIndex::Shared().Invalidate();
+                }
+                else
+                {
+                    DeviceIndex::Shared().Remove(devInterface->dbcc_name);
+                }
             }
+        }
 
-            if (eventType)
+        auto device = reinterpret_cast<UsbDevice *>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+        if (device)
+        {
+            if (wParam == DBT_DEVICEARRIVAL || wParam == DBT_DEVICEREMOVECOMPLETE)
             {
                 DEV_BROADCAST_DEVICEINTERFACE_A *devInterface = (DEV_BROADCAST_DEVICEINTERFACE_A *)lParam;
-                std::string devicePath = devInterface->dbcc_name;
-
-                // 使用正则表达式提取VID和PID
-                std::regex vidPidRegex("VID_([0-9A-Fa-f]{4})&PID_([0-9A-Fa-f]{4})");
-                std::smatch match;
-                std::string vid = "Unknown";
-                std::string pid = "Unknown";
-
-                if (std::regex_search(devicePath, match, vidPidRegex) && match.size() == 3)
-                {
-                    vid = match.str(1);
-                    pid = match.str(2);
-                }
 
-                // 创建一个结构来传递事件信息
-                struct HotplugEvent
-                {
-                    std::string type;
-                    std::string vid;
-                    std::string pid;
-                    std::string action;  // "Arrival" 或 "Remove"
-                };
-
-                auto event = new HotplugEvent{
-                    eventType,
-                    vid,
-                    pid,
-                    (wParam == DBT_DEVICEARRIVAL) ? "Arrival" : "Remove"
-                };
-
-                device->tsfn.BlockingCall(event, [](Napi::Env env, Napi::Function jsCallback, HotplugEvent *event)
-                                          {
-                    // 创建参数
-                    Napi::String jsEventType = Napi::String::New(env, event->type);
-                    Napi::Object jsData = Napi::Object::New(env);
-                    jsData.Set("vid", Napi::String::New(env, event->vid));
-                    jsData.Set("pid", Napi::String::New(env, event->pid));
-                    jsData.Set("action", Napi::String::New(env, event->action));
-
-                    // 调用JavaScript回调
-                    jsCallback.Call({jsEventType, jsData});
-
-                    // 清理
-                    delete event; });
+                // 直接扫描 "VID_xxxx&PID_xxxx", 不再每个事件构造 std::regex
+                HotplugChange change;
+                change.arrival = wParam == DBT_DEVICEARRIVAL;
+                change.hasIds = ParseVidPid(devInterface->dbcc_name, change.vendorId, change.productId);
+                CopyPath(change.path, devInterface->dbcc_name, strlen(devInterface->dbcc_name));
+                device->OnHotplug(change);
             }
         }
     }
@@ -611,6 +1688,10 @@ void UsbDevice::NotificationThreadProc()
 
     deviceNotificationHandle = RegisterDeviceNotification(hwnd,
                                                           &notificationFilter, DEVICE_NOTIFY_WINDOW_HANDLE);
+    if (deviceNotificationHandle)
+    {
+        DeviceIndex::Shared().BeginWatching();
+    }
 
     MSG msg;
     while (!shouldStopNotification && GetMessage(&msg, nullptr, 0, 0))
@@ -623,11 +1704,49 @@ void UsbDevice::NotificationThreadProc()
     {
         UnregisterDeviceNotification(deviceNotificationHandle);
         deviceNotificationHandle = nullptr;
+        DeviceIndex::Shared().EndWatching();
     }
 
     DestroyWindow(hwnd);
     UnregisterClassA("UsbNotificationClass", nullptr);
 }
+#else
+void UsbDevice::NotificationThreadProc()
+{
+#ifdef __linux__
+    // 监听期间设备索引由 uevent 保持为最新
+    DeviceIndex::Shared().BeginWatching();
+    ueventMonitor->Run([this](const HotplugChange &change) { OnHotplug(change); });
+    DeviceIndex::Shared().EndWatching();
+#endif
+}
+#endif
+
+void UsbDevice::EmitHotplug(const HotplugChange &change)
+{
+    if (!tsfn)
+    {
+        return;
+    }
+
+    PushEvent([&](UsbEvent &event) {
+        event.type = EventType::HOTPLUG;
+        event.hotplug = change;
+    });
+}
+
+void UsbDevice::EmitConnection(EventType type, const std::string &path)
+{
+    if (!tsfn)
+    {
+        return;
+    }
+
+    PushEvent([&](UsbEvent &event) {
+        event.type = type;
+        event.message.assign(path);
+    });
+}
 
 Napi::Value UsbDevice::StartHotplugMonitor(const Napi::CallbackInfo &info)
 {
@@ -640,6 +1759,33 @@ Napi::Value UsbDevice::StartHotplugMonitor(const Napi::CallbackInfo &info)
         return env.Null();
     }
 
+#ifdef __linux__
+    // 重新开始监听; 可选参数 { ueventReplay } 从录制的 uevent 文件回放, 代替 netlink 套接字 (测试用)
+    if (notificationThread.joinable())
+    {
+        ueventMonitor->Stop();
+        notificationThread.join();
+    }
+
+    std::string error;
+    ueventMonitor.reset(new UeventMonitor());
+    bool opened;
+    if (info.Length() >= 2 && info[1].IsObject() && info[1].As<Napi::Object>().Has("ueventReplay"))
+    {
+        std::string replayPath = info[1].As<Napi::Object>().Get("ueventReplay").As<Napi::String>().Utf8Value();
+        opened = ueventMonitor->OpenReplay(replayPath, error);
+    }
+    else
+    {
+        opened = ueventMonitor->OpenNetlink(error);
+    }
+    if (!opened)
+    {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+#endif
+
     tsfn = Napi::ThreadSafeFunction::New(
         env,
         info[0].As<Napi::Function>(),
@@ -647,8 +1793,17 @@ Napi::Value UsbDevice::StartHotplugMonitor(const Napi::CallbackInfo &info)
         0,
         1);
 
+    // 可选参数: { batch } 为 true 时每个 JS 回合调用一次 callback(events), events 为 [{ type, data }]
+    events->batch = info.Length() >= 2 && info[1].IsObject() &&
+                    info[1].As<Napi::Object>().Get("batch").ToBoolean().Value();
+
     shouldStopNotification = false;
-    notificationThread = std::thread(&UsbDevice::NotificationThreadProc, this);
+#if defined(_WIN32) || defined(__linux__)
+    if (!notificationThread.joinable())
+    {
+        notificationThread = std::thread(&UsbDevice::NotificationThreadProc, this);
+    }
+#endif
 
     return Napi::Boolean::New(env, true);
 }
@@ -667,6 +1822,9 @@ Napi::Value UsbDevice::StopHotplugMonitor(const Napi::CallbackInfo &info)
 
         // 安全地停止线程
         shouldStopNotification = true;
+#ifdef __linux__
+        ueventMonitor->Stop();
+#endif
 
         // 等待线程结束
         if (notificationThread.joinable())
@@ -674,12 +1832,14 @@ Napi::Value UsbDevice::StopHotplugMonitor(const Napi::CallbackInfo &info)
             notificationThread.join();
         }
 
+#ifdef _WIN32
         // 清理通知句柄
         if (deviceNotificationHandle)
         {
             UnregisterDeviceNotification(deviceNotificationHandle);
             deviceNotificationHandle = nullptr;
         }
+#endif
 
         return Napi::Boolean::New(env, true);
     }
@@ -690,14 +1850,451 @@ Napi::Value UsbDevice::StopHotplugMonitor(const Napi::CallbackInfo &info)
     }
 }
 
+Napi::Value UsbDevice::StartPlt(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (!isConnected || !transport->IsOpen())
+    {
+        Napi::Error::New(env, "Device not connected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (info.Length() < 1 || !info[0].IsBuffer())
+    {
+        Napi::TypeError::New(env, "Expected buffer as argument").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
+    if (buffer.Length() == 0)
+    {
+        Napi::Error::New(env, "Empty buffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    PltJob job;
+    if (!ReadPltJobOptions(info, 1, activeProfile.chunkSize, job))
+    {
+        return env.Null();
+    }
+
+    // 固定 JS Buffer 直接作为数据源, 作业结束后回到 JS 线程释放引用
+    auto bufferRef = new Napi::ObjectReference(Napi::Persistent(static_cast<Napi::Object>(buffer)));
+    job.source.reset(new BorrowedSource(buffer.Data(), buffer.Length(), [this, bufferRef]() {
+        RunOnJsThread([bufferRef](Napi::Env) { delete bufferRef; });
+    }));
+    EnqueuePltJob(std::move(job));
+
+    return Napi::Boolean::New(env, true);
+}
+
+// sendPltFile(path, { chunkSize, progressInterval }) -> true
+// 与 startPlt 相同, 但作业直接从文件映射发送, 不读入 JS; 文件在作业结束后关闭
+Napi::Value UsbDevice::SendPltFile(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (!isConnected || !transport->IsOpen())
+    {
+        Napi::Error::New(env, "Device not connected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        Napi::TypeError::New(env, "Expected file path as argument").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    PltJob job;
+    if (!ReadPltJobOptions(info, 1, activeProfile.chunkSize, job))
+    {
+        return env.Null();
+    }
+
+    // 在 JS 线程上打开, 文件不存在等错误直接抛出
+    std::unique_ptr<MappedFileSource> source(new MappedFileSource());
+    std::string error;
+    if (!source->Open(info[0].As<Napi::String>().Utf8Value(), error))
+    {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (source->Size() == 0)
+    {
+        Napi::Error::New(env, "Empty file").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    job.source = std::move(source);
+    EnqueuePltJob(std::move(job));
+
+    return Napi::Boolean::New(env, true);
+}
+
+// sendCached(key, { chunkSize, progressInterval }) -> boolean
+// 发送作业缓存中的一项 (cacheJob 写入的准备好的作业), 与 sendPltFile 相同直接从映射发送;
+// 键不在缓存中时返回 false, 由调用方准备作业后 cacheJob 再发送
+Napi::Value UsbDevice::SendCached(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (!isConnected || !transport->IsOpen())
+    {
+        Napi::Error::New(env, "Device not connected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        Napi::TypeError::New(env, "Expected cache key as argument").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    PltJob job;
+    if (!ReadPltJobOptions(info, 1, activeProfile.chunkSize, job))
+    {
+        return env.Null();
+    }
+
+    // 作业结束 (数据源析构) 之前该项不会被淘汰
+    job.source = JobCache::Shared().Open(info[0].As<Napi::String>().Utf8Value());
+    if (!job.source)
+    {
+        return Napi::Boolean::New(env, false);
+    }
+    EnqueuePltJob(std::move(job));
+
+    return Napi::Boolean::New(env, true);
+}
+
+void UsbDevice::EnqueuePltJob(PltJob job)
+{
+    // 后台作业完成前保持事件循环存活: 作业在发送线程或 JS 线程上析构时, 回到 JS 线程解除
+    HoldLoop(Env());
+    job.loopHold.reset(new ScopeRelease([this]() {
+        RunOnJsThread([this](Napi::Env env) { ReleaseLoop(env); });
+    }));
+
+    std::lock_guard<std::mutex> lock(sendQueueMutex);
+    sendQueue.push(std::move(job));
+
+    // 发送线程在第一次需要时启动
+    if (!sendThread.joinable())
+    {
+        shouldStopSend = false;
+        sendThread = std::thread(&UsbDevice::ProcessSendQueue, this);
+    }
+    sendQueueCv.notify_one();
+}
+
+// 清空发送队列并取消正在发送的作业, 返回被取消的作业数
+size_t UsbDevice::CancelPltJobs()
+{
+    std::lock_guard<std::mutex> lock(sendQueueMutex);
+    size_t cancelled = sendQueue.size();
+    std::queue<PltJob>().swap(sendQueue);
+    if (activeStreamer)
+    {
+        activeStreamer->Cancel();
+        cancelled++;
+    }
+    // 暂停随作业一起取消; 唤醒可能正在暂停或流控等待的发送线程
+    sendPaused = false;
+    sendQueueCv.notify_one();
+    WakeReconnectWaiters();
+    return cancelled;
+}
+
+void UsbDevice::StopSendThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(sendQueueMutex);
+        shouldStopSend = true;
+        std::queue<PltJob>().swap(sendQueue);
+        if (activeStreamer)
+        {
+            activeStreamer->Cancel();
+        }
+    }
+    sendQueueCv.notify_one();
+    WakeReconnectWaiters();
+
+    if (sendThread.joinable())
+    {
+        sendThread.join();
+    }
+}
+
+bool UsbDevice::WriteChunk(const uint8_t *data, size_t length, std::string &error)
+{
+    // PLT 分块以批量优先级写入, 在块与块之间让在等待的命令先写
+    WriteScheduler::Guard lock(scheduler, WriteScheduler::Priority::BULK);
+
+    if (!isConnected || !transport->IsOpen())
+    {
+        error = "Device not connected";
+        return false;
+    }
+
+    size_t bytesWritten = 0;
+    auto writeStart = IoStats::Clock::now();
+    IoStatus status = transport->Write(data, length, bytesWritten, WRITE_STALL_TIMEOUT);
+    stats.write.Record(IoStats::MicrosSince(writeStart));
+    stats.bytesOut += bytesWritten;
+
+    if (status != IoStatus::OK)
+    {
+        stats.errors++;
+        int code = transport->LastError();
+        LOG_ERROR("Write operation failed with error: %d", code);
+        error = "Failed to write data: " + std::to_string(code);
+        if (status == IoStatus::CLOSED)
+        {
+            OnDeviceLost(connectionId);
+        }
+        return false;
+    }
+    return true;
+}
+
+// pausePlt() 之后在块边界处等待 resumePlt(); 作业被取消或发送线程停止时返回 false
+bool UsbDevice::WaitWhilePaused(PltStreamer &streamer)
+{
+    std::unique_lock<std::mutex> lock(sendQueueMutex);
+    sendQueueCv.wait(lock, [this, &streamer] { return !sendPaused || shouldStopSend || streamer.Cancelled(); });
+    return !shouldStopSend && !streamer.Cancelled();
+}
+
+// 按流控估计在写入 length 字节前等待; 作业被取消或发送线程停止时返回 false
+bool UsbDevice::PaceChunk(FlowController &flow, PltStreamer &streamer, size_t length)
+{
+    int64_t delayUs;
+    while ((delayUs = flow.DelayBefore(length, IoStats::NowUs())) > 0)
+    {
+        auto waitStart = IoStats::Clock::now();
+        std::unique_lock<std::mutex> lock(sendQueueMutex);
+        bool stopped = sendQueueCv.wait_for(lock, std::chrono::microseconds(delayUs),
+                                            [this, &streamer] { return shouldStopSend || streamer.Cancelled(); });
+        stats.pausedUs += IoStats::MicrosSince(waitStart);
+        if (stopped)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 在两个 PLT 分块之间查询设备缓冲区的剩余空间 (分块在命令边界处切分, 可以插入命令)
+void UsbDevice::QueryDeviceBuffer(FlowController &flow, const std::string &command)
+{
+    std::vector<uint8_t> response;
+    std::string error;
+    CommandMux::Result result = mux->SubmitAndWait(reinterpret_cast<const uint8_t *>(command.data()), command.size(),
+                                                   cmdTimeoutMs, CommandFraming(), response, error);
+    uint64_t freeBytes = 0;
+    if (result == CommandMux::Result::OK && FlowController::ParseStatus(response.data(), response.size(), freeBytes))
+    {
+        flow.OnStatus(freeBytes, IoStats::NowUs());
+    }
+    else
+    {
+        LOG_DEBUG("Buffer status query failed: %s", error.empty() ? "unrecognized response" : error.c_str());
+    }
+}
+
 void UsbDevice::ProcessSendQueue()
 {
-    // 简单实现
+    for (;;)
+    {
+        PltJob job;
+        {
+            std::unique_lock<std::mutex> lock(sendQueueMutex);
+            sendQueueCv.wait(lock, [this] { return shouldStopSend || !sendQueue.empty(); });
+            if (shouldStopSend)
+            {
+                return;
+            }
+            job = std::move(sendQueue.front());
+            sendQueue.pop();
+        }
+
+        PltStreamer streamer(job.chunkSize);
+        FlowProfile profile;
+        {
+            std::lock_guard<std::mutex> lock(sendQueueMutex);
+            activeStreamer = &streamer;
+            profile = flowProfile;
+        }
+        FlowController flow(profile);
+
+        uint64_t total = job.source->Size();
+        uint64_t sent = 0;
+        std::string error;
+        uint64_t writeConnection = 0;
+        sendProgress = 0.0;
+
+        bool ok = streamer.Run(
+            *job.source,
+            [this, total, &sent, &error, &flow, &streamer, &profile, &writeConnection](const uint8_t *data, size_t length) {
+                if (!WaitWhilePaused(streamer))
+                {
+                    return false;
+                }
+                if (flow.Enabled())
+                {
+                    if (flow.StatusDue(IoStats::NowUs()))
+                    {
+                        QueryDeviceBuffer(flow, profile.statusCommand);
+                    }
+                    uint64_t pauses = flow.Pauses();
+                    if (!PaceChunk(flow, streamer, length))
+                    {
+                        return false;
+                    }
+                    stats.pauses += flow.Pauses() - pauses;
+                }
+
+                int64_t writeStart = IoStats::NowUs();
+                writeConnection = connectionId;
+                if (!WriteChunk(data, length, error))
+                {
+                    return false;
+                }
+                if (flow.Enabled())
+                {
+                    uint64_t stalls = flow.Stalls();
+                    flow.OnWrite(length, writeStart, IoStats::NowUs());
+                    stats.stalls += flow.Stalls() - stalls;
+                    stats.drainRate = flow.DrainRate();
+                }
+                // 每写完一块就更新进度
+                sent += length;
+                sendProgress = total > 0 ? static_cast<double>(sent) / total : 1.0;
+                return true;
+            },
+            [this](const PltStreamer::Progress &progress) {
+                EmitProgress(progress);
+            },
+            job.progressInterval,
+            [this, &streamer, &flow, &profile, &error, &writeConnection, &sent]() {
+                // 设备在作业中被移除: 重连后从没有写完的块 (命令边界) 继续; 设备复位后缓冲区为空, 流控重新估计
+                if (!WaitForReconnect(streamer, writeConnection))
+                {
+                    return false;
+                }
+                LOG_INFO("Resuming PLT job at %llu bytes", static_cast<unsigned long long>(streamer.BytesSent()));
+                flow = FlowController(profile);
+                sent = streamer.BytesSent();
+                error.clear();
+                return true;
+            });
+
+        {
+            std::lock_guard<std::mutex> lock(sendQueueMutex);
+            activeStreamer = nullptr;
+        }
+
+        if (!ok)
+        {
+            EmitError(error.empty() ? "PLT job cancelled" : error);
+        }
+    }
 }
 
 // 初始化导出函数
+// listDevices({ refresh }) -> [{ path, vendorId, productId, serial }]
+Napi::Value ListDevices(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    bool refresh = false;
+    if (info.Length() >= 1 && info[0].IsObject())
+    {
+        Napi::Object options = info[0].As<Napi::Object>();
+        if (options.Has("refresh"))
+        {
+            refresh = options.Get("refresh").ToBoolean().Value();
+        }
+    }
+
+    std::vector<DeviceInfo> devices = DeviceIndex::Shared().List(refresh);
+    Napi::Array result = Napi::Array::New(env, devices.size());
+    for (size_t i = 0; i < devices.size(); i++)
+    {
+        Napi::Object device = Napi::Object::New(env);
+        device.Set("path", Napi::String::New(env, devices[i].path));
+        device.Set("vendorId", Napi::Number::New(env, devices[i].vendorId));
+        device.Set("productId", Napi::Number::New(env, devices[i].productId));
+        device.Set("serial", Napi::String::New(env, devices[i].serial));
+        result.Set(static_cast<uint32_t>(i), device);
+    }
+    return result;
+}
+
+#ifndef _WIN32
+// setSysfsRoot(path, { devRoot }): 设备索引改为扫描 path 下的 sysfs 目录树, 设备节点为 devRoot/usb/lpN (测试用);
+// 空字符串恢复 /sys 和 /dev
+Napi::Value SetSysfsRoot(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        Napi::TypeError::New(env, "Expected sysfs root path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string devRoot;
+    if (info.Length() >= 2 && info[1].IsObject() && info[1].As<Napi::Object>().Has("devRoot"))
+    {
+        Napi::Value value = info[1].As<Napi::Object>().Get("devRoot");
+        if (!value.IsString())
+        {
+            Napi::TypeError::New(env, "devRoot must be a string").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        devRoot = value.As<Napi::String>().Utf8Value();
+    }
+
+    DeviceIndex::Shared().SetSysfsRoot(info[0].As<Napi::String>().Utf8Value(), devRoot);
+    return env.Undefined();
+}
+#endif
+
+// discardDevice(token) -> boolean; 关闭一个 detach() 之后没有被 attach() 取出的设备
+Napi::Value DiscardDevice(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        Napi::TypeError::New(env, "Expected device token").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    return Napi::Boolean::New(env, DeviceHandoff::Shared().Discard(info[0].As<Napi::Number>().Uint32Value()));
+}
+
+// 模块在每个 JS 环境 (主线程和每个 worker_threads) 中各初始化一次, 状态放在 AddonData 中
 Napi::Object Init(Napi::Env env, Napi::Object exports)
 {
+    AddonData::Get(env);
+    InitPltTools(env, exports);
+    InitLogging(env, exports);
+    InitTraceTools(env, exports);
+    InitDeviceProfiles(env, exports);
+    InitJobCache(env, exports);
+    exports.Set("listDevices", Napi::Function::New(env, ListDevices, "listDevices"));
+    exports.Set("discardDevice", Napi::Function::New(env, DiscardDevice, "discardDevice"));
+#ifndef _WIN32
+    exports.Set("setSysfsRoot", Napi::Function::New(env, SetSysfsRoot, "setSysfsRoot"));
+    EmulatorWrap::Init(env, exports);
+#endif
+#ifdef __linux__
+    DevicePool::Init(env, exports);
+#endif
     return UsbDevice::Init(env, exports);
 }
 
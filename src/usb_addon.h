@@ -1,59 +1,312 @@
 #pragma once
 #include <napi.h>
+#ifdef _WIN32
 #include <windows.h>
 #include <setupapi.h>
+#endif
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 #include <thread>
 #include <queue>
 #include <mutex>
-#include <iostream>
+#include <vector>
+#include "buffer_pool.h"
+#include "tracing_transport.h"
+#include "transport.h"
+#include "chunk_source.h"
+#include "plt_streamer.h"
+#include "flow_control.h"
+#include "device_profile.h"
+#include "command_mux.h"
+#include "write_scheduler.h"
+#include "event_queue.h"
+#include "io_stats.h"
+#include "hotplug.h"
+#ifdef __linux__
+#include "uevent_monitor.h"
+#endif
 
 // 事件类型
 enum class EventType {
     HOTPLUG,    // 热插拔事件
     CMD_RESPONSE, // 命令响应
-    ERR       // 错误事件
+    ERR,      // 错误事件
+    PROGRESS, // PLT 作业进度
+    DISCONNECTED,  // 检测到设备移除, 句柄已关闭
+    RECONNECTED    // 自动重连成功
+};
+
+// 事件队列中的一个槽位, 随队列循环复用 (message 的容量也随之复用)
+struct UsbEvent {
+    EventType type = EventType::ERR;
+    HotplugChange hotplug;
+    std::vector<uint8_t>* data = nullptr;   // CMD_RESPONSE: 来自 BufferPool, 送达时交给 JS
+    std::string message;                    // ERROR; DISCONNECTED / RECONNECTED 的设备路径
+    PltStreamer::Progress progress;         // PROGRESS (作业结束的那一次, 不合并)
+};
+
+// 后台线程 -> JS 的事件通道
+// 生产者无锁入队, 只有队列由空变为非空时才发起一次 NonBlockingCall; JS 线程上一次取完所有事件.
+// 由设备和尚未执行的投递共同持有, 设备先被回收时投递仍然安全.
+struct EventChannel {
+    static const size_t CAPACITY = 1024;
+
+    EventChannel()
+        : queue(CAPACITY), progressPending(false), scheduled(false), batch(false),
+          delivered(0), dropped(0), coalesced(0), batches(0)
+    {
+    }
+
+    // 没来得及送达的响应缓冲区归还到池中
+    ~EventChannel()
+    {
+        queue.Drain([](UsbEvent &event) {
+            if (event.data)
+            {
+                BufferPool::Shared().Release(event.data);
+                event.data = nullptr;
+            }
+        }, queue.Capacity());
+    }
+
+    EventQueue<UsbEvent> queue;
+    LatestValue<PltStreamer::Progress> progress;   // 作业进行中的进度只保留最新一次
+    std::atomic<bool> progressPending;
+    std::atomic<bool> scheduled;                   // 已有一次投递在等待 JS 线程
+    std::atomic<bool> batch;                       // true: callback(events[]), false: 逐个 callback(type, data)
+
+    std::atomic<uint64_t> delivered;
+    std::atomic<uint64_t> dropped;     // 队列满时丢弃的事件
+    std::atomic<uint64_t> coalesced;   // 被更新的进度覆盖的进度事件
+    std::atomic<uint64_t> batches;     // JS 回合数
+};
+
+// 等待在 JS 线程上执行的内部任务 (见 UsbDevice::RunOnJsThread)
+// 任务存放在这里而不是 tsfn 的调用数据里: 环境销毁时 node-addon-api 不再调用 CallJS,
+// 调用数据无人释放; 这里剩下的任务由 jsTasks 的 finalizer 统一丢弃.
+struct JsTaskQueue {
+    // 在 JS 线程上执行当前排队的全部任务
+    void Run(Napi::Env env)
+    {
+        std::vector<std::function<void(Napi::Env)>> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.swap(tasks);
+        }
+        for (auto &task : ready)
+        {
+            task(env);
+        }
+    }
+
+    std::mutex mutex;
+    std::vector<std::function<void(Napi::Env)>> tasks;
+};
+
+// 析构时执行 release, 把收尾工作挂在所有者的生命周期上
+class ScopeRelease {
+public:
+    explicit ScopeRelease(std::function<void()> release)
+        : release(std::move(release))
+    {
+    }
+
+    ~ScopeRelease()
+    {
+        release();
+    }
+
+private:
+    std::function<void()> release;
+};
+
+// 排队等待后台发送的 PLT 作业
+struct PltJob {
+    // 作业结束、被取消或丢弃时析构, 解除对事件循环的保持 (见 UsbDevice::HoldLoop);
+    // 声明在 source 之前, 最后析构, source 释放 JS 引用的任务排在它前面
+    std::unique_ptr<ScopeRelease> loopHold;
+    std::unique_ptr<ChunkSource> source;
+    size_t chunkSize;
+    int progressInterval;   // 进度事件的最小间隔 (毫秒)
 };
 
 class UsbDevice : public Napi::ObjectWrap<UsbDevice> {
+    friend class SendWorker;
+    friend class CommandWorker;
+
 public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
     UsbDevice(const Napi::CallbackInfo& info);
     ~UsbDevice();
 
+    // 默认超时 (毫秒): 命令等待以分号结尾的响应, PLT 等待设备回执; 可用 setTimeouts() 按设备修改
+    static constexpr int CMD_TIMEOUT = 50;
+    static constexpr int PLT_TIMEOUT = 500;
+
+    // startCapture 默认的跟踪文件数据区大小 (字节)
+    static constexpr size_t DEFAULT_TRACE_SIZE = 64 * 1024 * 1024;
+
+    // setAutoReconnect 的默认值 (毫秒): 设备移除后最多等待多久重新出现, 以及两次尝试之间的间隔
+    static constexpr int DEFAULT_RECONNECT_TIMEOUT = 30000;
+    static constexpr int DEFAULT_RECONNECT_INTERVAL = 200;
+
 private:
-    static Napi::FunctionReference constructor;
+    // 类的构造函数引用在 AddonData 中 (每个环境一份)
+    typedef Napi::Env::CleanupHook<void (*)(UsbDevice *), UsbDevice> CleanupHook;
+    CleanupHook cleanupHook;
 
-    // Windows handles
-    HANDLE deviceHandle;
-    bool isConnected;
+    // 设备传输层 (Windows: WinTransport, Linux: PosixTransport), 外面套一层跟踪记录, 见 startCapture()
+    std::unique_ptr<TracingTransport> transport;
+    std::atomic<bool> isConnected;   // 设备被移除后由 linkThread 清除
+    std::atomic<uint64_t> connectionId;  // 每次打开设备加一, 用来区分旧连接上报的移除
     std::thread notificationThread;
     bool shouldStopNotification;
+#ifdef _WIN32
     HDEVNOTIFY deviceNotificationHandle;
+#endif
+#ifdef __linux__
+    std::unique_ptr<UeventMonitor> ueventMonitor;   // netlink uevent 热插拔事件源
+#endif
     
     // 数据传输相关
-    double sendProgress;
+    std::atomic<double> sendProgress;
     bool isOperationInProgress;
+    WriteScheduler scheduler;  // 按优先级串行化对 transport 的写操作: 命令优先于 PLT 分块
+    std::unique_ptr<CommandMux> mux;  // 连接期间持续读取设备, 按 FIFO 匹配命令响应
+    IoStats stats;                    // 延迟直方图与吞吐计数, 见 getStats()
+    uint64_t retriesAtReset;          // resetStats() 时 transport 的写重试计数
+    uint64_t preemptionsAtReset;      // resetStats() 时 scheduler 的让位计数
+    std::atomic<int> cmdTimeoutMs;    // 本设备的命令超时, 单次调用可以用 { timeout } 覆盖
+    std::atomic<int> pltTimeoutMs;    // 本设备的 PLT 回执超时
+    std::atomic<bool> terminatedReplies;  // 命令响应有结束符 (型号配置), 否则取收到的第一段数据
+    DeviceProfile activeProfile;      // 当前型号配置, 只在 JS 线程上访问
+
+    // 后台 PLT 发送队列 (由 ProcessSendQueue 线程消费)
+    std::thread sendThread;
+    std::queue<PltJob> sendQueue;
+    std::mutex sendQueueMutex;
+    std::condition_variable sendQueueCv;
+    bool shouldStopSend;
+    bool sendPaused;              // pausePlt() 后发送线程在下一个块边界处等待, 受 sendQueueMutex 保护
+    PltStreamer* activeStreamer;  // 正在发送的作业, 受 sendQueueMutex 保护
+    FlowProfile flowProfile;      // PLT 流控参数, 受 sendQueueMutex 保护, 每个作业开始时读取
     
+    // 设备移除检测与自动重连 (setAutoReconnect), 以下除 linkThread 外受 linkMutex 保护
+    std::thread linkThread;       // 在第一次检测到设备移除时启动
+    std::mutex linkMutex;
+    std::condition_variable linkCv;
+    bool autoReconnect;
+    bool resumeJobs;              // 重连后从中断的块继续发送 PLT 作业
+    int reconnectTimeoutMs;
+    int reconnectIntervalMs;
+    bool linkLost;                // 设备已移除, 等待 linkThread 关闭句柄并重连
+    bool linkBusy;                // linkThread 正在关闭或打开设备
+    bool linkArrival;             // 重连期间有设备到达, 立即重试
+    bool shouldStopLink;
+    std::string connectedPath;    // 当前 (或最后一次) 连接的设备路径
+    std::string deviceSerial;
+
     // JavaScript回调函数
     Napi::ThreadSafeFunction tsfn;  // 用于所有事件回调
+    std::shared_ptr<EventChannel> events;
+    Napi::ThreadSafeFunction jsTasks;  // 内部任务, 见 RunOnJsThread
+    std::shared_ptr<JsTaskQueue> jsTaskQueue;
+    int loopHolds;  // 进行中的异步工作数, 只在 JS 线程上读写, 见 HoldLoop
 
     // Node.js方法
     Napi::Value Connect(const Napi::CallbackInfo& info);
+    Napi::Value ConnectPath(const Napi::CallbackInfo& info);
     Napi::Value Disconnect(const Napi::CallbackInfo& info);
     Napi::Value SendPlt(const Napi::CallbackInfo& info);
     Napi::Value SendCmd(const Napi::CallbackInfo& info);
+    Napi::Value SendPltAsync(const Napi::CallbackInfo& info);
+    Napi::Value SendCmdAsync(const Napi::CallbackInfo& info);
+    Napi::Value StartPlt(const Napi::CallbackInfo& info);
+    Napi::Value SendPltFile(const Napi::CallbackInfo& info);
+    Napi::Value SendCached(const Napi::CallbackInfo& info);
+    Napi::Value PausePlt(const Napi::CallbackInfo& info);
+    Napi::Value ResumePlt(const Napi::CallbackInfo& info);
+    Napi::Value CancelPlt(const Napi::CallbackInfo& info);
     Napi::Value GetSendProgress(const Napi::CallbackInfo& info);
+    Napi::Value GetEventStats(const Napi::CallbackInfo& info);
+    Napi::Value GetStats(const Napi::CallbackInfo& info);
+    Napi::Value ResetStats(const Napi::CallbackInfo& info);
+    Napi::Value StartCapture(const Napi::CallbackInfo& info);
+    Napi::Value StopCapture(const Napi::CallbackInfo& info);
+    Napi::Value SetTimeouts(const Napi::CallbackInfo& info);
+    Napi::Value GetProfile(const Napi::CallbackInfo& info);
+    Napi::Value SetAutoReconnect(const Napi::CallbackInfo& info);
+    Napi::Value IsConnected(const Napi::CallbackInfo& info);
+    Napi::Value Detach(const Napi::CallbackInfo& info);
+    Napi::Value Attach(const Napi::CallbackInfo& info);
+    Napi::Value SetFlowControl(const Napi::CallbackInfo& info);
     Napi::Value StartHotplugMonitor(const Napi::CallbackInfo& info);
     Napi::Value StopHotplugMonitor(const Napi::CallbackInfo& info);
 
     // 内部方法
+    static void OnEnvCleanup(UsbDevice* device);
+    void Shutdown();
     void NotificationThreadProc();
     void ProcessSendQueue();
-    bool InitializeDevice(HANDLE deviceHandle);
-    std::string GetDevicePath(WORD vendorId, WORD productId);
+    void EnqueuePltJob(PltJob job);
+    size_t CancelPltJobs();
+    void StopSendThread();
+    bool WriteChunk(const uint8_t* data, size_t length, std::string& error);
+    bool PaceChunk(FlowController& flow, PltStreamer& streamer, size_t length);
+    bool WaitWhilePaused(PltStreamer& streamer);
+    void QueryDeviceBuffer(FlowController& flow, const std::string& command);
+    bool OpenDevice(const std::string& devicePath);
+    void StartReader(const std::string& devicePath);
+    void ApplyProfile(const DeviceProfile& profile);
+    CommandMux::Framing CommandFraming() const
+    {
+        return terminatedReplies ? CommandMux::Framing::TERMINATED : CommandMux::Framing::RAW;
+    }
+    void CloseDevice();
+    void OnDeviceLost(uint64_t connection);
+    void OnHotplug(const HotplugChange& change);
+    void LinkThreadProc();
+    bool ReopenDevice(const std::string& lastPath, uint16_t vendorId, uint16_t productId, const std::string& serial);
+    void StopReconnect();
+    void StopLinkThread();
+    bool WaitForReconnect(PltStreamer& streamer, uint64_t since);
+    void WakeReconnectWaiters();
+    Napi::Value SendAsync(const Napi::CallbackInfo& info, bool isPlt);
+
+    // 阻塞 I/O (经由 mux), 可在任意线程调用; 返回 false 表示写入失败 (error 为原因)
+    // 响应一到即返回, timeoutMs 内没有响应时 response 为空
+    bool DoSendPlt(const uint8_t* data, size_t length, size_t chunkSize, int timeoutMs, std::vector<uint8_t>& response,
+                   std::string& error);
+    bool DoSendCmd(const uint8_t* data, size_t length, int timeoutMs, std::vector<uint8_t>& response, std::string& error);
+
+    // 通过 tsfn 向 JS 发送事件 (未注册回调时忽略)
+    void EmitError(const std::string& message);
+    void EmitCmdResponse(std::vector<uint8_t>* response);  // 接管 response 的所有权
+
+    // 在 JS 线程上执行任务 (例如释放 Napi::Reference); 环境已销毁时任务不执行, 只随队列释放
+    void RunOnJsThread(std::function<void(Napi::Env)> task);
+    // 异步工作开始/结束 (JS 线程上调用): 有工作在进行时 jsTasks 保持事件循环存活, 对象也不会被回收,
+    // 以便完成时还能回到 JS 线程; 没有时不阻止进程退出
+    void HoldLoop(Napi::Env env);
+    void ReleaseLoop(Napi::Env env);
+    void EmitProgress(const PltStreamer::Progress& progress);
+    void EmitHotplug(const HotplugChange& change);
+    void EmitConnection(EventType type, const std::string& path);
+
+    // 把事件放入 events 队列并按需安排一次投递; 队列已满时返回 false
+    template <typename Fill>
+    bool PushEvent(Fill fill);
+    void ScheduleDrain();
+    static void DrainEvents(Napi::Env env, Napi::Function jsCallback, EventChannel& channel);
+#ifdef _WIN32
     static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+#endif
 
-    WORD currentVendorId;    // 添加当前设备的 VID
-    WORD currentProductId;   // 添加当前设备的 PID
+    // 当前设备的 VID/PID: 只在 JS 线程上于 linkMutex 下写入, linkThread 在锁内取快照
+    uint16_t currentVendorId;
+    uint16_t currentProductId;
 };
@@ -0,0 +1,50 @@
+#include "write_scheduler.h"
+
+WriteScheduler::WriteScheduler()
+    : held(false),
+      preemptions(0)
+{
+    for (int i = 0; i < PRIORITY_COUNT; i++)
+    {
+        waiting[i] = 0;
+    }
+}
+
+void WriteScheduler::Lock(Priority priority)
+{
+    int index = static_cast<int>(priority);
+    const int interactive = static_cast<int>(Priority::INTERACTIVE);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    waiting[index]++;
+    bool yielded = false;
+    cv.wait(lock, [&] {
+        if (held)
+        {
+            return false;
+        }
+        // 批量写入让位于所有在等待的交互命令
+        if (index != interactive && waiting[interactive] > 0)
+        {
+            yielded = true;
+            return false;
+        }
+        return true;
+    });
+    waiting[index]--;
+    held = true;
+
+    if (yielded)
+    {
+        preemptions++;
+    }
+}
+
+void WriteScheduler::Unlock()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        held = false;
+    }
+    cv.notify_all();
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// 设备写入调度器
+// 同一设备的所有写入 (交互命令、PLT 数据) 都要先取得写权限. 写权限按优先级授予:
+// 有交互命令在等待时, 批量数据的下一块要等命令写完才能写出. PLT 作业按命令边界切块写入,
+// 因此状态查询最多等待一个分块的写入时间, 而不是整个作业.
+class WriteScheduler {
+public:
+    enum class Priority {
+        INTERACTIVE = 0,  // 命令与状态查询
+        BULK = 1          // PLT 数据
+    };
+
+    WriteScheduler();
+
+    WriteScheduler(const WriteScheduler &) = delete;
+    WriteScheduler &operator=(const WriteScheduler &) = delete;
+
+    void Lock(Priority priority);
+    void Unlock();
+
+    // 批量写入因交互命令而推迟的次数
+    uint64_t Preemptions() const { return preemptions.load(); }
+
+    class Guard {
+    public:
+        Guard(WriteScheduler &scheduler, Priority priority)
+            : scheduler(scheduler)
+        {
+            scheduler.Lock(priority);
+        }
+
+        ~Guard()
+        {
+            scheduler.Unlock();
+        }
+
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+
+    private:
+        WriteScheduler &scheduler;
+    };
+
+private:
+    static const int PRIORITY_COUNT = 2;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool held;
+    int waiting[PRIORITY_COUNT];
+    std::atomic<uint64_t> preemptions;
+};
@@ -0,0 +1,73 @@
+// 命令的发送、响应匹配与超时
+const assert = require('assert');
+const { addon, emulatorTest, withDevice, sendCmd } = require('./harness');
+
+emulatorTest('查询命令', () => withDevice({}, async (device) => {
+  assert.strictEqual((await sendCmd(device, 'RSVER;')).toString(), 'RSVER:EMU-1.0;');
+  assert.strictEqual((await sendCmd(device, 'RPID;')).toString(), 'RPID:5750;');
+  assert.strictEqual((await sendCmd(device, 'BD:36;')).toString(), 'BD:36;');
+}));
+
+emulatorTest('多条命令同时在途时按顺序匹配', () => withDevice({ latency: 2, jitter: 5 }, async (device) => {
+  const commands = [];
+  for (let i = 0; i < 32; i++) {
+    commands.push(`BD:${i};`);
+  }
+  const replies = await Promise.all(commands.map((command) => sendCmd(device, command, { timeout: 2000 })));
+  assert.deepStrictEqual(replies.map(String), commands);
+}));
+
+emulatorTest('命令超时', () => withDevice({ latency: 200 }, async (device) => {
+  await assert.rejects(sendCmd(device, 'RSVER;', { timeout: 20 }));
+}));
+
+emulatorTest('没有响应的命令不影响后续命令', () => withDevice({}, async (device) => {
+  // PLT 数据没有回执, XX; 模拟器不回复; 之后的每条查询都应收到自己的响应
+  assert.strictEqual(await device.sendPltAsync(Buffer.from('IN;PU0,0;'), { timeout: 50 }), null);
+  await assert.rejects(sendCmd(device, 'XX;', { timeout: 50 }));
+  for (let i = 0; i < 5; i++) {
+    assert.strictEqual((await sendCmd(device, `BD:${i};`, { timeout: 500 })).toString(), `BD:${i};`);
+  }
+  assert.strictEqual((await sendCmd(device, 'RSVER;', { timeout: 500 })).toString(), 'RSVER:EMU-1.0;');
+}));
+
+emulatorTest('等待响应期间进程不退出', () => {
+  // 子进程中除了在途的命令没有其他工作, 事件循环必须等到 Promise 完成
+  const { execFileSync } = require('child_process');
+  const addonPath = require('bindings')({ bindings: 'usb_addon', path: true });
+  const output = execFileSync(process.execPath, ['-e', `
+    const addon = require(${JSON.stringify(addonPath)});
+    const emulator = new addon.CutterEmulator({ latency: 200 });
+    const device = new addon.UsbDevice();
+    device.connectPath(emulator.getPath());
+    device.sendCmdAsync(Buffer.from('RSVER;')).then((reply) => {
+      console.log(reply.toString());
+      device.disconnect();
+      emulator.close();
+    });
+  `], { encoding: 'utf8', timeout: 10000 });
+  assert.strictEqual(output.trim(), 'RSVER:EMU-1.0;');
+});
+
+emulatorTest('按设备设置超时', () => withDevice({ latency: 100 }, async (device) => {
+  assert.deepStrictEqual(device.setTimeouts({ command: 20 }), { command: 20, plt: 500 });
+  await assert.rejects(sendCmd(device, 'RSVER;'));
+  device.setTimeouts({ command: 1000 });
+  const start = process.hrtime.bigint();
+  assert.strictEqual((await sendCmd(device, 'RSVER;')).toString(), 'RSVER:EMU-1.0;');
+  const ms = Number(process.hrtime.bigint() - start) / 1e6;
+  assert.ok(ms < 500, `响应在 ${ms.toFixed(1)}ms 后才返回`);
+}));
+
+emulatorTest('getStats 延迟直方图', () => withDevice({ latency: 5 }, async (device) => {
+  device.resetStats();
+  for (let i = 0; i < 10; i++) {
+    await sendCmd(device, 'RSVER;', { timeout: 1000 });
+  }
+  const stats = device.getStats();
+  assert.strictEqual(stats.roundTrip.count, 10);
+  assert.ok(stats.roundTrip.p50 >= 5000, `p50 ${stats.roundTrip.p50}us`);
+  assert.ok(stats.firstByte.count >= 1);
+  assert.strictEqual(stats.bytesOut, 60);
+  assert.strictEqual(stats.timeouts, 0);
+}));
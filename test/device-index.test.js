@@ -0,0 +1,62 @@
+// 设备索引: 在伪造的 sysfs 目录树上扫描, 设备节点是指向模拟器的符号链接
+const assert = require('assert');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { addon, linuxTest, sendCmd } = require('./harness');
+
+// 按 usblp 的布局添加一台打印机: class/usbmisc/lpN/device -> USB 接口, 接口的上一级是带 idVendor 等属性的 USB 设备
+function addPrinter(root, name, usbDevice, { vendorId, productId, serial }, nodeTarget) {
+  const usbDir = path.join(root, 'sys', 'devices', 'usb1', usbDevice);
+  const interfaceDir = path.join(usbDir, `${usbDevice}:1.0`);
+  fs.mkdirSync(interfaceDir, { recursive: true });
+  fs.writeFileSync(path.join(usbDir, 'idVendor'), `${vendorId.toString(16).padStart(4, '0')}\n`);
+  fs.writeFileSync(path.join(usbDir, 'idProduct'), `${productId.toString(16).padStart(4, '0')}\n`);
+  fs.writeFileSync(path.join(usbDir, 'serial'), `${serial}\n`);
+
+  const classDir = path.join(root, 'sys', 'class', 'usbmisc', name);
+  fs.mkdirSync(classDir, { recursive: true });
+  fs.symlinkSync(path.relative(classDir, interfaceDir), path.join(classDir, 'device'));
+
+  fs.mkdirSync(path.join(root, 'dev', 'usb'), { recursive: true });
+  fs.symlinkSync(nodeTarget, path.join(root, 'dev', 'usb', name));
+}
+
+linuxTest('listDevices 和 connect 按 VID/PID/序列号查找伪造 sysfs 中的设备', async () => {
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), 'usb-addon-sysfs-'));
+  const emulators = [new addon.CutterEmulator({ productId: 0x1111 }), new addon.CutterEmulator({ productId: 0x2222 })];
+  const device = new addon.UsbDevice();
+  try {
+    addPrinter(root, 'lp0', '1-1', { vendorId: 0x1a86, productId: 0x7584, serial: 'SN-A' }, emulators[0].getPath());
+    addPrinter(root, 'lp1', '1-2', { vendorId: 0x1a86, productId: 0x7584, serial: 'SN-B' }, emulators[1].getPath());
+    addon.setSysfsRoot(path.join(root, 'sys'), { devRoot: path.join(root, 'dev') });
+
+    assert.deepStrictEqual(addon.listDevices(), [
+      { path: path.join(root, 'dev', 'usb', 'lp0'), vendorId: 0x1a86, productId: 0x7584, serial: 'SN-A' },
+      { path: path.join(root, 'dev', 'usb', 'lp1'), vendorId: 0x1a86, productId: 0x7584, serial: 'SN-B' },
+    ]);
+
+    // 同型号的两台设备按序列号区分; 模拟器的 RPID 应答说明打开的是哪一台
+    assert.strictEqual(device.connect(0x1a86, 0x7584, 'SN-B'), true);
+    assert.strictEqual((await sendCmd(device, 'RPID;')).toString(), 'RPID:2222;');
+    device.disconnect();
+    assert.strictEqual(device.connect(0x1a86, 0x7584), true);
+    assert.strictEqual((await sendCmd(device, 'RPID;')).toString(), 'RPID:1111;');
+    device.disconnect();
+    assert.strictEqual(device.connect(0x1a86, 0x7584, 'SN-X'), false);
+
+    // 上次扫描后 RESCAN_INTERVAL (500 毫秒) 内查找失败不重新扫描, 新出现的设备要等到间隔过后才能找到
+    addon.listDevices({ refresh: true });
+    addPrinter(root, 'lp2', '1-3', { vendorId: 0x1a86, productId: 0x9999, serial: 'SN-C' }, emulators[0].getPath());
+    assert.strictEqual(device.connect(0x1a86, 0x9999), false);
+    assert.strictEqual(addon.listDevices().length, 2);
+    await new Promise((resolve) => setTimeout(resolve, 600));
+    assert.strictEqual(device.connect(0x1a86, 0x9999), true);
+    assert.strictEqual(addon.listDevices().length, 3);
+  } finally {
+    device.disconnect();
+    emulators.forEach((emulator) => emulator.close());
+    addon.setSysfsRoot('');
+    fs.rmSync(root, { recursive: true, force: true });
+  }
+});
@@ -0,0 +1,126 @@
+// DevicePool: 一个事件循环线程服务多台设备 (仅 Linux), 用多个模拟器代替刻字机
+const assert = require('assert');
+const { addon, emulatorTest, makeJob } = require('./harness');
+
+function poolTest(name, fn) {
+  emulatorTest(name, addon.DevicePool ? fn : () => console.log('  (当前平台没有 DevicePool)'));
+}
+
+// 打开若干个模拟器并加入同一个连接池; events 按到达顺序记录 { type, device, job, data, error, time }
+async function withPool(emulatorOptions, fn) {
+  const emulators = emulatorOptions.map((options) => new addon.CutterEmulator(options));
+  const events = [];
+  const start = Date.now();
+  const pool = new addon.DevicePool((type, event) => {
+    events.push({ type, ...event, data: event.data && event.data.toString(), time: Date.now() - start });
+  });
+
+  // 等待满足条件的事件出现
+  const waitFor = async (predicate, timeoutMs = 5000) => {
+    const deadline = Date.now() + timeoutMs;
+    for (;;) {
+      const event = events.find(predicate);
+      if (event) {
+        return event;
+      }
+      if (Date.now() > deadline) {
+        throw new Error(`等待事件超时, 已收到: ${JSON.stringify(events)}`);
+      }
+      await new Promise((resolve) => setTimeout(resolve, 5));
+    }
+  };
+
+  try {
+    const ids = emulators.map((emulator) => pool.open(emulator.getPath()));
+    ids.forEach((id) => assert.ok(id > 0));
+    await fn({ pool, ids, events, waitFor });
+  } finally {
+    pool.destroy();
+    emulators.forEach((emulator) => emulator.close());
+  }
+}
+
+const finalOf = (events, job) => events.find((event) => event.job === job && event.type !== 'DATA');
+
+poolTest('每台设备的命令按顺序收到自己的响应', () => withPool([{ latency: 2, jitter: 3 }, { latency: 1 }], async ({ pool, ids, events, waitFor }) => {
+  const jobs = ids.map((id, d) => {
+    const list = [];
+    for (let i = 0; i < 8; i++) {
+      list.push({ job: pool.sendCmd(id, Buffer.from(`BD:${d * 100 + i};`), { timeout: 1000 }), reply: `BD:${d * 100 + i};` });
+    }
+    list.push({ job: pool.sendCmd(id, Buffer.from('RSVER;'), { timeout: 1000 }), reply: 'RSVER:EMU-1.0;' });
+    return list;
+  });
+
+  for (const list of jobs) {
+    for (const { job, reply } of list) {
+      const event = await waitFor((e) => e.job === job);
+      assert.strictEqual(event.type, 'RESPONSE');
+      assert.strictEqual(event.data, reply);
+    }
+  }
+  // 同一设备的响应按提交顺序到达
+  ids.forEach((id, d) => {
+    const order = events.filter((e) => e.device === id && e.type === 'RESPONSE').map((e) => e.job);
+    assert.deepStrictEqual(order, jobs[d].map((entry) => entry.job));
+  });
+}));
+
+poolTest('大作业分多轮写出时其他设备照常应答', () => withPool([{ bandwidth: 512 * 1024 }, {}], async ({ pool, ids, waitFor }) => {
+  // 超过 MAX_WRITE_PER_TURN (64 KiB), 需要多轮才能写完
+  const job = makeJob(512 * 1024);
+  const sent = pool.send(ids[0], job);
+  const query = pool.sendCmd(ids[1], Buffer.from('RSVER;'), { timeout: 500 });
+
+  const reply = await waitFor((e) => e.job === query);
+  assert.strictEqual(reply.type, 'RESPONSE');
+  const done = await waitFor((e) => e.job === sent, 10000);
+  assert.strictEqual(done.type, 'SENT');
+  assert.ok(reply.time < done.time, `另一台设备在 ${reply.time}ms 才应答, 大作业 ${done.time}ms 写完`);
+  const receipt = await waitFor((e) => e.device === ids[0] && e.type === 'DATA');
+  assert.strictEqual(receipt.data, `JOB:${job.length};`);
+}));
+
+poolTest('限速写入期间的命令从写完开始计时', () => withPool([{ bandwidth: 64 * 1024 }], async ({ pool, ids, events, waitFor }) => {
+  // 约 1.5 秒才能写完的命令: 超时 (1 秒) 从最后一个字节写出后开始计算, 不会在写出过程中结束
+  const body = makeJob(96 * 1024);
+  const command = Buffer.concat([body.subarray(0, body.length - 1), Buffer.from('RSVER;')]);
+  const slow = pool.sendCmd(ids[0], command, { timeout: 1000 });
+  // 排在后面、设备不应答的命令按自己的超时失败
+  const silent = pool.sendCmd(ids[0], Buffer.from('XX;'), { timeout: 100 });
+
+  const reply = await waitFor((e) => e.job === slow, 10000);
+  assert.strictEqual(reply.type, 'RESPONSE');
+  assert.strictEqual(reply.data, 'RSVER:EMU-1.0;');
+  assert.ok(reply.time > 1000, `${reply.time}ms 就收到了响应`);
+
+  const timedOut = await waitFor((e) => e.job === silent, 5000);
+  assert.strictEqual(timedOut.type, 'ERROR');
+  assert.strictEqual(events.filter((e) => e.job === slow).length, 1);
+}));
+
+poolTest('关闭设备时未完成的作业先结束, CLOSED 是每台设备的最后一个事件', () => withPool([{ bandwidth: 32 * 1024 }, {}], async ({ pool, ids, events, waitFor }) => {
+  const pending = [pool.send(ids[0], makeJob(256 * 1024)), pool.sendCmd(ids[0], Buffer.from('RSVER;'), { timeout: 1000 })];
+  const answered = pool.sendCmd(ids[1], Buffer.from('BD:1;'), { timeout: 1000 });
+  await waitFor((e) => e.job === answered);
+
+  assert.strictEqual(pool.close(ids[0]), true);
+  await waitFor((e) => e.device === ids[0] && e.type === 'CLOSED');
+  for (const job of pending) {
+    assert.strictEqual(finalOf(events, job).type, 'ERROR');
+  }
+  assert.strictEqual(pool.deviceCount(), 1);
+
+  pool.destroy();
+  await waitFor((e) => e.device === ids[1] && e.type === 'CLOSED');
+  await new Promise((resolve) => setTimeout(resolve, 50));
+  for (const id of ids) {
+    const own = events.filter((e) => e.device === id);
+    assert.strictEqual(own[own.length - 1].type, 'CLOSED');
+    assert.strictEqual(own.filter((e) => e.type === 'CLOSED').length, 1);
+  }
+  // 每个作业恰好一个最终事件
+  for (const job of [...pending, answered]) {
+    assert.strictEqual(events.filter((e) => e.job === job && e.type !== 'DATA').length, 1);
+  }
+}));
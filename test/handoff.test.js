@@ -0,0 +1,40 @@
+// 在 worker_threads 之间移交设备
+const assert = require('assert');
+const { addon, emulatorTest, withDevice, sendCmd } = require('./harness');
+
+emulatorTest('在 worker 之间移交设备', () => withDevice({}, async (device) => {
+  const { Worker } = require('worker_threads');
+  const addonPath = require('bindings')({ bindings: 'usb_addon', path: true });
+  device.setTimeouts({ command: 300 });
+  const retriesBefore = device.getStats().retries;
+  const token = device.detach();
+  assert.strictEqual(device.isConnected(), false);
+  await assert.rejects(async () => sendCmd(device, 'RSVER;'));
+
+  // worker 取出设备发一条命令, 再移交回来; 另建一台未关闭的模拟器, 验证 worker 退出时的清理
+  const worker = new Worker(`
+    const { parentPort, workerData } = require('worker_threads');
+    const addon = require(workerData.addonPath);
+    const device = new addon.UsbDevice();
+    device.attach(workerData.token);
+    const leaked = new addon.CutterEmulator({});
+    device.sendCmdAsync(Buffer.from('RSVER;')).then((reply) => {
+      parentPort.postMessage({ reply: reply.toString(), timeout: device.setTimeouts().command, token: device.detach() });
+    });
+  `, { eval: true, workerData: { addonPath, token } });
+  const result = await new Promise((resolve, reject) => {
+    worker.once('message', resolve);
+    worker.once('error', reject);
+  });
+  await new Promise((resolve) => worker.once('exit', resolve));
+
+  assert.strictEqual(result.reply, 'RSVER:EMU-1.0;');
+  assert.strictEqual(result.timeout, 300);
+  assert.throws(() => device.attach(token));
+  assert.strictEqual(device.attach(result.token), true);
+  assert.strictEqual((await sendCmd(device, 'RPID;')).toString(), 'RPID:5750;');
+  // 换传输层后统计保持连续, 不会按 uint64 回绕
+  const retries = device.getStats().retries;
+  assert.ok(retries >= retriesBefore && retries < retriesBefore + 1000, `retries=${retries}`);
+  assert.strictEqual(addon.discardDevice(result.token), false);
+}));
@@ -0,0 +1,85 @@
+// 测试的公共部分: 注册测试、模拟器上的设备、测试用的 PLT 作业
+// 各功能的测试放在 test/*.test.js 中, 由 test/run.js 统一运行
+const assert = require('assert');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const addon = require('bindings')('usb_addon');
+
+const tests = [];
+
+// 不需要设备的测试
+function test(name, fn) {
+  tests.push({ name, fn, emulator: false });
+}
+
+// 需要刻字机模拟器的测试; 模拟器在 pty 上应答 RSVER; / RPID; / BD:n; 并在 PLT 作业结束 ('@') 时回复 JOB:<字节数>;
+// 没有模拟器的平台 (Windows) 上跳过
+function emulatorTest(name, fn) {
+  tests.push({ name, fn, emulator: true });
+}
+
+// 只在 Linux 上运行的测试 (netlink uevent、sysfs 等)
+function linuxTest(name, fn) {
+  tests.push({ name, fn, emulator: false, linux: true });
+}
+
+// 热插拔回放用的空事件文件, 这样事件回调不依赖 netlink
+const emptyUevents = path.join(os.tmpdir(), `usb-addon-uevents-${process.pid}`);
+
+function makeJob(size) {
+  const parts = ['IN;'];
+  let length = 3;
+  for (let i = 0; length < size - 4; i++) {
+    const command = `PD${i % 4000},${(i * 7) % 4000};`;
+    parts.push(command);
+    length += command.length;
+  }
+  parts.push('PG;@');
+  return Buffer.from(parts.join(''));
+}
+
+async function withDevice(options, fn) {
+  const emulator = new addon.CutterEmulator(options);
+  const device = new addon.UsbDevice();
+  try {
+    assert.strictEqual(device.connectPath(emulator.getPath()), true);
+    await fn(device, emulator);
+  } finally {
+    device.disconnect();
+    emulator.close();
+  }
+}
+
+const sendCmd = (device, text, options) => device.sendCmdAsync(Buffer.from(text), options);
+
+async function run() {
+  fs.writeFileSync(emptyUevents, '');
+  let failed = 0;
+  let skipped = 0;
+  for (const { name, fn, emulator, linux } of tests) {
+    if (emulator && !addon.CutterEmulator) {
+      skipped++;
+      console.log(`- ${name} (跳过: 当前平台没有 CutterEmulator)`);
+      continue;
+    }
+    if (linux && process.platform !== 'linux') {
+      skipped++;
+      console.log(`- ${name} (跳过: 仅 Linux)`);
+      continue;
+    }
+    try {
+      await fn();
+      console.log(`✓ ${name}`);
+    } catch (error) {
+      failed++;
+      console.log(`✗ ${name}`);
+      console.log(error);
+    }
+  }
+  fs.unlinkSync(emptyUevents);
+  console.log(`${tests.length - failed - skipped}/${tests.length} 通过${skipped ? `, ${skipped} 个跳过` : ''}`);
+  return failed;
+}
+
+module.exports = { addon, test, emulatorTest, linuxTest, emptyUevents, makeJob, withDevice, sendCmd, run };
@@ -0,0 +1,66 @@
+// netlink uevent 的解析与热插拔事件: 回放录制的事件文件 (test/fixtures/uevents-printer.txt)
+const assert = require('assert');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { addon, linuxTest } = require('./harness');
+
+const fixture = path.join(__dirname, 'fixtures', 'uevents-printer.txt');
+
+function record(action, devpath, fields) {
+  return [`${action}@${devpath}`, `ACTION=${action}`, `DEVPATH=${devpath}`, ...fields].join('\n');
+}
+
+// 回放事件文件, 返回收到的 HOTPLUG 事件; 最后一个事件是 lp3 的移除, 收到它时回放已结束
+async function replay(file) {
+  const device = new addon.UsbDevice();
+  const changes = [];
+  try {
+    await new Promise((resolve, reject) => {
+      const timer = setTimeout(() => reject(new Error(`回放超时, 已收到: ${JSON.stringify(changes)}`)), 5000);
+      device.startHotplugMonitor((type, data) => {
+        if (type !== 'HOTPLUG') {
+          return;
+        }
+        changes.push(data);
+        if (data.action === 'Remove' && data.path === '/dev/usb/lp3') {
+          clearTimeout(timer);
+          resolve();
+        }
+      }, { ueventReplay: file });
+    });
+  } finally {
+    device.stopHotplugMonitor();
+  }
+  return changes;
+}
+
+linuxTest('uevent 回放: 打印机节点的到达和移除', async () => {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'usb-addon-uevent-'));
+  const file = path.join(dir, 'uevents.txt');
+  // 找不到父接口时查设备索引; 指向空的 sysfs 目录, 结果不依赖本机的设备
+  addon.setSysfsRoot(dir);
+  try {
+    const lp9 = '/devices/pci0000:00/0000:00:14.0/usb1/1-4/1-4:1.0/usbmisc/lp9';
+    const lp3 = '/devices/pci0000:00/0000:00:14.0/usb1/1-2/1-2:1.0/usbmisc/lp3';
+    fs.writeFileSync(file, [
+      fs.readFileSync(fixture, 'utf8'),
+      // 超过接收缓冲区 (8 KiB) 的消息被截断: 最后一个字段没有结尾的 '\0', DEVNAME 丢失, 不上报
+      record('add', lp9, ['SUBSYSTEM=usbmisc', `PADDING=${'x'.repeat(9000)}`, 'DEVNAME=usb/lp9']),
+      record('remove', lp3, ['SUBSYSTEM=usbmisc', 'DEVNAME=usb/lp3']),
+    ].join('\n\n'));
+
+    assert.deepStrictEqual(await replay(file), [
+      // PRODUCT 来自之前的 usb_interface 事件 (lpN 的事件本身不带 VID/PID)
+      { vid: '1A86', pid: '7584', action: 'Arrival', path: '/dev/usb/lp0' },
+      // 父接口没有出现过, 索引中也没有
+      { vid: 'Unknown', pid: 'Unknown', action: 'Arrival', path: '/dev/usb/lp3' },
+      // 头部是 block/net 设备的 lp7/lp8 被预筛丢弃; 只有头部的 lp5 和被截断的 lp9 不上报
+      { vid: '1A86', pid: '7584', action: 'Remove', path: '/dev/usb/lp0' },
+      { vid: 'Unknown', pid: 'Unknown', action: 'Remove', path: '/dev/usb/lp3' },
+    ]);
+  } finally {
+    addon.setSysfsRoot('');
+    fs.rmSync(dir, { recursive: true, force: true });
+  }
+});
@@ -0,0 +1,60 @@
+// 准备好的 PLT 作业的磁盘缓存
+const assert = require('assert');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { addon, test, emulatorTest, emptyUevents, makeJob, withDevice } = require('./harness');
+
+test('jobCacheKey 与参数的属性顺序无关', () => {
+  const source = Buffer.from('IN;PU0,0;PD10,0;');
+  assert.strictEqual(
+    addon.jobCacheKey(source, { scale: 2, offset: { y: 1, x: 0 }, skip: undefined }),
+    addon.jobCacheKey(source, { offset: { x: 0, y: 1 }, scale: 2 }));
+  assert.notStrictEqual(addon.jobCacheKey(source, { scale: 2 }), addon.jobCacheKey(source, { scale: 3 }));
+  const circular = {};
+  circular.self = circular;
+  assert.throws(() => addon.jobCacheKey(source, circular), TypeError);
+});
+
+emulatorTest('sendCached 发送缓存的作业', () => withDevice({}, async (device, emulator) => {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'usb-addon-cache-'));
+  try {
+    addon.setJobCache({ dir, maxBytes: 600 * 1024 });
+    const source = makeJob(256 * 1024);
+    const key = addon.jobCacheKey(source, { optimize: true });
+    assert.notStrictEqual(key, addon.jobCacheKey(source, { optimize: false }));
+    assert.strictEqual(device.sendCached(key), false);
+
+    const prepared = addon.optimizePlt(source, {});
+    assert.strictEqual(addon.cacheJob(key, prepared), true);
+    assert.strictEqual(addon.hasCachedJob(key), true);
+
+    const done = new Promise((resolve, reject) => {
+      device.startHotplugMonitor((type, data) => {
+        if (type === 'PROGRESS' && data.done) {
+          resolve(data);
+        } else if (type === 'ERROR') {
+          reject(new Error(data));
+        }
+      }, { ueventReplay: emptyUevents });
+    });
+    assert.strictEqual(device.sendCached(key, { chunkSize: 8192 }), true);
+    const progress = await done;
+    device.stopHotplugMonitor();
+    assert.strictEqual(progress.bytesSent, prepared.length);
+    assert.strictEqual(emulator.getStats().bytesReceived, prepared.length);
+
+    // 超过上限时淘汰最久未使用的项, 最近写入的一项保留
+    const large = makeJob(310 * 1024);
+    addon.cacheJob(addon.jobCacheKey(makeJob(300 * 1024)), makeJob(300 * 1024));
+    addon.cacheJob(addon.jobCacheKey(large), large);
+    const stats = addon.getJobCacheStats();
+    assert.ok(stats.evictions >= 1);
+    assert.ok(stats.totalBytes <= 600 * 1024);
+    assert.strictEqual(addon.hasCachedJob(addon.jobCacheKey(large)), true);
+    assert.strictEqual(stats.hits, 1);
+    assert.strictEqual(stats.misses, 1);
+  } finally {
+    fs.rmSync(dir, { recursive: true, force: true });
+  }
+}));
@@ -0,0 +1,170 @@
+// PLT 作业: 回执、进度、文件发送、流控与调度
+const assert = require('assert');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { addon, emulatorTest, emptyUevents, makeJob, withDevice, sendCmd } = require('./harness');
+
+emulatorTest('PLT 作业回执', () => withDevice({}, async (device, emulator) => {
+  const job = makeJob(256 * 1024);
+  const reply = await device.sendPltAsync(job);
+  assert.strictEqual(reply.toString(), `JOB:${job.length};`);
+  assert.strictEqual(emulator.getStats().jobs, 1);
+  assert.strictEqual(emulator.getStats().bytesReceived, job.length);
+}));
+
+emulatorTest('带宽限制', () => withDevice({ bandwidth: 400 * 1024 }, async (device) => {
+  const job = makeJob(200 * 1024);
+  const start = process.hrtime.bigint();
+  await device.sendPltAsync(job);
+  const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+  assert.ok(seconds > 0.4, `200KB 在 400KB/s 下只用了 ${seconds.toFixed(3)}s`);
+  assert.ok(device.getStats().retries > 0);
+}));
+
+emulatorTest('sendPlt / sendPltAsync 按 chunkSize 分块写入', () => withDevice({}, async (device) => {
+  const job = makeJob(64 * 1024);
+  const writesFor = async (send) => {
+    device.resetStats();
+    const reply = await send();
+    assert.strictEqual(reply.toString(), `JOB:${job.length};`);
+    return device.getStats().write.count;
+  };
+
+  // 每次写入一个分块: 块不超过 chunkSize, 在命令边界处切分
+  const small = await writesFor(() => device.sendPltAsync(job, { chunkSize: 1024 }));
+  assert.ok(small >= job.length / 1024, `1 KiB 分块只写了 ${small} 次`);
+  assert.strictEqual(await writesFor(() => device.sendPltAsync(job, { chunkSize: job.length })), 1);
+  assert.strictEqual(await writesFor(async () => device.sendPlt(job, { chunkSize: 1024 })), small);
+  assert.throws(() => device.sendPlt(job, { chunkSize: '1024' }), TypeError);
+  assert.throws(() => device.sendPltAsync(job, { chunkSize: 0 }), RangeError);
+}));
+
+emulatorTest('startPlt 进度事件', () => withDevice({}, async (device) => {
+  const job = makeJob(512 * 1024);
+  const done = new Promise((resolve, reject) => {
+    device.startHotplugMonitor((type, data) => {
+      if (type === 'PROGRESS' && data.done) {
+        resolve(data);
+      } else if (type === 'ERROR') {
+        reject(new Error(data));
+      }
+    }, { ueventReplay: emptyUevents });
+  });
+  assert.strictEqual(device.startPlt(job, { chunkSize: 4096, progressInterval: 0 }), true);
+  const progress = await done;
+  device.stopHotplugMonitor();
+  assert.strictEqual(progress.bytesSent, job.length);
+  assert.strictEqual(progress.progress, 1);
+  assert.ok(device.getEventStats().delivered >= 1);
+}));
+
+emulatorTest('startPlt 拒绝不合法的 chunkSize / progressInterval', () => withDevice({}, async (device, emulator) => {
+  const job = makeJob(16 * 1024);
+  for (const options of [{ chunkSize: '4096' }, { chunkSize: null }, { progressInterval: '0' }]) {
+    assert.throws(() => device.startPlt(job, options), TypeError);
+  }
+  for (const options of [{ chunkSize: 0 }, { chunkSize: -1 }, { chunkSize: NaN }, { chunkSize: 2 ** 32 }, { progressInterval: -1 }]) {
+    assert.throws(() => device.startPlt(job, options), RangeError);
+  }
+  // 参数不合法的作业没有进入队列
+  await new Promise((resolve) => setTimeout(resolve, 100));
+  assert.strictEqual(emulator.getStats().bytesReceived, 0);
+  assert.strictEqual(device.cancelPlt(), 0);
+}));
+
+emulatorTest('后台作业完成前进程不退出', () => {
+  const { execFileSync } = require('child_process');
+  const addonPath = require('bindings')({ bindings: 'usb_addon', path: true });
+  const output = execFileSync(process.execPath, ['-e', `
+    const addon = require(${JSON.stringify(addonPath)});
+    const emulator = new addon.CutterEmulator({ bandwidth: 400 * 1024 });
+    const device = new addon.UsbDevice();
+    device.connectPath(emulator.getPath());
+    device.startPlt(Buffer.from('IN;' + 'PD1,1;'.repeat(30000) + '@'), { chunkSize: 4096 });
+    process.on('exit', () => console.log(device.getSendProgress()));
+  `], { encoding: 'utf8', timeout: 10000 });
+  assert.strictEqual(Number(output.trim()), 1);
+});
+
+emulatorTest('sendPltFile 从文件发送', () => withDevice({}, async (device, emulator) => {
+  const file = path.join(os.tmpdir(), `usb-addon-job-${process.pid}.plt`);
+  const job = makeJob(1024 * 1024);
+  fs.writeFileSync(file, job);
+  try {
+    const done = new Promise((resolve, reject) => {
+      device.startHotplugMonitor((type, data) => {
+        if (type === 'PROGRESS' && data.done) {
+          resolve(data);
+        } else if (type === 'ERROR') {
+          reject(new Error(data));
+        }
+      }, { ueventReplay: emptyUevents });
+    });
+    assert.strictEqual(device.sendPltFile(file, { chunkSize: 8192 }), true);
+    const progress = await done;
+    device.stopHotplugMonitor();
+    assert.strictEqual(progress.bytesSent, job.length);
+    assert.strictEqual(emulator.getStats().bytesReceived, job.length);
+    assert.throws(() => device.sendPltFile(file + '.missing'));
+  } finally {
+    fs.rmSync(file, { force: true });
+  }
+}));
+
+emulatorTest('流控按设备速度发送', () => withDevice({ bandwidth: 400 * 1024 }, async (device) => {
+  const job = makeJob(400 * 1024);
+  device.setFlowControl({ bufferSize: 16 * 1024 });
+  const done = new Promise((resolve, reject) => {
+    device.startHotplugMonitor((type, data) => {
+      if (type === 'PROGRESS' && data.done) {
+        resolve(data);
+      } else if (type === 'ERROR') {
+        reject(new Error(data));
+      }
+    }, { ueventReplay: emptyUevents });
+  });
+  const start = process.hrtime.bigint();
+  device.startPlt(job, { progressInterval: 0 });
+  await done;
+  const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+  device.stopHotplugMonitor();
+  const stats = device.getStats();
+  assert.ok(stats.pauses > 0, '没有暂停过');
+  assert.ok(stats.drainRate > 0);
+  assert.ok(seconds < 1.5, `400KB 在 400KB/s 下用了 ${seconds.toFixed(3)}s`);
+}));
+
+emulatorTest('作业进行中命令优先, 暂停与继续', () => withDevice({ bandwidth: 1024 * 1024 }, async (device, emulator) => {
+  const job = makeJob(1024 * 1024);
+  device.setFlowControl({ bufferSize: 8 * 1024 });
+  const done = new Promise((resolve, reject) => {
+    device.startHotplugMonitor((type, data) => {
+      if (type === 'PROGRESS' && data.done) {
+        resolve(data);
+      } else if (type === 'ERROR') {
+        reject(new Error(data));
+      }
+    }, { ueventReplay: emptyUevents });
+  });
+  device.startPlt(job, { chunkSize: 1024 });
+  await new Promise((resolve) => setTimeout(resolve, 100));
+
+  const start = process.hrtime.bigint();
+  assert.strictEqual((await sendCmd(device, 'RSVER;', { timeout: 1000 })).toString(), 'RSVER:EMU-1.0;');
+  const ms = Number(process.hrtime.bigint() - start) / 1e6;
+  assert.ok(ms < 100, `作业进行中查询用了 ${ms.toFixed(1)}ms`);
+
+  assert.strictEqual(device.pausePlt(), true);
+  await new Promise((resolve) => setTimeout(resolve, 100));
+  const received = emulator.getStats().bytesReceived;
+  await new Promise((resolve) => setTimeout(resolve, 100));
+  assert.strictEqual(emulator.getStats().bytesReceived, received);
+  assert.ok(received < job.length);
+  device.resumePlt();
+
+  const progress = await done;
+  device.stopHotplugMonitor();
+  assert.strictEqual(progress.bytesSent, job.length);
+  assert.strictEqual(device.cancelPlt(), 0);
+}));
@@ -0,0 +1,149 @@
+// PLT 处理工具 (optimizePlt / reorderPlt 等), 不需要设备
+const assert = require('assert');
+const { addon, test } = require('./harness');
+
+const optimize = (text, options) => addon.optimizePlt(Buffer.from(text), options || {}).toString();
+
+test('optimizePlt 去掉重复点和共线点', () => {
+  assert.strictEqual(optimize('IN;PU0,0;PD10,0;PD10,0;PD20,0;PD30,0;PD30,10;'), 'IN;PU0,0;PD30,0;PD30,10;');
+});
+
+test('optimizePlt 保留抬刀后原地落刀的点', () => {
+  assert.strictEqual(optimize('IN;PU10,10;PD10,10;PU20,20;PD20,20;'), 'IN;PU10,10;PD10,10;PU20,20;PD20,20;');
+});
+
+test('optimizePlt 不改动相对坐标 (PR) 的路径', () => {
+  assert.strictEqual(
+    optimize('IN;PU0,0;PR;PD10,0;PD10,0;PD10,0;PA;PU5,5;PD5,6;PD5,6;'),
+    'IN;PU0,0;PR;PD10,0;PD10,0;PD10,0;PA;PU5,5;PD5,6;');
+});
+
+test('optimizePlt 超出 int32 的坐标原样保留', () => {
+  assert.strictEqual(optimize('PU99999999999999999999,1;PD1,1;'), 'PU99999999999999999999,1;PD1,1;');
+});
+
+test('optimizePlt 可以只去重不合并共线点', () => {
+  assert.strictEqual(optimize('IN;PU0,0;PD10,0;PD10,0;PD20,0;', { removeCollinear: false }), 'IN;PU0,0;PD10,0;PD20,0;');
+  assert.strictEqual(optimize('IN;PU0,0;PD10,0;PD20,1;PD30,0;', { tolerance: 0 }), 'IN;PU0,0;PD10,0;PD20,1;PD30,0;');
+});
+
+test('PLT 工具拒绝不合法的数字选项', () => {
+  const plt = Buffer.from('IN;PU0,0;PD10,0;');
+  const line = [Uint8Array.from([0, 1]), Float64Array.from([0, 0, 10, 0])];
+  for (const [bad, type] of [['1', TypeError], [null, TypeError], [-1, RangeError], [NaN, RangeError], [Infinity, RangeError]]) {
+    assert.throws(() => addon.optimizePlt(plt, { tolerance: bad }), type);
+    assert.throws(() => addon.flattenCurves(...line, { tolerance: bad }), type);
+    assert.throws(() => addon.reorderPlt(plt, { twoOptPasses: bad }), type);
+    assert.throws(() => addon.reorderPlt(plt, { tileThreshold: bad }), type);
+  }
+  assert.throws(() => addon.flattenCurves(...line, { tolerance: 0 }), RangeError);
+});
+
+test('reorderPlt 重排路径减少抬刀距离', async () => {
+  const result = await addon.reorderPlt(Buffer.from('IN;PU100,0;PD110,0;PU0,0;PD10,0;PU50,0;PD60,0;'), {});
+  assert.strictEqual(result.paths, 3);
+  assert.ok(result.penUpAfter < result.penUpBefore);
+});
+
+test('reorderPlt 不重排含 PR 的作业', async () => {
+  const source = Buffer.from('IN;PU100,0;PD110,0;PR;PU-110,0;PD10,0;PU40,0;PD10,0;');
+  const result = await addon.reorderPlt(source, {});
+  assert.ok(result.data.equals(source));
+  assert.strictEqual(result.paths, 0);
+});
+
+test('flattenCurves 拒绝非有限或超出范围的坐标', () => {
+  const verbs = Uint8Array.from([0, 1]);
+  for (const bad of [NaN, Infinity, 1e12]) {
+    assert.throws(() => addon.flattenCurves(verbs, Float64Array.from([0, 0, bad, 0])), RangeError);
+  }
+  assert.strictEqual(addon.flattenCurves(verbs, Float64Array.from([0, 0, 10.4, -2.6])).toString(), 'PU0,0;PD10,-3;');
+});
+
+// 解析 flattenCurves 输出的 PU/PD 点
+const pointsOf = (plt) => [...plt.toString().matchAll(/P[UD](-?\d+),(-?\d+);/g)].map((m) => [Number(m[1]), Number(m[2])]);
+
+// 折线顶点及每段弦的中点到真实曲线 (按参数密集采样) 的最大距离
+function maxDeviation(points, curveAt) {
+  const samples = [];
+  for (let i = 0; i <= 20000; i++) {
+    samples.push(curveAt(i / 20000));
+  }
+  const distance = ([x, y]) => Math.min(...samples.map(([cx, cy]) => Math.hypot(x - cx, y - cy)));
+  let worst = 0;
+  points.forEach((point, i) => {
+    worst = Math.max(worst, distance(point));
+    if (i > 0) {
+      worst = Math.max(worst, distance([(point[0] + points[i - 1][0]) / 2, (point[1] + points[i - 1][1]) / 2]));
+    }
+  });
+  return worst;
+}
+
+// 输出坐标取整到设备单位, 每个点额外有最多 sqrt(2)/2 的舍入误差
+const flattenCases = [
+  {
+    name: '三次贝塞尔',
+    verbs: [0, 3],
+    coords: [0, 0, 1000, 3000, 3000, -2000, 4000, 1000],
+    end: [4000, 1000],
+    at: (t) => {
+      const u = 1 - t;
+      return [3 * u * u * t * 1000 + 3 * u * t * t * 3000 + t * t * t * 4000,
+        3 * u * u * t * 3000 - 3 * u * t * t * 2000 + t * t * t * 1000];
+    },
+  },
+  {
+    name: '圆弧',
+    verbs: [0, 4],
+    coords: [1000, 0, 0, 0, Math.PI * 1.5],
+    end: [0, -1000],
+    at: (t) => [1000 * Math.cos(t * Math.PI * 1.5), 1000 * Math.sin(t * Math.PI * 1.5)],
+  },
+];
+
+for (const { name, verbs, coords, end, at } of flattenCases) {
+  test(`flattenCurves 展开${name}时误差不超过 tolerance`, () => {
+    const counts = [2, 0.5, 0.25].map((tolerance) => {
+      const points = pointsOf(addon.flattenCurves(Uint8Array.from(verbs), Float64Array.from(coords), { tolerance }));
+      assert.deepStrictEqual(points[0], coords.slice(0, 2));
+      assert.deepStrictEqual(points[points.length - 1], end);
+      const worst = maxDeviation(points, at);
+      assert.ok(worst <= tolerance + Math.SQRT1_2, `tolerance ${tolerance} 时最大误差 ${worst.toFixed(3)}`);
+      return points.length;
+    });
+    // 误差要求越严, 展开的点越多
+    assert.ok(counts[0] < counts[1] && counts[1] < counts[2], `点数 ${counts}`);
+  });
+}
+
+test('buildPlt 输出负数和 int32 边界值', () => {
+  const values = [0, -1, 9, 10, -99, 100, 999999999, 1000000000, -1000000000, 2147483647, -2147483648];
+  const coords = Int32Array.from(values.flatMap((v) => [v, -v | 0]));
+  const expected = values.map((v, i) => `${i === 0 ? 'PU' : 'PD'}${v},${-v | 0};`).join('');
+  assert.strictEqual(addon.buildPlt(coords).toString(), expected);
+});
+
+test('buildPlt 按刀状态合并连续的点', () => {
+  const coords = Int32Array.from([0, 0, -5, -10, 2147483647, -2147483648, 7, 7, 8, 8, 9, -9]);
+  const pens = Uint8Array.from([0, 1, 1, 0, 0, 1]);
+  assert.strictEqual(addon.buildPlt(coords, pens).toString(),
+    'PU0,0;PD-5,-10;PD2147483647,-2147483648;PU7,7;PU8,8;PD9,-9;');
+  assert.strictEqual(addon.buildPlt(coords, pens, { mergePoints: true }).toString(),
+    'PU0,0;PD-5,-10,2147483647,-2147483648;PU7,7,8,8;PD9,-9;');
+});
+
+test('buildPlt 前后附加 prefix/suffix', () => {
+  const coords = Int32Array.from([1, 2, 3, 4]);
+  assert.strictEqual(addon.buildPlt(coords, undefined, { prefix: 'IN;', suffix: Buffer.from('PG;') }).toString(),
+    'IN;PU1,2;PD3,4;PG;');
+  assert.strictEqual(addon.buildPlt(new Int32Array(0), undefined, { prefix: 'IN;' }).toString(), 'IN;');
+  assert.throws(() => addon.buildPlt(coords, undefined, { prefix: 1 }), TypeError);
+});
+
+test('buildPlt 拒绝长度不匹配的坐标和刀状态', () => {
+  assert.throws(() => addon.buildPlt(Int32Array.from([1, 2, 3])), RangeError);
+  assert.throws(() => addon.buildPlt(Int32Array.from([1, 2, 3, 4]), Uint8Array.from([0])), RangeError);
+  assert.throws(() => addon.buildPlt(Int32Array.from([1, 2, 3, 4]), Uint8Array.from([0, 1, 1])), RangeError);
+  assert.throws(() => addon.buildPlt([1, 2]), TypeError);
+});
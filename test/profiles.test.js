@@ -0,0 +1,27 @@
+// 按 VID/PID 选用的型号配置
+const assert = require('assert');
+const { addon, emulatorTest, sendCmd } = require('./harness');
+
+emulatorTest('按 VID/PID 选用型号配置', async () => {
+  addon.registerDeviceProfile({ vendorId: 0x1234, productId: 0x0001, name: 'test', chunkSize: 512, commandTimeout: 300 });
+  assert.ok(addon.listDeviceProfiles().some((profile) => profile.name === 'GNS'));
+
+  const emulator = new addon.CutterEmulator({});
+  const device = new addon.UsbDevice();
+  try {
+    assert.strictEqual(device.connectPath(emulator.getPath(), { vendorId: 0x1234, productId: 0x0001 }), true);
+    const profile = device.getProfile();
+    assert.strictEqual(profile.name, 'test');
+    assert.strictEqual(profile.chunkSize, 512);
+    assert.strictEqual(device.setTimeouts().command, 300);
+    device.disconnect();
+
+    // 没有结束符的型号: 命令取收到的第一段数据
+    assert.strictEqual(device.connectPath(emulator.getPath(), { vendorId: 0x0483, productId: 0x5448 }), true);
+    assert.strictEqual(device.getProfile().terminator, '');
+    assert.strictEqual((await sendCmd(device, 'RPID;')).toString(), 'RPID:5750;');
+  } finally {
+    device.disconnect();
+    emulator.close();
+  }
+});
@@ -0,0 +1,58 @@
+// 设备移除后的重连与续传
+const assert = require('assert');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { addon, emulatorTest, emptyUevents, makeJob } = require('./harness');
+
+emulatorTest('设备移除后自动重连并续传', async () => {
+  // 通过符号链接连接, 模拟器关闭后换一个新的模拟器接到同一路径上, 相当于设备复位后重新出现
+  const link = path.join(os.tmpdir(), `usb-addon-lp-${process.pid}`);
+  let emulator = new addon.CutterEmulator({ bandwidth: 1024 * 1024 });
+  fs.rmSync(link, { force: true });
+  fs.symlinkSync(emulator.getPath(), link);
+  const device = new addon.UsbDevice();
+  const changes = [];
+  try {
+    assert.strictEqual(device.connectPath(link), true);
+    device.setAutoReconnect({ timeout: 5000, interval: 20 });
+    const job = makeJob(1024 * 1024);
+    const done = new Promise((resolve, reject) => {
+      device.startHotplugMonitor((type, data) => {
+        if (type === 'DISCONNECTED' || type === 'RECONNECTED') {
+          changes.push(type);
+        } else if (type === 'PROGRESS' && data.done) {
+          resolve(data);
+        } else if (type === 'ERROR') {
+          reject(new Error(data));
+        }
+      }, { ueventReplay: emptyUevents });
+    });
+    device.startPlt(job, { chunkSize: 4096, progressInterval: 0 });
+    await new Promise((resolve) => setTimeout(resolve, 200));
+
+    const before = emulator.getStats().bytesReceived;
+    emulator.close();
+    for (let i = 0; i < 100 && device.isConnected(); i++) {
+      await new Promise((resolve) => setTimeout(resolve, 10));
+    }
+    assert.strictEqual(device.isConnected(), false);
+
+    emulator = new addon.CutterEmulator({});
+    fs.rmSync(link, { force: true });
+    fs.symlinkSync(emulator.getPath(), link);
+
+    const progress = await done;
+    device.stopHotplugMonitor();
+    assert.strictEqual(progress.bytesSent, job.length);
+    assert.deepStrictEqual(changes, ['DISCONNECTED', 'RECONNECTED']);
+    assert.strictEqual(device.isConnected(), true);
+    const after = emulator.getStats();
+    assert.strictEqual(after.jobs, 1);
+    assert.ok(after.bytesReceived > 0 && after.bytesReceived <= job.length - before + 4096);
+  } finally {
+    device.disconnect();
+    emulator.close();
+    fs.rmSync(link, { force: true });
+  }
+});
@@ -0,0 +1,17 @@
+// 运行 test/ 下的所有 *.test.js: npm test
+// 只运行部分文件: npm test -- commands plt-tools
+const fs = require('fs');
+const path = require('path');
+const { run } = require('./harness');
+
+const filters = process.argv.slice(2);
+const files = fs.readdirSync(__dirname)
+  .filter((file) => file.endsWith('.test.js'))
+  .filter((file) => filters.length === 0 || filters.some((filter) => file.includes(filter)))
+  .sort();
+
+for (const file of files) {
+  require(path.join(__dirname, file));
+}
+
+run().then((failed) => process.exit(failed ? 1 : 0));
@@ -0,0 +1,29 @@
+// 跟踪文件的记录与回放
+const assert = require('assert');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { addon, emulatorTest, makeJob, withDevice, sendCmd } = require('./harness');
+
+emulatorTest('记录与回放', () => withDevice({}, async (device, emulator) => {
+  const file = path.join(os.tmpdir(), `usb-addon-trace-${process.pid}`);
+  const job = makeJob(64 * 1024);
+  try {
+    assert.strictEqual(device.startCapture(file, { size: 1024 * 1024 }), true);
+    await sendCmd(device, 'RSVER;');
+    await device.sendPltAsync(job);
+    assert.ok(device.stopCapture() >= 3);
+
+    const trace = addon.readTrace(file);
+    const written = trace.records.filter((record) => record.direction === 'out');
+    assert.strictEqual(Buffer.concat(written.map((record) => record.data)).toString(), 'RSVER;' + job.toString());
+    assert.ok(trace.records.some((record) => record.direction === 'in' && record.data.toString() === 'RSVER:EMU-1.0;'));
+
+    const jobs = emulator.getStats().jobs;
+    const result = await addon.replayTrace(file, emulator.getPath(), { speed: 0 });
+    assert.strictEqual(result.bytesOut, 6 + job.length);
+    assert.strictEqual(emulator.getStats().jobs, jobs + 1);
+  } finally {
+    fs.rmSync(file, { force: true });
+  }
+}));